@@ -4,9 +4,8 @@
 #include <vector>
 #include <string>
 #include <stack>
-#include "../backend/d3d11/d3d11_context.h"
-#include "../core/context.h"
-#include "../core/types.h"
+#include "../backend/d3d11/d3d11_renderer.h"
+#include "../core/draw_types.h"
 #include "../resources/font.h"
 #include "../utils/logger.h"
 #define STB_IMAGE_IMPLEMENTATION
@@ -47,21 +46,24 @@ int main() {
     ShowWindow(hwnd, SW_SHOW);
     UpdateWindow(hwnd);
 
-    // create context
-    d3d11_context context;
-    context.initialize(1280, 720, hwnd);
+    // create renderer
+    d3d11_renderer renderer;
+    renderer.initialize(1280, 720, hwnd);
 
-    // load fonts (now context is available)
+    // load fonts (now the device is available)
     // auto consola = std::make_shared<resources::font>("C:\\Windows\\Fonts\\consola.ttf", 32.f);
     // auto trebuchetMS = std::make_shared<resources::font>("resources\\fonts\\trebuchetMS.ttf", 32.f);
     auto notoSans = std::make_shared<resources::font>("resources\\fonts\\NotoSans-VariableFont_wdth,wght.ttf", 32.f);
     auto notoSansSC = std::make_shared<resources::font>("resources\\fonts\\NotoSansSC-VariableFont_wght.ttf", 32.f);
+    // latin text and its cjk fallback glyphs pack onto the same pages and draw as one command
+    notoSans->set_atlas(resources::glyph_atlas::shared());
+    notoSansSC->set_atlas(resources::glyph_atlas::shared());
 
     // load fonts with texture dictionary
-    // consola->load(context.device(), context.texture_dict());
-    // trebuchetMS->load(context.device(), context.texture_dict());
-    notoSans->load(context.device(), context.texture_dict());
-    notoSansSC->load(context.device(), context.texture_dict());
+    // consola->load(renderer.device(), renderer.texture_dict());
+    // trebuchetMS->load(renderer.device(), renderer.texture_dict());
+    notoSans->load(renderer.device(), renderer.texture_dict());
+    notoSansSC->load(renderer.device(), renderer.texture_dict());
     
     // set up fallback font chain
     notoSans->add_fallback(notoSansSC);
@@ -70,7 +72,7 @@ int main() {
     
     // set default fallback for any font that doesn't have specific fallbacks
     auto default_fallback = std::make_shared<resources::font>("C:\\Windows\\Fonts\\arial.ttf", 32.f);
-    default_fallback->load(context.device(), context.texture_dict());
+    default_fallback->load(renderer.device(), renderer.texture_dict());
     
     notoSansSC->set_default_fallback(default_fallback);
     notoSans->set_default_fallback(default_fallback);
@@ -81,7 +83,7 @@ int main() {
     // reduce noisy debug by default
     utils::set_debug_logging(false);
 
-    auto* tex_dict = context.texture_dict();
+    auto* tex_dict = renderer.texture_dict();
     // we'll create the texture after loading the image to get the correct dimensions
     resources::tex tex = nullptr;    
 
@@ -96,15 +98,15 @@ int main() {
     tex_dict->set_texture_data(tex, image_data, width, height);
     stbi_image_free(image_data);
     
-    tex_dict->process_update_queue(context.context());
+    tex_dict->process_update_queue(renderer.context());
 
     bool regular = true;
     bool rounded = false;
     bool blur = false;
 
     // create draw manager and unified buffer
-    auto* draw_mgr = context.resource_manager();
-    size_t unified_buffer_id = draw_mgr->register_buffer(0);
+    auto* draw_mgr = renderer.draw_manager();
+    core::buffer_id unified_buffer_id = draw_mgr->register_buffer(0);
     auto* unified_buf = draw_mgr->get_buffer(unified_buffer_id);
 
     MSG msg = {};
@@ -214,18 +216,14 @@ int main() {
         // unified_buf->text("Trebuchet MS font with fallbacks", {100, 700}, core::pack_color_abgr({0.5f, 1, 0.5f, 1}));
         // unified_buf->pop_font();
         
-        context.begin_frame();
-        context.clear(core::color{0.1f, 0.2f, 0.3f, 1.0f});
+        renderer.begin_frame();
+        renderer.clear(core::color{0.1f, 0.2f, 0.3f, 1.0f});
         
-        // draw unified buffer (handles all geometry types automatically)
-        if (unified_buf && !unified_buf->vertices.empty() && !unified_buf->indices.empty()) {
-            // utils::log_info("Rendering unified buffer: %zu commands, %zu vertices, %zu indices", 
-            //                unified_buf->command_count(), unified_buf->total_vertex_count(), unified_buf->total_index_count());
-            context.buffer(unified_buf);
-        } else {
-            utils::log_warn("Unified buffer empty: buf=%p, vertices=%zu, indices=%zu", 
-                   unified_buf, unified_buf ? unified_buf->vertices.size() : 0, unified_buf ? unified_buf->indices.size() : 0);
+        // draw every registered buffer (handles all geometry types automatically)
+        if (unified_buf->vertices.empty() || unified_buf->indices.empty()) {
+            utils::log_warn("Unified buffer empty: vertices=%zu, indices=%zu", unified_buf->vertices.size(), unified_buf->indices.size());
         }
+        draw_mgr->draw(renderer);
         
         
         // demonstrate RAII texture management
@@ -244,20 +242,20 @@ int main() {
         
         
         // test normal shader loading
-        // context.set_pixel_shader("generic");
+        // renderer.set_pixel_shader("generic");
         // utils::log_info("Set generic shader successfully");
         
         // test color-only shader
-        // context.set_pixel_shader("color_only");
+        // renderer.set_pixel_shader("color_only");
         // utils::log_info("Set color_only shader successfully");
         
         
         // memory tracking and leak detection
-        // if (context.texture_dict()) {
-        //     context.texture_dict()->log_memory_stats();
+        // if (renderer.texture_dict()) {
+        //     renderer.texture_dict()->log_memory_stats();
         // }
         
-        context.end_frame();
+        renderer.end_frame();
     }
     return 0;
 }
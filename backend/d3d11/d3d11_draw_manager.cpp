@@ -1,6 +1,9 @@
 #include "d3d11_draw_manager.h"
 #include "../../core/draw_buffer.h"
+#include "../../core/frame_merge.h"
+#include "../../core/renderer.h"
 #include "../../resources/font.h"
+#include "../../utils/profiler.h"
 #include <algorithm>
 #include <cassert>
 
@@ -17,127 +20,50 @@ void d3d11_draw_manager::init() {
     // initialize any required resources
 }
 
-size_t d3d11_draw_manager::register_buffer(size_t init_priority) {
+core::buffer_id d3d11_draw_manager::register_buffer(size_t init_priority) {
     std::lock_guard<std::mutex> lock(_list_mutex);
-    
-    buffer_node node;
-    node.active_buffer = std::make_unique<core::draw_buffer>();
-    node.priority = init_priority;
-    
-    size_t index = _buffer_list.size();
-    _buffer_list.push_back(std::move(node));
-    _priorities.push_back({init_priority, index});
-    
-    // sort priorities
-    std::sort(_priorities.begin(), _priorities.end());
-    
-    return index;
+    return _buffers.add(init_priority);
 }
 
-size_t d3d11_draw_manager::register_child_buffer(size_t parent, size_t priority) {
+core::buffer_id d3d11_draw_manager::register_child_buffer(core::buffer_id parent, size_t priority) {
     std::lock_guard<std::mutex> lock(_list_mutex);
-    
-    if (parent >= _buffer_list.size()) return SIZE_MAX;
-    
-    size_t child_index = register_buffer(priority);
-    if (child_index != SIZE_MAX) {
-        _buffer_list[parent].child_buffers.push_back({priority, child_index});
-        std::sort(_buffer_list[parent].child_buffers.begin(), _buffer_list[parent].child_buffers.end());
-    }
-    
-    return child_index;
+    return _buffers.add(priority, parent);
 }
 
-void d3d11_draw_manager::update_child_priority(size_t child_idx, size_t new_priority) {
-    std::lock_guard<std::mutex> lock(_list_mutex);
-    
-    if (child_idx >= _buffer_list.size()) return;
-    
-    // find parent
-    for (auto& node : _buffer_list) {
-        auto it = std::find_if(node.child_buffers.begin(), node.child_buffers.end(),
-            [child_idx](const auto& pair) { return pair.second == child_idx; });
-        
-        if (it != node.child_buffers.end()) {
-            it->first = new_priority;
-            std::sort(node.child_buffers.begin(), node.child_buffers.end());
-            break;
-        }
-    }
-    
-    // update main priority list
-    auto it = std::find_if(_priorities.begin(), _priorities.end(),
-        [child_idx](const auto& pair) { return pair.second == child_idx; });
-    
-    if (it != _priorities.end()) {
-        it->first = new_priority;
-        std::sort(_priorities.begin(), _priorities.end());
-    }
+void d3d11_draw_manager::update_child_priority(core::buffer_id child, size_t new_priority) {
+    // children are ordered among their siblings like any other buffer
+    update_buffer_priority(child, new_priority);
 }
 
-void d3d11_draw_manager::update_buffer_priority(size_t buffer_idx, size_t new_priority) {
+void d3d11_draw_manager::update_buffer_priority(core::buffer_id buffer, size_t new_priority) {
     std::lock_guard<std::mutex> lock(_list_mutex);
-    
-    if (buffer_idx >= _buffer_list.size()) return;
-    
-    _buffer_list[buffer_idx].priority = new_priority;
-    
-    auto it = std::find_if(_priorities.begin(), _priorities.end(),
-        [buffer_idx](const auto& pair) { return pair.second == buffer_idx; });
-    
-    if (it != _priorities.end()) {
-        it->first = new_priority;
-        std::sort(_priorities.begin(), _priorities.end());
-    }
+    _buffers.set_priority(buffer, new_priority);
 }
 
-void d3d11_draw_manager::remove_buffer(size_t idx) {
+void d3d11_draw_manager::remove_buffer(core::buffer_id buffer) {
     std::lock_guard<std::mutex> lock(_list_mutex);
-    remove_buffer_recursive(idx);
+    _buffers.remove(buffer);
 }
 
-void d3d11_draw_manager::remove_buffer_recursive(size_t idx) {
-    if (idx >= _buffer_list.size()) return;
-    
-    // remove all children first
-    auto& node = _buffer_list[idx];
-    for (const auto& child : node.child_buffers) {
-        remove_buffer_recursive(child.second);
-    }
-    
-    // remove from priorities
-    _priorities.erase(std::remove_if(_priorities.begin(), _priorities.end(),
-        [idx](const auto& pair) { return pair.second == idx; }), _priorities.end());
-    
-    // remove from buffer list
-    _buffer_list.erase(_buffer_list.begin() + idx);
-    
-    // update indices in priorities and child buffers
-    for (auto& pair : _priorities) {
-        if (pair.second > idx) pair.second--;
-    }
-    
-    for (auto& node : _buffer_list) {
-        for (auto& child : node.child_buffers) {
-            if (child.second > idx) child.second--;
-        }
-    }
-}
-
-core::draw_buffer* d3d11_draw_manager::get_buffer(size_t idx) {
+core::draw_buffer* d3d11_draw_manager::get_buffer(core::buffer_id buffer) {
+    // the buffer is read by draw() without a copy, so only the thread that
+    // draws may fill it; other threads submit()
+    assert(std::this_thread::get_id() == _render_thread && "get_buffer from a thread other than the render thread");
     std::lock_guard<std::mutex> lock(_list_mutex);
-    
-    if (idx >= _buffer_list.size()) return nullptr;
-    return _buffer_list[idx].active_buffer.get();
+    auto* slot = _buffers.get(buffer);
+    return slot ? &slot->buffer : nullptr;
 }
 
-void d3d11_draw_manager::swap_buffers(size_t idx) {
+void d3d11_draw_manager::swap_buffers(core::buffer_id buffer) {
     std::lock_guard<std::mutex> lock(_list_mutex);
     
-    if (idx >= _buffer_list.size()) return;
-    
     // swap active buffer with a new one
-    _buffer_list[idx].active_buffer = std::make_unique<core::draw_buffer>();
+    _buffers.reset(buffer);
+    _frame.invalidate(buffer);
+}
+
+void d3d11_draw_manager::submit(core::buffer_id buffer, core::frame_packet packet) {
+    if (packet) _submissions.push({buffer, std::move(packet)});
 }
 
 resources::font* d3d11_draw_manager::add_font(const char* file, float size, bool italic, bool bold, int rasterizer_flags) {
@@ -170,61 +96,33 @@ void d3d11_draw_manager::remove_font(const resources::font* font_ptr) {
     }
 }
 
-void d3d11_draw_manager::update_matrix_translate(size_t buffer, const core::position& xy_translate, size_t cmd_idx) {
+void d3d11_draw_manager::update_matrix_translate(core::buffer_id buffer, const core::position& xy_translate, size_t cmd_idx) {
     std::lock_guard<std::mutex> lock(_list_mutex);
     
-    if (buffer >= _buffer_list.size()) return;
-    if (cmd_idx >= _buffer_list[buffer].active_buffer->cmds.size()) return;
+    auto* slot = _buffers.get(buffer);
+    if (!slot || cmd_idx >= slot->buffer.cmds.size()) return;
     
     // update the command's matrix transform
     // this would need matrix support in draw_command
 }
 
-void d3d11_draw_manager::draw() {
+void d3d11_draw_manager::draw(core::renderer& renderer) {
+    FV_PROFILE_SCOPE("d3d11_draw_manager::draw");
+    assert(std::this_thread::get_id() == _render_thread && "draw from a thread other than the render thread");
     std::lock_guard<std::mutex> lock(_list_mutex);
     
-    // calculate total vertex and index counts
-    uint32_t total_vertices = 0;
-    uint32_t total_indices = 0;
-    
-    for (const auto& priority_pair : _priorities) {
-        const auto& node = _buffer_list[priority_pair.second];
-        auto [vtx_count, idx_count] = node.active_buffer->vtx_idx_count();
-        total_vertices += vtx_count;
-        total_indices += idx_count;
-        
-        // also count children
-        for (const auto& child : node.child_buffers) {
-            const auto& child_node = _buffer_list[child.second];
-            auto [child_vtx, child_idx] = child_node.active_buffer->vtx_idx_count();
-            total_vertices += child_vtx;
-            total_indices += child_idx;
+    // the latest packet of each buffer wins; those of removed buffers are dropped
+    while (auto s = _submissions.pop()) {
+        if (auto* slot = _buffers.get(s->buffer)) {
+            slot->submitted = std::move(s->packet);
+            _frame.invalidate(s->buffer);
         }
     }
     
-    if (total_vertices == 0 || total_indices == 0) {
-        return;
-    }
-    
-    // render all buffers in priority order
-    for (const auto& priority_pair : _priorities) {
-        const auto& node = _buffer_list[priority_pair.second];
-        
-        // render main buffer
-        if (node.active_buffer && !node.active_buffer->vertices.empty() && !node.active_buffer->indices.empty()) {
-            // we need access to the renderer to call draw_buffer
-            // for now, we'll need to pass the renderer reference or implement rendering here
-            // this is a temporary solution - ideally the draw_manager should have access to the renderer
-        }
-        
-        // render child buffers
-        for (const auto& child : node.child_buffers) {
-            const auto& child_node = _buffer_list[child.second];
-            if (child_node.active_buffer && !child_node.active_buffer->vertices.empty() && !child_node.active_buffer->indices.empty()) {
-                // same issue as above
-            }
-        }
-    }
+    _buffers.for_each([&](core::buffer_id id, const buffer_slot& slot) {
+        _frame.add(id, slot.submitted ? *slot.submitted : slot.buffer);
+    });
+    _frame.draw(renderer);
 }
 
 } // namespace backend::d3d11 
\ No newline at end of file
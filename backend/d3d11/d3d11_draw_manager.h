@@ -4,15 +4,22 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include "../../core/draw_buffer.h"
 #include "../../core/draw_manager.h"
+#include "../../core/frame_merge.h"
+#include "../../utils/mpsc_queue.h"
+
+namespace core { class renderer; }
 
 namespace backend::d3d11 {
 
-struct buffer_node {
-    std::unique_ptr<core::draw_buffer> active_buffer;
-    std::vector<std::pair<size_t, size_t>> child_buffers; // priority, index
-    size_t priority;
+// a registered buffer: filled in place through get_buffer, or replaced as a
+// whole by submitted packets, which are drawn instead once there is one
+struct buffer_slot {
+    core::draw_buffer buffer;
+    core::frame_packet submitted;
 };
 
 class d3d11_draw_manager : public core::draw_manager {
@@ -21,41 +28,56 @@ public:
     ~d3d11_draw_manager() override;
 
     // buffer management
-    size_t register_buffer(size_t init_priority) override;
-    size_t register_child_buffer(size_t parent, size_t priority) override;
-    void update_child_priority(size_t child_idx, size_t new_priority) override;
-    void update_buffer_priority(size_t buffer_idx, size_t new_priority) override;
-    void remove_buffer(size_t idx) override;
-    core::draw_buffer* get_buffer(size_t idx) override;
-    void swap_buffers(size_t idx) override;
+    core::buffer_id register_buffer(size_t init_priority) override;
+    core::buffer_id register_child_buffer(core::buffer_id parent, size_t priority) override;
+    void update_child_priority(core::buffer_id child, size_t new_priority) override;
+    void update_buffer_priority(core::buffer_id buffer, size_t new_priority) override;
+    void remove_buffer(core::buffer_id buffer) override;
+    core::draw_buffer* get_buffer(core::buffer_id buffer) override;
+    void swap_buffers(core::buffer_id buffer) override;
+
+    // submission
+    using core::draw_manager::submit;
+    void submit(core::buffer_id buffer, core::frame_packet packet) override;
     
     // font management
     resources::font* add_font(const char* file, float size, bool italic, bool bold, int rasterizer_flags) override;
     void remove_font(const resources::font* font_ptr) override;
     
     // matrix operations
-    void update_matrix_translate(size_t buffer, const core::position& xy_translate, size_t cmd_idx) override;
+    void update_matrix_translate(core::buffer_id buffer, const core::position& xy_translate, size_t cmd_idx) override;
     
     // initialization
     void init() override;
 
-    // rendering
-    void draw();
+    // rendering: takes the packets submitted since the last call, then draws
+    // every buffer with geometry, in priority order and children after their
+    // parent, through a frame_builder: dynamic buffers are merged into as few
+    // uploads as possible, frozen ones drawn from the copy the renderer keeps.
+    // render thread only
+    void draw(core::renderer& renderer);
 
 private:
     Microsoft::WRL::ComPtr<ID3D11Device> _device;
     Microsoft::WRL::ComPtr<ID3D11DeviceContext> _context;
     
-    std::vector<buffer_node> _buffer_list;
-    std::vector<std::pair<size_t, size_t>> _priorities; // priority, index
+    core::buffer_registry<buffer_slot> _buffers;
     std::mutex _list_mutex;
+    // the thread that created the manager draws it; get_buffer is for it alone
+    std::thread::id _render_thread = std::this_thread::get_id();
+    
+    // packets on their way to the render thread; producers never take _list_mutex
+    struct submission {
+        core::buffer_id buffer;
+        core::frame_packet packet;
+    };
+    utils::mpsc_queue<submission> _submissions;
+    
+    core::frame_builder _frame;
     
     // font management
     std::unordered_map<std::string, std::unique_ptr<resources::font>> _fonts;
     std::mutex _font_mutex;
-    
-    void rebuild_priorities();
-    void remove_buffer_recursive(size_t idx);
 };
 
 } // namespace backend::d3d11 
\ No newline at end of file
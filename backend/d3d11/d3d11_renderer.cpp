@@ -1,7 +1,9 @@
 #include "d3d11_renderer.h"
+#include "../../core/frame_capture.h"
 #include <cassert>
 #include <fstream>
 #include "../../utils/logger.h"
+#include "../../utils/profiler.h"
 #include <d3d11.h>
 
 namespace backend::d3d11 {
@@ -59,6 +61,9 @@ void d3d11_renderer::initialize(int width, int height, HWND hwnd) {
     auto vs_blob = load_shader_blob("resources/shaders/vertex/generic.cso");
     auto ps_blob = load_shader_blob("resources/shaders/pixel/generic.cso");
     auto ps_color_blob = load_shader_blob("resources/shaders/pixel/color_only.cso");
+    auto ps_font_blob = load_shader_blob("resources/shaders/pixel/font.cso");
+    auto ps_sdf_blob = load_shader_blob("resources/shaders/pixel/sdf.cso");
+    auto ps_msdf_blob = load_shader_blob("resources/shaders/pixel/msdf.cso");
     auto vs_fallback_blob = load_shader_blob("resources/shaders/vertex/fallback.cso");
     auto ps_fallback_blob = load_shader_blob("resources/shaders/pixel/fallback.cso");
     
@@ -83,6 +88,27 @@ void d3d11_renderer::initialize(int width, int height, HWND hwnd) {
         return;
     }
     
+    // create font coverage pixel shader (r8 atlas pages)
+    hr = _device->CreatePixelShader(ps_font_blob.data(), ps_font_blob.size(), nullptr, &_ps_font);
+    if (FAILED(hr)) {
+        utils::log_error("CreatePixelShader (font) failed: 0x%08X", hr);
+        return;
+    }
+    
+    // create distance field pixel shader (sdf fonts)
+    hr = _device->CreatePixelShader(ps_sdf_blob.data(), ps_sdf_blob.size(), nullptr, &_ps_sdf);
+    if (FAILED(hr)) {
+        utils::log_error("CreatePixelShader (sdf) failed: 0x%08X", hr);
+        return;
+    }
+    
+    // create multi-channel distance field pixel shader (msdf fonts)
+    hr = _device->CreatePixelShader(ps_msdf_blob.data(), ps_msdf_blob.size(), nullptr, &_ps_msdf);
+    if (FAILED(hr)) {
+        utils::log_error("CreatePixelShader (msdf) failed: 0x%08X", hr);
+        return;
+    }
+    
     // create fallback shaders (these should always work)
     if (!vs_fallback_blob.empty()) {
         hr = _device->CreateVertexShader(vs_fallback_blob.data(), vs_fallback_blob.size(), nullptr, &_vs_fallback);
@@ -196,89 +222,172 @@ void d3d11_renderer::begin_frame() {
         utils::log_error("Map matrix buffer failed: 0x%08X", hr);
     }
     _context->VSSetConstantBuffers(0, 1, _matrix_cb.GetAddressOf());
+    _stats.begin_frame();
+    if (SUCCEEDED(hr)) _stats.stats().uploaded_bytes(core::render_stats::upload::constants) += sizeof(float) * 16;
+    if (_capture) _capture->begin_frame();
 }
 
 void d3d11_renderer::end_frame() {
-    _swapchain->Present(1, 0);
+    if (_capture) _capture->end_frame();
+    {
+        FV_PROFILE_SCOPE("d3d11_renderer::present");
+        _swapchain->Present(1, 0);
+    }
     if (_tex_dict) _tex_dict->process_update_queue(_context.Get());
+    _stats.end_frame(_tex_dict.get());
+    FV_PROFILE_FRAME();
 }
 
-void d3d11_renderer::draw_buffer(const core::draw_buffer* buf) {
-    if (!buf || buf->vertices.empty() || buf->indices.empty()) {
-        utils::log_warn("draw_buffer: buffer is empty or invalid");
-        return;
-    }
-
-    // Create single vertex and index buffer for all geometry
+bool d3d11_renderer::create_geometry(const core::draw_buffer& buf, bool immutable,
+                                     Microsoft::WRL::ComPtr<ID3D11Buffer>& vbo, Microsoft::WRL::ComPtr<ID3D11Buffer>& ibo) {
     D3D11_BUFFER_DESC vbDesc = {};
-    vbDesc.Usage = D3D11_USAGE_DYNAMIC;
-    vbDesc.ByteWidth = UINT(buf->vertices.size() * sizeof(core::vertex));
+    vbDesc.Usage = immutable ? D3D11_USAGE_IMMUTABLE : D3D11_USAGE_DYNAMIC;
+    vbDesc.ByteWidth = UINT(buf.vertices.size() * sizeof(core::vertex));
     vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    vbDesc.CPUAccessFlags = immutable ? 0 : D3D11_CPU_ACCESS_WRITE;
 
     D3D11_SUBRESOURCE_DATA vbData = {};
-    vbData.pSysMem = buf->vertices.data();
+    vbData.pSysMem = buf.vertices.data();
 
-    Microsoft::WRL::ComPtr<ID3D11Buffer> vbo;
     HRESULT hr = _device->CreateBuffer(&vbDesc, &vbData, &vbo);
     if (FAILED(hr)) {
         utils::log_error("CreateBuffer (vertex) failed: 0x%08X", hr);
-        return;
+        return false;
     }
 
     D3D11_BUFFER_DESC ibDesc = {};
-    ibDesc.Usage = D3D11_USAGE_DYNAMIC;
-    ibDesc.ByteWidth = UINT(buf->indices.size() * sizeof(uint32_t));
+    ibDesc.Usage = immutable ? D3D11_USAGE_IMMUTABLE : D3D11_USAGE_DYNAMIC;
+    ibDesc.ByteWidth = UINT(buf.indices.size() * sizeof(uint32_t));
     ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    ibDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    ibDesc.CPUAccessFlags = immutable ? 0 : D3D11_CPU_ACCESS_WRITE;
 
     D3D11_SUBRESOURCE_DATA ibData = {};
-    ibData.pSysMem = buf->indices.data();
+    ibData.pSysMem = buf.indices.data();
 
-    Microsoft::WRL::ComPtr<ID3D11Buffer> ibo;
     hr = _device->CreateBuffer(&ibDesc, &ibData, &ibo);
     if (FAILED(hr)) {
         utils::log_error("CreateBuffer (index) failed: 0x%08X", hr);
+        return false;
+    }
+    auto& stats = _stats.stats();
+    stats.buffer_allocations += 2;
+    stats.uploaded_bytes(core::render_stats::upload::vertices) += vbDesc.ByteWidth;
+    stats.uploaded_bytes(core::render_stats::upload::indices) += ibDesc.ByteWidth;
+    return true;
+}
+
+void d3d11_renderer::draw_buffer(const core::draw_buffer* buf) {
+    FV_PROFILE_SCOPE("d3d11_renderer::draw_buffer");
+    if (!buf || buf->vertices.empty() || buf->indices.empty()) {
+        utils::log_warn("draw_buffer: buffer is empty or invalid");
         return;
     }
 
+    // Create single vertex and index buffer for all geometry
+    Microsoft::WRL::ComPtr<ID3D11Buffer> vbo;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> ibo;
+    if (!create_geometry(*buf, false, vbo, ibo)) return;
+    draw_geometry(buf, vbo.Get(), ibo.Get());
+}
+
+void d3d11_renderer::draw_retained(uint64_t key, const core::draw_buffer* buf) {
+    FV_PROFILE_SCOPE("d3d11_renderer::draw_retained");
+    if (!buf || buf->vertices.empty() || buf->indices.empty()) {
+        utils::log_warn("draw_retained: buffer is empty or invalid");
+        return;
+    }
+
+    // the geometry never changes under a key, so it lives in immutable buffers
+    auto it = _retained.find(key);
+    if (it == _retained.end()) {
+        retained_geometry geometry;
+        if (!create_geometry(*buf, true, geometry.vbo, geometry.ibo)) return;
+        it = _retained.emplace(key, std::move(geometry)).first;
+    }
+    ++_stats.stats().retained_buffers;
+    draw_geometry(buf, it->second.vbo.Get(), it->second.ibo.Get());
+}
+
+void d3d11_renderer::release_retained(uint64_t key) {
+    _retained.erase(key);
+}
+
+void d3d11_renderer::draw_geometry(const core::draw_buffer* buf, ID3D11Buffer* vbo, ID3D11Buffer* ibo) {
+    _stats.count_buffer(*buf);
+    auto& stats = _stats.stats();
+
+    // upload glyphs packed while recording before any command samples the atlas;
+    // atlases only send their dirty rectangles, so this is free when nothing changed
+    const resources::glyph_atlas* last_atlas = nullptr;
+    for (const auto& cmd : buf->cmds) {
+        if (cmd.type != core::geometry_type::font_atlas || !cmd.font || cmd.font->atlas().get() == last_atlas) continue;
+        last_atlas = cmd.font->atlas().get();
+        cmd.font->flush_atlas();
+        _stats.use_atlas(*cmd.font->atlas());
+    }
+    if (_tex_dict) _tex_dict->process_update_queue(_context.Get());
+    // atlas pages are current now, as the commands will sample them
+    if (_capture) _capture->record(*buf);
+
     // Set common state
     _context->IASetInputLayout(_input_layout.Get());
     UINT stride = sizeof(core::vertex);
     UINT offset = 0;
-    _context->IASetVertexBuffers(0, 1, vbo.GetAddressOf(), &stride, &offset);
-    _context->IASetIndexBuffer(ibo.Get(), DXGI_FORMAT_R32_UINT, 0);
+    _context->IASetVertexBuffers(0, 1, &vbo, &stride, &offset);
+    _context->IASetIndexBuffer(ibo, DXGI_FORMAT_R32_UINT, 0);
     _context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     _context->PSSetSamplers(0, 1, _sampler.GetAddressOf());
+    _context->VSSetShader(_vs.Get(), nullptr, 0);
 
+    // shaders and textures are only set when they change, and commands
+    // continuing the previous one's indices with the same state (e.g. the
+    // buffers of a merged frame) go out in the same draw call
+    ID3D11PixelShader* bound_ps = nullptr;
+    ID3D11ShaderResourceView* bound_srv = nullptr;
     size_t index_offset = 0;
+    size_t draw_start = 0;
+    size_t draw_count = 0;
+    auto flush_draw = [&]() {
+        if (draw_count == 0) return;
+        _context->DrawIndexed(static_cast<UINT>(draw_count), static_cast<UINT>(draw_start), 0);
+        ++stats.draw_calls;
+        draw_count = 0;
+    };
     for (const auto& cmd : buf->cmds) {
         if (cmd.elem_count == 0) continue;
+        // the atlas evicted glyphs this command samples after it was recorded
+        // (a retained buffer); their space may hold other glyphs by now
+        if (cmd.type == core::geometry_type::font_atlas && cmd.font && !cmd.font->atlas_valid_since(cmd.font_frame, cmd.atlas_page)) {
+            index_offset += cmd.elem_count;
+            continue;
+        }
 
         // Set shader based on command type
+        ID3D11PixelShader* ps = _ps.Get();
         switch (cmd.type) {
             case core::geometry_type::color_only:
-                _context->VSSetShader(_vs.Get(), nullptr, 0);
-                _context->PSSetShader(_ps_color_only.Get(), nullptr, 0);
-                break;
-                
-            case core::geometry_type::textured:
-                _context->VSSetShader(_vs.Get(), nullptr, 0);
-                _context->PSSetShader(_ps.Get(), nullptr, 0);
+                ps = _ps_color_only.Get();
                 break;
                 
             case core::geometry_type::font_atlas:
-                // Use generic shaders for font rendering
-                _context->VSSetShader(_vs.Get(), nullptr, 0);
-                _context->PSSetShader(_ps.Get(), nullptr, 0);
+                // coverage/sdf pages are single channel; msdf and color glyph pages are rgba
+                if (cmd.font && cmd.font->is_mcsdf()) {
+                    ps = _ps_msdf.Get();
+                } else if (cmd.texture && cmd.texture->format() == resources::texture_format::r8) {
+                    ps = (cmd.font && cmd.font->is_sdf() ? _ps_sdf : _ps_font).Get();
+                }
                 break;
                 
             default:
-                // fallback to generic shaders
-                _context->VSSetShader(_vs.Get(), nullptr, 0);
-                _context->PSSetShader(_ps.Get(), nullptr, 0);
+                // textured and anything else use the generic shader
                 break;
         }
+        if (ps != bound_ps) {
+            flush_draw();
+            _context->PSSetShader(ps, nullptr, 0);
+            bound_ps = ps;
+            ++stats.state_changes;
+        }
 
         // Bind appropriate texture based on command type
         if (cmd.type == core::geometry_type::font_atlas) {
@@ -288,15 +397,17 @@ void d3d11_renderer::draw_buffer(const core::draw_buffer* buf) {
             
             if (cmd.font_texture) {
                 auto font = cmd.font;
-                if (font && font->get_atlas_srv()) {
-                    // ensure font atlas texture is updated with any new glyphs before binding
-                    // this is necessary for Unicode glyphs to display properly
-                    font->update_atlas_texture(_device.Get());
-                    
-                    // utils::log_debug("Binding font atlas SRV for font");
-                    ID3D11ShaderResourceView* srv = font->get_atlas_srv();
-                    _context->PSSetShaderResources(0, 1, &srv);
-                    utils::log_debug("renderer: bound atlas for '%s'", font->path().c_str());
+                // the command carries the atlas page its glyphs were packed on
+                ID3D11ShaderResourceView* srv = cmd.texture ? cmd.texture->get_srv() : (font ? font->get_atlas_srv() : nullptr);
+                if (font && srv) {
+                    if (srv != bound_srv) {
+                        flush_draw();
+                        _context->PSSetShaderResources(0, 1, &srv);
+                        bound_srv = srv;
+                        ++stats.state_changes;
+                        utils::log_debug("renderer: bound atlas for '%s'", font->path().c_str());
+                    }
+                    _stats.use_texture(cmd.texture.get());
                 } else {
                     utils::log_warn("renderer: font atlas SRV not available");
                 }
@@ -309,9 +420,14 @@ void d3d11_renderer::draw_buffer(const core::draw_buffer* buf) {
                     // Get the D3D11 SRV from the texture
                     ID3D11ShaderResourceView* srv = tex->get_srv();
                     if (srv) {
-                        // utils::log_debug("Binding texture SRV for textured command");
-                        _context->PSSetShaderResources(0, 1, &srv);
-                        utils::log_debug("renderer: bound texture SRV");
+                        if (srv != bound_srv) {
+                            flush_draw();
+                            _context->PSSetShaderResources(0, 1, &srv);
+                            bound_srv = srv;
+                            ++stats.state_changes;
+                            utils::log_debug("renderer: bound texture SRV");
+                        }
+                        _stats.use_texture(tex.get());
                     } else {
                         utils::log_warn("renderer: texture SRV not available");
                     }
@@ -320,9 +436,19 @@ void d3d11_renderer::draw_buffer(const core::draw_buffer* buf) {
         }
 
         // Draw this command's geometry
-        _context->DrawIndexed(cmd.elem_count, static_cast<UINT>(index_offset), 0);
+        ++stats.commands;
+        stats.triangles += cmd.elem_count / 3;
+        if (draw_count && index_offset == draw_start + draw_count) {
+            draw_count += cmd.elem_count;
+            ++stats.merged_commands;
+        } else {
+            flush_draw();
+            draw_start = index_offset;
+            draw_count = cmd.elem_count;
+        }
         index_offset += cmd.elem_count;
     }
+    flush_draw();
 }
 
 // RAII resource scope implementation
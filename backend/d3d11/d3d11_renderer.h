@@ -4,6 +4,7 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include "../../core/renderer.h"
 #include "d3d11_texture.h"
 #include "d3d11_draw_manager.h"
@@ -21,6 +22,8 @@ public:
     void end_frame() override;
 
     void draw_buffer(const core::draw_buffer* buf) override;
+    void draw_retained(uint64_t key, const core::draw_buffer* buf) override;
+    void release_retained(uint64_t key) override;
     void set_texture(resources::tex tex, uint32_t slot = 0) override;
     void set_font_atlas(ID3D11ShaderResourceView* srv) override;
     void set_pixel_shader(const std::string& shader_name) override;
@@ -71,18 +74,31 @@ private:
     Microsoft::WRL::ComPtr<ID3D11VertexShader> _vs;
     Microsoft::WRL::ComPtr<ID3D11PixelShader> _ps;
     Microsoft::WRL::ComPtr<ID3D11PixelShader> _ps_color_only;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> _ps_font;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> _ps_sdf;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> _ps_msdf;
     Microsoft::WRL::ComPtr<ID3D11PixelShader> _ps_fallback;
     Microsoft::WRL::ComPtr<ID3D11VertexShader> _vs_fallback;
     Microsoft::WRL::ComPtr<ID3D11InputLayout> _input_layout;
     Microsoft::WRL::ComPtr<ID3D11SamplerState> _sampler;
     Microsoft::WRL::ComPtr<ID3D11Buffer> _matrix_cb;
     Microsoft::WRL::ComPtr<ID3D11BlendState> _blend_state;
+
+    // geometry of static buffers, uploaded once (see draw_retained)
+    struct retained_geometry {
+        Microsoft::WRL::ComPtr<ID3D11Buffer> vbo;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> ibo;
+    };
+    std::unordered_map<uint64_t, retained_geometry> _retained;
     
     // current shader state
     ID3D11PixelShader* _current_ps = nullptr;
 
     std::vector<char> load_shader_blob(const std::string& path);
     void update_projection_matrix();
+    bool create_geometry(const core::draw_buffer& buf, bool immutable,
+                         Microsoft::WRL::ComPtr<ID3D11Buffer>& vbo, Microsoft::WRL::ComPtr<ID3D11Buffer>& ibo);
+    void draw_geometry(const core::draw_buffer* buf, ID3D11Buffer* vbo, ID3D11Buffer* ibo);
 };
 
 } // namespace backend::d3d11 
\ No newline at end of file
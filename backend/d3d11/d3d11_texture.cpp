@@ -1,13 +1,15 @@
 #include "d3d11_texture.h"
+#include "../../resources/resource_counters.h"
 #include <algorithm>
 #include <cstring>
 #include <cassert>
 #include "../../utils/logger.h"
+#include "../../utils/profiler.h"
 
 namespace backend::d3d11 {
 
-d3d11_texture::d3d11_texture(ID3D11Device* device, uint32_t width, uint32_t height)
-    : _device(device), _width(width), _height(height) {
+d3d11_texture::d3d11_texture(ID3D11Device* device, uint32_t width, uint32_t height, resources::texture_format format)
+    : _device(device), _width(width), _height(height), _format(format) {
     if (width > 0 && height > 0) {
         create();
     }
@@ -20,6 +22,7 @@ d3d11_texture::d3d11_texture(ID3D11Device* device, ID3D11Texture2D* existing_tex
         existing_texture->GetDesc(&desc);
         _width = desc.Width;
         _height = desc.Height;
+        _format = desc.Format == DXGI_FORMAT_R8_UNORM ? resources::texture_format::r8 : resources::texture_format::rgba8;
     }
 }
 
@@ -46,6 +49,12 @@ void d3d11_texture::create() {
     desc.Usage = D3D11_USAGE_DEFAULT;
     desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
     desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED;
+    if (_format == resources::texture_format::r8) {
+        // single-channel textures (glyph coverage) are only ever sampled
+        desc.Format = DXGI_FORMAT_R8_UNORM;
+        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        desc.MiscFlags = 0;
+    }
 
     HRESULT res = _device->CreateTexture2D(&desc, nullptr, &_texture);
     if (FAILED(res)) {
@@ -66,17 +75,22 @@ void d3d11_texture::create() {
 }
 
 bool d3d11_texture::set_data(const uint8_t* data, uint32_t width, uint32_t height) {
-    _data.resize(width * height * 4);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_format == resources::texture_format::r8) {
+        _data.assign(data, data + width * height);
+    } else {
+        _data.resize(width * height * 4);
     
-    // Convert RGBA to BGRA format for D3D11 compatibility
-    // D3D11 expects BGRA format (DXGI_FORMAT_R8G8B8A8_UNORM)
-    for (uint32_t i = 0; i < width * height; ++i) {
-        uint32_t src_idx = i * 4;
-        uint32_t dst_idx = i * 4;
-        _data[dst_idx + 0] = data[src_idx + 2];  // B (from R)
-        _data[dst_idx + 1] = data[src_idx + 1];  // G
-        _data[dst_idx + 2] = data[src_idx + 0];  // R (from B)
-        _data[dst_idx + 3] = data[src_idx + 3];  // A
+        // Convert RGBA to BGRA format for D3D11 compatibility
+        // D3D11 expects BGRA format (DXGI_FORMAT_R8G8B8A8_UNORM)
+        for (uint32_t i = 0; i < width * height; ++i) {
+            uint32_t src_idx = i * 4;
+            uint32_t dst_idx = i * 4;
+            _data[dst_idx + 0] = data[src_idx + 2];  // B (from R)
+            _data[dst_idx + 1] = data[src_idx + 1];  // G
+            _data[dst_idx + 2] = data[src_idx + 0];  // R (from B)
+            _data[dst_idx + 3] = data[src_idx + 3];  // A
+        }
     }
     
     bool changed = (_width != width) || (_height != height);
@@ -85,6 +99,34 @@ bool d3d11_texture::set_data(const uint8_t* data, uint32_t width, uint32_t heigh
     if (!_texture || changed) {
         create();
     }
+    _pending_regions.clear();
+    _full_upload = true;
+    _dirty = true;
+    return true;
+}
+
+bool d3d11_texture::update_region(const resources::texture_region& region, const uint8_t* data, uint32_t pitch) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return stage_region(region, data, pitch);
+}
+
+bool d3d11_texture::stage_region(const resources::texture_region& region, const uint8_t* data, uint32_t pitch) {
+    if (!data || region.width == 0 || region.height == 0) return false;
+    if (region.x + region.width > _width || region.y + region.height > _height) {
+        utils::log_error("update_region: %u,%u %ux%u out of bounds (%ux%u)",
+                         region.x, region.y, region.width, region.height, _width, _height);
+        return false;
+    }
+
+    // stage a tightly packed copy; the source may change before the queue is processed
+    pending_region pending;
+    pending.region = region;
+    const size_t row_bytes = static_cast<size_t>(region.width) * resources::bytes_per_texel(_format);
+    pending.texels.resize(row_bytes * region.height);
+    for (uint32_t row = 0; row < region.height; ++row) {
+        std::memcpy(pending.texels.data() + row * row_bytes, data + static_cast<size_t>(row) * pitch, row_bytes);
+    }
+    _pending_regions.push_back(std::move(pending));
     _dirty = true;
     return true;
 }
@@ -104,6 +146,7 @@ bool d3d11_texture::apply_changes() {
     // user must call process_update_queue on the dict with a valid context
     // (see tex_wrapper_dx11::set_tex_data logic)
     // this is a placeholder; actual upload is done in process_update_queue
+    std::lock_guard<std::mutex> lock(_mutex);
     _dirty = false;
     return true;
 }
@@ -125,19 +168,42 @@ void d3d11_texture::invalidate() {
     _srv.Reset();
 }
 
+bool d3d11_texture::dirty() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _dirty;
+}
+
 bool d3d11_texture::copy_texture_data(ID3D11DeviceContext* ctx) {
-    if (!_texture || _data.empty()) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_dirty) return true;
+    if (!_texture || (_full_upload && _data.empty())) {
         utils::log_error("copy_texture_data failed: texture=%p, data_empty=%d\n", _texture.Get(), _data.empty());
         return false;
     }
+    const uint32_t bpp = resources::bytes_per_texel(_format);
+    size_t bytes = 0;
     D3D11_BOX box = {};
-    box.left = 0;
-    box.top = 0;
     box.front = 0;
     box.back = 1;
-    box.right = _width;
-    box.bottom = _height;
-    ctx->UpdateSubresource(_texture.Get(), 0, &box, _data.data(), _width * 4, _width * _height * 4);
+    if (_full_upload) {
+        box.left = 0;
+        box.top = 0;
+        box.right = _width;
+        box.bottom = _height;
+        ctx->UpdateSubresource(_texture.Get(), 0, &box, _data.data(), _width * bpp, _width * _height * bpp);
+        bytes += static_cast<size_t>(_width) * _height * bpp;
+    }
+    for (const auto& pending : _pending_regions) {
+        box.left = pending.region.x;
+        box.top = pending.region.y;
+        box.right = pending.region.x + pending.region.width;
+        box.bottom = pending.region.y + pending.region.height;
+        ctx->UpdateSubresource(_texture.Get(), 0, &box, pending.texels.data(), pending.region.width * bpp, 0);
+        bytes += pending.texels.size();
+    }
+    resources::resource_counters::shared().texture_upload_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    _pending_regions.clear();
+    _full_upload = false;
     _dirty = false;
     return true;
 }
@@ -155,10 +221,11 @@ d3d11_texture_dict::~d3d11_texture_dict() {
     clear_textures();
 }
 
-resources::tex d3d11_texture_dict::create_texture(uint32_t width, uint32_t height) {
+resources::tex d3d11_texture_dict::create_texture(uint32_t width, uint32_t height, resources::texture_format format) {
     std::lock_guard<std::mutex> lock(_mutex);
-    auto tex = std::make_shared<d3d11_texture>(_device.Get(), width, height);
+    auto tex = std::make_shared<d3d11_texture>(_device.Get(), width, height, format);
     _textures.push_back(tex);
+    resources::resource_counters::shared().textures_created.fetch_add(1, std::memory_order_relaxed);
     return tex;
 }
 
@@ -166,6 +233,7 @@ resources::tex d3d11_texture_dict::create_texture_from_d3d11(ID3D11Texture2D* d3
     std::lock_guard<std::mutex> lock(_mutex);
     auto tex = std::make_shared<d3d11_texture>(_device.Get(), d3d_texture, srv);
     _textures.push_back(tex);
+    resources::resource_counters::shared().textures_created.fetch_add(1, std::memory_order_relaxed);
     return tex;
 }
 
@@ -186,6 +254,27 @@ bool d3d11_texture_dict::set_texture_data(resources::tex tex, const uint8_t* dat
     return result;
 }
 
+bool d3d11_texture_dict::update_texture_region(resources::tex tex, const resources::texture_region& region, const uint8_t* data, uint32_t pitch) {
+    auto d3d_tex = std::dynamic_pointer_cast<d3d11_texture>(tex);
+    if (!d3d_tex) {
+        utils::log_error("update_texture_region: dynamic_pointer_cast failed");
+        return false;
+    }
+    // only the first region of a frame enqueues; later ones ride along.
+    // checked and staged under the texture's lock, so an upload running
+    // meanwhile either takes the region or leaves the texture clean. queued
+    // after the lock: process_update_queue takes the two the other way round
+    bool queued = false;
+    bool result = false;
+    {
+        std::lock_guard<std::mutex> lock(d3d_tex->_mutex);
+        queued = d3d_tex->_dirty;
+        result = d3d_tex->stage_region(region, data, pitch);
+    }
+    if (result && !queued) queue_update(d3d_tex.get());
+    return result;
+}
+
 bool d3d11_texture_dict::get_texture_size(resources::tex tex, uint32_t& width, uint32_t& height) {
     auto d3d_tex = std::dynamic_pointer_cast<d3d11_texture>(tex);
     if (!d3d_tex) return false;
@@ -199,19 +288,29 @@ void d3d11_texture_dict::clear_textures() {
     _update_queue.clear();
 }
 
+size_t d3d11_texture_dict::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t bytes = 0;
+    for (const auto& tex : _textures) {
+        bytes += static_cast<size_t>(tex->width()) * tex->height() * resources::bytes_per_texel(tex->format());
+    }
+    return bytes;
+}
+
 void d3d11_texture_dict::log_memory_stats() const {
+    const size_t bytes = memory_bytes();
     std::lock_guard<std::mutex> lock(_mutex);
     std::lock_guard<std::mutex> qlock(_update_queue_mutex);
     
-    utils::log_info("Texture memory stats: textures=%zu, update_queue=%zu", 
-                   _textures.size(), _update_queue.size());
+    utils::log_info("Texture memory stats: textures=%zu, bytes=%zu, update_queue=%zu", 
+                   _textures.size(), bytes, _update_queue.size());
     
     // log individual texture info
     for (size_t i = 0; i < _textures.size(); ++i) {
         if (auto tex = std::dynamic_pointer_cast<d3d11_texture>(_textures[i])) {
             utils::log_info("  Texture[%zu]: %ux%u, dirty=%s", 
                            i, tex->width(), tex->height(), 
-                           tex->_dirty ? "true" : "false");
+                           tex->dirty() ? "true" : "false");
         }
     }
 }
@@ -246,11 +345,10 @@ void d3d11_texture_dict::queue_update(d3d11_texture* tex) {
 }
 
 void d3d11_texture_dict::process_update_queue(ID3D11DeviceContext* ctx) {
+    FV_PROFILE_SCOPE("d3d11_texture_dict::process_update_queue");
     std::lock_guard<std::mutex> lock(_update_queue_mutex);
     for (auto* tex : _update_queue) {
-        if (tex && tex->_dirty) {
-            tex->copy_texture_data(ctx);
-        }
+        if (tex) tex->copy_texture_data(ctx);
     }
     _update_queue.clear();
 }
@@ -13,11 +13,12 @@ class d3d11_texture;
 
 class d3d11_texture : public resources::texture {
 public:
-    d3d11_texture(ID3D11Device* device, uint32_t width, uint32_t height);
+    d3d11_texture(ID3D11Device* device, uint32_t width, uint32_t height, resources::texture_format format = resources::texture_format::rgba8);
     d3d11_texture(ID3D11Device* device, ID3D11Texture2D* existing_texture, ID3D11ShaderResourceView* existing_srv = nullptr);
     ~d3d11_texture() override;
 
     bool set_data(const uint8_t* data, uint32_t width, uint32_t height) override;
+    bool update_region(const resources::texture_region& region, const uint8_t* data, uint32_t pitch) override;
     bool apply_changes() override;
     bool get_size(uint32_t& width, uint32_t& height) const override;
     void clear_data() override;
@@ -26,23 +27,41 @@ public:
 
     // request this texture to be updated in the dict's update queue
     void request_update(class d3d11_texture_dict* dict);
-    // upload data to GPU (call from render thread)
+    // upload data to GPU (call from render thread); no-op unless dirty
     bool copy_texture_data(ID3D11DeviceContext* ctx);
+    bool dirty() const;
 
     ID3D11ShaderResourceView* srv() const { return _srv.Get(); }
     uint32_t width() const override { return _width; }
     uint32_t height() const override { return _height; }
+    resources::texture_format format() const override { return _format; }
     void bind(uint32_t slot = 0) override;
     void unbind() override;
     ID3D11ShaderResourceView* get_srv() const override { return _srv.Get(); }
 
-    bool _dirty = false;
 private:
+    friend class d3d11_texture_dict;
+    // stages a region; callers hold _mutex
+    bool stage_region(const resources::texture_region& region, const uint8_t* data, uint32_t pitch);
+
     Microsoft::WRL::ComPtr<ID3D11Device> _device;
     Microsoft::WRL::ComPtr<ID3D11Texture2D> _texture;
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> _srv;
     std::vector<uint8_t> _data;
     uint32_t _width = 0, _height = 0;
+    resources::texture_format _format = resources::texture_format::rgba8;
+
+    // sub-rectangle uploads staged until copy_texture_data; a full set_data supersedes them
+    struct pending_region {
+        resources::texture_region region;
+        std::vector<uint8_t> texels;
+    };
+    std::vector<pending_region> _pending_regions;
+    bool _full_upload = false;
+    bool _dirty = false;
+    // staged data and the dirty flag: atlas pages are written by fonts
+    // loading on pool workers while the render thread uploads
+    mutable std::mutex _mutex;
 };
 
 class d3d11_texture_dict : public resources::texture_dict {
@@ -50,12 +69,14 @@ public:
     d3d11_texture_dict(ID3D11Device* device);
     ~d3d11_texture_dict() override;
 
-    resources::tex create_texture(uint32_t width, uint32_t height) override;
+    resources::tex create_texture(uint32_t width, uint32_t height, resources::texture_format format = resources::texture_format::rgba8) override;
     resources::tex create_texture_from_d3d11(ID3D11Texture2D* d3d_texture, ID3D11ShaderResourceView* srv = nullptr);
     void destroy_texture(resources::tex tex) override;
     bool set_texture_data(resources::tex tex, const uint8_t* data, uint32_t width, uint32_t height) override;
+    bool update_texture_region(resources::tex tex, const resources::texture_region& region, const uint8_t* data, uint32_t pitch) override;
     bool get_texture_size(resources::tex tex, uint32_t& width, uint32_t& height) override;
     void clear_textures() override;
+    size_t memory_bytes() const override;
     void pre_reset() override;
     void post_reset() override;
     
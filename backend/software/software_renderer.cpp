@@ -0,0 +1,316 @@
+#include "software_renderer.h"
+#include "../../core/frame_capture.h"
+#include "../../resources/cpu_texture.h"
+#include "../../resources/font.h"
+#include "../../utils/logger.h"
+#include "../../utils/profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace backend::software {
+
+namespace {
+struct rgba {
+    float r, g, b, a;
+};
+
+rgba unpack(uint32_t c) {
+    return {float(c & 0xff) / 255.0f, float((c >> 8) & 0xff) / 255.0f, float((c >> 16) & 0xff) / 255.0f, float(c >> 24) / 255.0f};
+}
+
+uint32_t pack(const rgba& c) {
+    auto channel = [](float v) { return static_cast<uint32_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return channel(c.r) | channel(c.g) << 8 | channel(c.b) << 16 | channel(c.a) << 24;
+}
+
+float smoothstep(float lo, float hi, float x) {
+    const float t = std::clamp((x - lo) / (hi - lo), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+float median(float r, float g, float b) {
+    return std::max(std::min(r, g), std::min(std::max(r, g), b));
+}
+} // namespace
+
+// linear filtering with wrap addressing, like the d3d11 sampler. r8 reads as
+// (r, 0, 0, 1); without cpu pixels every texel is opaque white
+struct software_renderer::sampler {
+    const uint8_t* data = nullptr;
+    int width = 0, height = 0;
+    bool r8 = false;
+
+    explicit sampler(const resources::texture* tex) {
+        const auto* cpu = dynamic_cast<const resources::cpu_texture*>(tex);
+        if (!cpu || cpu->data().empty()) return;
+        data = cpu->data().data();
+        width = static_cast<int>(cpu->width());
+        height = static_cast<int>(cpu->height());
+        r8 = cpu->format() == resources::texture_format::r8;
+    }
+
+    rgba texel(int x, int y) const {
+        x = ((x % width) + width) % width;
+        y = ((y % height) + height) % height;
+        const size_t i = static_cast<size_t>(y) * width + x;
+        if (r8) return {data[i] / 255.0f, 0.0f, 0.0f, 1.0f};
+        const uint8_t* p = data + i * 4;
+        return {p[0] / 255.0f, p[1] / 255.0f, p[2] / 255.0f, p[3] / 255.0f};
+    }
+
+    rgba sample(float u, float v) const {
+        if (!data) return {1.0f, 1.0f, 1.0f, 1.0f};
+        const float x = u * width - 0.5f;
+        const float y = v * height - 0.5f;
+        const float fx = std::floor(x), fy = std::floor(y);
+        const float tx = x - fx, ty = y - fy;
+        const int x0 = static_cast<int>(fx), y0 = static_cast<int>(fy);
+        const rgba a = texel(x0, y0), b = texel(x0 + 1, y0), c = texel(x0, y0 + 1), d = texel(x0 + 1, y0 + 1);
+        auto mix = [&](float p, float q, float r, float s) {
+            return (p * (1.0f - tx) + q * tx) * (1.0f - ty) + (r * (1.0f - tx) + s * tx) * ty;
+        };
+        return {mix(a.r, b.r, c.r, d.r), mix(a.g, b.g, c.g, d.g), mix(a.b, b.b, c.b, d.b), mix(a.a, b.a, c.a, d.a)};
+    }
+};
+
+software_renderer::software_renderer() = default;
+software_renderer::~software_renderer() = default;
+
+void software_renderer::initialize(int width, int height, core::native_window) {
+    resize(width, height);
+}
+
+void software_renderer::resize(int width, int height) {
+    _width = std::max(width, 0);
+    _height = std::max(height, 0);
+    _target.assign(static_cast<size_t>(_width) * _height, 0);
+}
+
+void software_renderer::begin_frame() {
+    clear(core::color(0, 0, 0, 1));
+    _stats.begin_frame();
+    _shader = shader::none;
+    if (_capture) _capture->begin_frame();
+}
+
+void software_renderer::end_frame() {
+    if (_capture) _capture->end_frame();
+    _stats.end_frame();
+    FV_PROFILE_FRAME();
+}
+
+software_renderer::shader software_renderer::select_shader(const core::draw_command& cmd, const resources::texture* tex) const {
+    switch (cmd.type) {
+        case core::geometry_type::color_only:
+            return shader::color_only;
+        case core::geometry_type::font_atlas: {
+            // without the font (replayed captures) the hint names the field type
+            const bool msdf = cmd.font ? cmd.font->is_mcsdf() : cmd.shader_hint == "msdf";
+            const bool sdf = cmd.font ? cmd.font->is_sdf() : cmd.shader_hint == "sdf";
+            if (msdf) return shader::msdf;
+            if (tex && tex->format() == resources::texture_format::r8) return sdf ? shader::sdf : shader::font;
+            return shader::generic;
+        }
+        default:
+            return shader::generic;
+    }
+}
+
+void software_renderer::draw_buffer(const core::draw_buffer* buf) {
+    FV_PROFILE_SCOPE("software_renderer::draw_buffer");
+    if (!buf || buf->vertices.empty() || buf->indices.empty()) {
+        utils::log_warn("draw_buffer: buffer is empty or invalid");
+        return;
+    }
+
+    // same atlas flush as the d3d11 backend; cpu textures take the rectangles at once
+    const resources::glyph_atlas* last_atlas = nullptr;
+    for (const auto& cmd : buf->cmds) {
+        if (cmd.type != core::geometry_type::font_atlas || !cmd.font || cmd.font->atlas().get() == last_atlas) continue;
+        last_atlas = cmd.font->atlas().get();
+        cmd.font->flush_atlas();
+        _stats.use_atlas(*cmd.font->atlas());
+    }
+    if (_capture) _capture->record(*buf);
+    _stats.count_buffer(*buf);
+    auto& stats = _stats.stats();
+
+    // a command continuing the previous one's indices with the same state
+    // would go out in the same draw call
+    size_t index_offset = 0;
+    size_t draw_end = SIZE_MAX;
+    for (const auto& cmd : buf->cmds) {
+        if (cmd.elem_count == 0) continue;
+        if (cmd.type == core::geometry_type::font_atlas && cmd.font && !cmd.font->atlas_valid_since(cmd.font_frame, cmd.atlas_page)) {
+            index_offset += cmd.elem_count;
+            continue;
+        }
+        if (index_offset + cmd.elem_count > buf->indices.size()) {
+            utils::log_warn("draw_buffer: command needs %u indices past the %zu in the buffer", cmd.elem_count, buf->indices.size() - index_offset);
+            break;
+        }
+
+        // commands bind their texture the way the d3d11 backend does; the rest
+        // sample whatever is still bound
+        const bool binds = (cmd.type == core::geometry_type::font_atlas && cmd.font_texture) ||
+                           (cmd.type == core::geometry_type::textured && cmd.native_texture);
+        bool changed = false;
+        if (binds && cmd.texture && cmd.texture != _texture) {
+            _texture = cmd.texture;
+            changed = true;
+            ++stats.state_changes;
+        }
+        const shader mode = select_shader(cmd, _texture.get());
+        if (mode != _shader) {
+            _shader = mode;
+            changed = true;
+            ++stats.state_changes;
+        }
+        ++stats.commands;
+        if (!changed && index_offset == draw_end) {
+            ++stats.merged_commands;
+        } else {
+            ++stats.draw_calls;
+        }
+        draw_end = index_offset + cmd.elem_count;
+        if (mode != shader::color_only) _stats.use_texture(_texture.get());
+
+        const sampler tex(mode == shader::color_only ? nullptr : _texture.get());
+        const uint32_t vertex_count = static_cast<uint32_t>(buf->vertices.size());
+        for (size_t i = index_offset; i + 2 < index_offset + cmd.elem_count; i += 3) {
+            const uint32_t a = buf->indices[i], b = buf->indices[i + 1], c = buf->indices[i + 2];
+            if (a >= vertex_count || b >= vertex_count || c >= vertex_count) continue;
+            draw_triangle(buf->vertices[a], buf->vertices[b], buf->vertices[c], mode, tex);
+        }
+        index_offset += cmd.elem_count;
+    }
+}
+
+void software_renderer::draw_triangle(const core::vertex& va, const core::vertex& vb, const core::vertex& vc, shader mode, const sampler& tex) {
+    const core::vertex* v[3] = {&va, &vb, &vc};
+    float area = (vb.pos[0] - va.pos[0]) * (vc.pos[1] - va.pos[1]) - (vb.pos[1] - va.pos[1]) * (vc.pos[0] - va.pos[0]);
+    if (!(std::abs(area) > 0.0f) || !std::isfinite(area)) return;
+    if (area < 0.0f) {
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+    ++_stats.stats().triangles;
+
+    const float min_x = std::min({va.pos[0], vb.pos[0], vc.pos[0]});
+    const float max_x = std::max({va.pos[0], vb.pos[0], vc.pos[0]});
+    const float min_y = std::min({va.pos[1], vb.pos[1], vc.pos[1]});
+    const float max_y = std::max({va.pos[1], vb.pos[1], vc.pos[1]});
+    const int x0 = std::max(0, static_cast<int>(std::floor(min_x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(min_y)));
+    const int x1 = std::min(_width - 1, static_cast<int>(std::ceil(max_x)));
+    const int y1 = std::min(_height - 1, static_cast<int>(std::ceil(max_y)));
+    if (x0 > x1 || y0 > y1) return;
+
+    // edge k is opposite vertex k; its function is that vertex's weight times
+    // the area. it is set up from the endpoints in a fixed order and negated,
+    // so both triangles sharing an edge compute exactly opposite values and
+    // pixels on it go to one of them only
+    struct edge {
+        float dx, dy, c;
+        bool inclusive;
+    } e[3];
+    for (int k = 0; k < 3; ++k) {
+        const core::vertex* p = v[(k + 1) % 3];
+        const core::vertex* q = v[(k + 2) % 3];
+        const bool flip = q->pos[1] < p->pos[1] || (q->pos[1] == p->pos[1] && q->pos[0] < p->pos[0]);
+        if (flip) std::swap(p, q);
+        e[k].dx = -(q->pos[1] - p->pos[1]);
+        e[k].dy = q->pos[0] - p->pos[0];
+        e[k].c = -(e[k].dx * p->pos[0] + e[k].dy * p->pos[1]);
+        if (flip) {
+            e[k].dx = -e[k].dx;
+            e[k].dy = -e[k].dy;
+            e[k].c = -e[k].c;
+        }
+        e[k].inclusive = flip;
+    }
+
+    rgba col[3];
+    for (int k = 0; k < 3; ++k) col[k] = unpack(v[k]->col_u32);
+    const float inv_area = 1.0f / area;
+    // uv change per pixel, for the distance field shaders' fwidth
+    float du_dx = 0, dv_dx = 0, du_dy = 0, dv_dy = 0;
+    for (int k = 0; k < 3; ++k) {
+        du_dx += e[k].dx * inv_area * v[k]->uv[0];
+        dv_dx += e[k].dx * inv_area * v[k]->uv[1];
+        du_dy += e[k].dy * inv_area * v[k]->uv[0];
+        dv_dy += e[k].dy * inv_area * v[k]->uv[1];
+    }
+    auto field = [&](float u, float w) {
+        if (mode == shader::msdf) {
+            const rgba t = tex.sample(u, w);
+            return median(t.r, t.g, t.b);
+        }
+        return tex.sample(u, w).r;
+    };
+
+    uint64_t shaded = 0;
+    for (int y = y0; y <= y1; ++y) {
+        const float py = y + 0.5f;
+        uint32_t* row = _target.data() + static_cast<size_t>(y) * _width;
+        for (int x = x0; x <= x1; ++x) {
+            const float px = x + 0.5f;
+            float w[3];
+            bool inside = true;
+            for (int k = 0; k < 3 && inside; ++k) {
+                w[k] = e[k].dx * px + e[k].dy * py + e[k].c;
+                inside = w[k] > 0.0f || (w[k] == 0.0f && e[k].inclusive);
+            }
+            if (!inside) continue;
+            ++shaded;
+
+            const float b0 = w[0] * inv_area, b1 = w[1] * inv_area, b2 = w[2] * inv_area;
+            rgba src = {b0 * col[0].r + b1 * col[1].r + b2 * col[2].r, b0 * col[0].g + b1 * col[1].g + b2 * col[2].g,
+                        b0 * col[0].b + b1 * col[1].b + b2 * col[2].b, b0 * col[0].a + b1 * col[1].a + b2 * col[2].a};
+            const float u = b0 * v[0]->uv[0] + b1 * v[1]->uv[0] + b2 * v[2]->uv[0];
+            const float t = b0 * v[0]->uv[1] + b1 * v[1]->uv[1] + b2 * v[2]->uv[1];
+            switch (mode) {
+                case shader::generic: {
+                    const rgba s = tex.sample(u, t);
+                    src = {src.r * s.r, src.g * s.g, src.b * s.b, src.a * s.a};
+                    break;
+                }
+                case shader::font:
+                    src.a *= tex.sample(u, t).r;
+                    break;
+                case shader::sdf:
+                case shader::msdf: {
+                    const float dist = field(u, t);
+                    const float width = std::max(std::abs(field(u + du_dx, t + dv_dx) - dist) + std::abs(field(u + du_dy, t + dv_dy) - dist), 1e-4f);
+                    src.a *= smoothstep(0.5f - width, 0.5f + width, dist);
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            // src alpha / inv src alpha, alpha one / inv src alpha
+            const rgba dst = unpack(row[x]);
+            const float a = std::clamp(src.a, 0.0f, 1.0f);
+            row[x] = pack({src.r * a + dst.r * (1.0f - a), src.g * a + dst.g * (1.0f - a), src.b * a + dst.b * (1.0f - a), a + dst.a * (1.0f - a)});
+        }
+    }
+    _stats.stats().pixels += shaded;
+}
+
+void software_renderer::set_texture(resources::tex tex, uint32_t slot) {
+    if (slot != 0) return; // every shader samples slot 0 only
+    if (tex != _texture) ++_stats.stats().state_changes;
+    _texture = std::move(tex);
+}
+
+void software_renderer::set_pixel_shader(const std::string& /*shader_name*/) {
+    // the coverage, sdf or msdf path is picked per command from its font, as
+    // in the d3d11 backend, so a frame-wide shader has nothing to select
+}
+
+void software_renderer::clear(const core::color& col) {
+    std::fill(_target.begin(), _target.end(), core::pack_color_abgr(col));
+}
+
+} // namespace backend::software
@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "../../core/renderer.h"
+
+namespace backend::software {
+
+// rasterizes draw_buffers on the cpu into an rgba8 target. it follows the
+// d3d11 backend's pipeline (shader per command type, linear wrap sampling,
+// src-alpha blending, clip rects not applied) so that it can stand in for it
+// headless: tests, and replaying captures on machines without a gpu. textures
+// are sampled through resources::cpu_texture; others read as opaque white
+class software_renderer : public core::renderer {
+public:
+    software_renderer();
+    ~software_renderer() override;
+
+    void initialize(int width, int height, core::native_window hwnd = nullptr) override;
+    void resize(int width, int height) override;
+    void begin_frame() override;
+    void end_frame() override;
+
+    void draw_buffer(const core::draw_buffer* buf) override;
+    void set_texture(resources::tex tex, uint32_t slot = 0) override;
+#ifdef _WIN32
+    void set_font_atlas(ID3D11ShaderResourceView* srv) override {}
+#endif
+    void set_pixel_shader(const std::string& shader_name) override;
+    void clear(const core::color& col) override;
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+    // row-major, packed like vertex colors (see core::pack_color_abgr)
+    const std::vector<uint32_t>& pixels() const { return _target; }
+
+private:
+    enum class shader : uint8_t { none, color_only, generic, font, sdf, msdf };
+    struct sampler;
+
+    shader select_shader(const core::draw_command& cmd, const resources::texture* tex) const;
+    void draw_triangle(const core::vertex& a, const core::vertex& b, const core::vertex& c, shader mode, const sampler& tex);
+
+    std::vector<uint32_t> _target;
+    int _width = 0, _height = 0;
+    resources::tex _texture; // bound by set_texture or the last command binding one
+    shader _shader = shader::none;
+};
+
+} // namespace backend::software
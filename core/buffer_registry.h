@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include "../utils/slot_map.h"
+
+namespace core {
+
+// buffer handles given out by draw_manager. they stay valid
+// while other buffers come and go; a removed buffer's handle is stale and
+// every call taking it does nothing (get_buffer returns nullptr)
+using buffer_id = utils::slot_map<int>::handle;
+inline constexpr buffer_id invalid_buffer = utils::slot_map<int>::null;
+
+// the buffers of a draw manager: a tree where each buffer draws before its
+// children, and siblings draw by ascending priority, ties in registration
+// order. adding, removing and reprioritizing a buffer is O(log siblings), so
+// thousands of short-lived buffers (tooltips, popups) stay cheap.
+// not synchronized; the managers lock around it
+template <typename Buffer>
+class buffer_registry {
+public:
+    // invalid_buffer if parent is given but stale
+    buffer_id add(size_t priority, buffer_id parent = invalid_buffer) {
+        if (parent != invalid_buffer && !_nodes.contains(parent)) return invalid_buffer;
+        const uint64_t order = _next_order++;
+        const buffer_id id = _nodes.insert(node{std::make_unique<Buffer>(), {}, parent, priority, order});
+        siblings(parent).insert({priority, order, id});
+        return id;
+    }
+
+    // removes the buffer and everything below it
+    bool remove(buffer_id id) {
+        node* n = _nodes.get(id);
+        if (!n) return false;
+        while (!n->children.empty()) remove(n->children.begin()->id);
+        siblings(n->parent).erase({n->priority, n->order, id});
+        _nodes.erase(id);
+        return true;
+    }
+
+    bool set_priority(buffer_id id, size_t priority) {
+        node* n = _nodes.get(id);
+        if (!n) return false;
+        if (n->priority == priority) return true;
+        auto& set = siblings(n->parent);
+        set.erase({n->priority, n->order, id});
+        n->priority = priority;
+        set.insert({priority, n->order, id});
+        return true;
+    }
+
+    Buffer* get(buffer_id id) {
+        node* n = _nodes.get(id);
+        return n ? n->buffer.get() : nullptr;
+    }
+    const Buffer* get(buffer_id id) const {
+        const node* n = _nodes.get(id);
+        return n ? n->buffer.get() : nullptr;
+    }
+
+    // replaces the buffer with an empty one
+    bool reset(buffer_id id) {
+        node* n = _nodes.get(id);
+        if (!n) return false;
+        n->buffer = std::make_unique<Buffer>();
+        return true;
+    }
+
+    size_t size() const { return _nodes.size(); }
+    bool contains(buffer_id id) const { return _nodes.contains(id); }
+
+    // f(buffer_id, const Buffer&) in draw order: depth first, parents before
+    // their children, siblings by priority
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const key& k : _roots) visit(k.id, f);
+    }
+
+private:
+    struct key {
+        size_t priority;
+        uint64_t order;
+        buffer_id id;
+        bool operator<(const key& o) const { return priority != o.priority ? priority < o.priority : order < o.order; }
+    };
+
+    struct node {
+        std::unique_ptr<Buffer> buffer; // stable address while the slot map grows
+        std::set<key> children;
+        buffer_id parent;
+        size_t priority;
+        uint64_t order;
+    };
+
+    std::set<key>& siblings(buffer_id parent) { return parent == invalid_buffer ? _roots : _nodes.get(parent)->children; }
+
+    template <typename F>
+    void visit(buffer_id id, F& f) const {
+        const node* n = _nodes.get(id);
+        f(id, static_cast<const Buffer&>(*n->buffer));
+        for (const key& k : n->children) visit(k.id, f);
+    }
+
+    utils::slot_map<node> _nodes;
+    std::set<key> _roots;
+    uint64_t _next_order = 0;
+};
+
+} // namespace core
@@ -4,6 +4,8 @@
 #include <algorithm>
 #include "../resources/font.h"
 #include "../utils/logger.h"
+#include "../utils/profiler.h"
+#include "../utils/utf8.h"
 #include <stack>
 #include "../math/constants.h"
 
@@ -308,6 +310,7 @@ void draw_buffer::generate_rounded_quad_geometry(const position& a, const positi
 }
 
 void draw_buffer::prim_rect(const position& a, const position& c, const color& col, float rounding) {
+    FV_PROFILE_SCOPE("draw_buffer::prim_rect");
     // collect vertices and indices for this rectangle outline
     std::vector<vertex> rect_vertices;
     std::vector<uint32_t> rect_indices;
@@ -335,6 +338,7 @@ void draw_buffer::prim_rect(const position& a, const position& c, const color& c
 }
 
 void draw_buffer::prim_rect_filled(const position& a, const position& c, const color& col, float rounding) {
+    FV_PROFILE_SCOPE("draw_buffer::prim_rect_filled");
     // collect vertices and indices for this color-only quad
     std::vector<vertex> quad_vertices;
     std::vector<uint32_t> quad_indices;
@@ -349,6 +353,7 @@ void draw_buffer::prim_rect_filled(const position& a, const position& c, const c
 void draw_buffer::prim_rect_multi_color(const position& a, const position& c, 
                                        const color& col_top_left, const color& col_top_right,
                                        const color& col_bot_left, const color& col_bot_right, float rounding) {
+    FV_PROFILE_SCOPE("draw_buffer::prim_rect_multi_color");
     // collect vertices and indices for this multi-color quad
     std::vector<vertex> quad_vertices;
     std::vector<uint32_t> quad_indices;
@@ -384,6 +389,7 @@ void draw_buffer::prim_rect_multi_color(const position& a, const position& c,
 }
 
 void draw_buffer::line(const position& a, const position& b, uint32_t color_a, uint32_t color_b, float thickness) {
+    FV_PROFILE_SCOPE("draw_buffer::line");
     // simple line as a thin quad (rectangle)
     // for now, just use two points and a degenerate quad
     float dx = b.x - a.x, dy = b.y - a.y;
@@ -418,6 +424,7 @@ void draw_buffer::line(const position& a, const position& b, uint32_t color_a, u
 }
 
 void draw_buffer::line_strip(const std::vector<position>& points, uint32_t color, float thickness) {
+    FV_PROFILE_SCOPE("draw_buffer::line_strip");
     if (points.size() < 2) return;
     
     // collect all line segments
@@ -460,6 +467,7 @@ void draw_buffer::line_strip(const std::vector<position>& points, uint32_t color
 }
 
 void draw_buffer::poly_line(const std::vector<position>& points, uint32_t color, float thickness, bool closed) {
+    FV_PROFILE_SCOPE("draw_buffer::poly_line");
     if (points.size() < 2) return;
     
     // collect all line segments
@@ -532,6 +540,7 @@ void draw_buffer::poly_line(const std::vector<position>& points, uint32_t color,
 }
 
 void draw_buffer::triangle_filled(const position& a, const position& b, const position& c, uint32_t color_a, uint32_t color_b, uint32_t color_c) {
+    FV_PROFILE_SCOPE("draw_buffer::triangle_filled");
     // collect vertices and indices for this triangle
     std::vector<vertex> tri_vertices;
     std::vector<uint32_t> tri_indices;
@@ -551,6 +560,7 @@ void draw_buffer::triangle_filled(const position& a, const position& b, const po
 }
 
 void draw_buffer::circle_filled(const position& center, float radius, uint32_t color_inner, uint32_t color_outer, int segments) {
+    FV_PROFILE_SCOPE("draw_buffer::circle_filled");
     if (segments < 3) segments = 3;
     
     // collect vertices and indices for this circle
@@ -585,6 +595,7 @@ void draw_buffer::circle_filled(const position& center, float radius, uint32_t c
 }
 
 void draw_buffer::prim_rect_uv(const position& a, const position& c, const position& uv_a, const position& uv_c, uint32_t color, float rounding) {
+    FV_PROFILE_SCOPE("draw_buffer::prim_rect_uv");
     // collect vertices and indices for this textured quad
     std::vector<vertex> quad_vertices;
     std::vector<uint32_t> quad_indices;
@@ -602,6 +613,7 @@ void draw_buffer::prim_rect_uv(const position& a, const position& c, const posit
 }
 
 void draw_buffer::n_gon(const position& center, float radius, int sides, uint32_t color) {
+    FV_PROFILE_SCOPE("draw_buffer::n_gon");
     if (sides < 3) sides = 3;
     
     // collect vertices and indices for this n-gon
@@ -635,7 +647,8 @@ void draw_buffer::n_gon(const position& center, float radius, int sides, uint32_
     add_geometry_color_only(ngon_vertices, ngon_indices);
 }
 
-void draw_buffer::text(const std::string& str, const position& pos, uint32_t color) {
+void draw_buffer::text(const std::string& str, const position& pos, uint32_t color, float size) {
+    FV_PROFILE_SCOPE("draw_buffer::text");
     if (font_stack_.empty()) {
         utils::log_warn("text: no font set, skipping text rendering");
         return;
@@ -647,45 +660,36 @@ void draw_buffer::text(const std::string& str, const position& pos, uint32_t col
         return;
     }
     
+    // bring in glyphs the workers finished since the last call
+    base_font->pack_ready_glyphs();
+    for (const auto& fb : base_font->fallbacks()) {
+        if (fb) fb->pack_ready_glyphs();
+    }
+    if (auto df = base_font->get_default_fallback()) df->pack_ready_glyphs();
+    
     // collect vertices/indices per font run
     std::vector<vertex> run_vertices;
     std::vector<uint32_t> run_indices;
     std::shared_ptr<resources::font> run_font = nullptr;
+    int run_page = 0;
+    uint32_t run_frame = 0;
     
+    // sdf atlases are resolution independent, so one font serves every size
     float x = pos.x;
-    float baseline_y = pos.y + base_font->metrics().ascender;
+    float baseline_y = pos.y + base_font->metrics().ascender * base_font->draw_scale(size);
+    // kerning applies between consecutive glyphs of the same font
+    const resources::font* prev_font = nullptr;
+    uint32_t prev_codepoint = 0;
+    // glyph tables are read under a shared lock taken once per font for the
+    // whole call, so several threads can record text with the same fonts
+    resources::glyph_reader reader;
         
     const char* ptr = str.c_str();
     const char* end = ptr + str.length();
     
     while (ptr < end) {
         uint32_t codepoint = 0;
-        int bytes_read = 0;
-        
-        // decode UTF-8 character
-        if ((*ptr & 0x80) == 0) {
-            // single byte
-            codepoint = static_cast<uint8_t>(*ptr);
-            bytes_read = 1;
-        } else if ((*ptr & 0xE0) == 0xC0) {
-            // two bytes
-            if (ptr + 1 < end) {
-                codepoint = ((*ptr & 0x1F) << 6) | (*(ptr + 1) & 0x3F);
-                bytes_read = 2;
-            }
-        } else if ((*ptr & 0xF0) == 0xE0) {
-            // three bytes
-            if (ptr + 2 < end) {
-                codepoint = ((*ptr & 0x0F) << 12) | ((*(ptr + 1) & 0x3F) << 6) | (*(ptr + 2) & 0x3F);
-                bytes_read = 3;
-            }
-        } else if ((*ptr & 0xF8) == 0xF0) {
-            // four bytes
-            if (ptr + 3 < end) {
-                codepoint = ((*ptr & 0x07) << 18) | ((*(ptr + 1) & 0x3F) << 12) | ((*(ptr + 2) & 0x3F) << 6) | (*(ptr + 3) & 0x3F);
-                bytes_read = 3;
-            }
-        }
+        int bytes_read = utils::decode_utf8(ptr, end, codepoint);
         
         if (bytes_read == 0) {
             // invalid UTF-8, skip one byte
@@ -693,52 +697,113 @@ void draw_buffer::text(const std::string& str, const position& pos, uint32_t col
             continue;
         }
         
-        // select a font that can provide this glyph (base font or fallbacks)
+        // select a font that can provide this glyph: a coverage bit test on
+        // the base font, then the cached fallback resolution for the chain.
+        // new glyphs rasterize on workers and don't block recording
+        using resources::glyph_status;
         std::shared_ptr<resources::font> glyph_font = base_font;
-        bool have_glyph = glyph_font->ensure_glyph(codepoint);
-        if (!have_glyph) {
-            // try declared fallbacks in order
-            for (const auto& fb : base_font->fallbacks()) {
-                if (fb && fb->ensure_glyph(codepoint)) { glyph_font = fb; have_glyph = true; break; }
-            }
-            // try default fallback as last resort
-            if (!have_glyph) {
-                auto df = base_font->get_default_fallback();
-                if (df && df->ensure_glyph(codepoint)) { glyph_font = df; have_glyph = true; }
+        if (!base_font->covers(codepoint)) {
+            if (auto fb = base_font->resolve_fallback(codepoint)) glyph_font = fb;
+        }
+        // stamped as drawn this frame, which keeps it out of atlas eviction.
+        // a miss lets go of the tables, the insertion path locks them exclusive.
+        // the frame is read first: the atlas may flush meanwhile on another
+        // thread, and runs are tagged with the oldest frame of their glyphs
+        const uint32_t frame = glyph_font->frame();
+        const resources::glyph_info* found = reader.use(*glyph_font, codepoint);
+        glyph_status status = glyph_status::ready;
+        if (!found) {
+            reader.unlock();
+            status = glyph_font->ensure_glyph_async(codepoint);
+            if (status == glyph_status::ready) {
+                found = reader.use(*glyph_font, codepoint);
+                if (!found) status = glyph_status::pending; // evicted right away, retried next frame
             }
-            if (have_glyph && glyph_font.get() != base_font.get()) {
-                utils::log_debug("text: using fallback font '%s' for U+%04X", glyph_font->path().c_str(), codepoint);
+        }
+        const float scale = glyph_font->draw_scale(size);
+        if (status != glyph_status::missing) {
+            if (glyph_font.get() == prev_font && glyph_font->has_kerning()) {
+                x += glyph_font->get_kerning(prev_codepoint, codepoint) * scale;
             }
+            prev_font = glyph_font.get();
+            prev_codepoint = codepoint;
+        }
+        if (status == glyph_status::pending) {
+            // drawn on a later frame once packed; the advance is known already,
+            // so the rest of the line doesn't move when it appears
+            x += glyph_font->advance(codepoint) * scale;
+            ptr += bytes_read;
+            continue;
         }
-        if (!have_glyph) {
-            utils::log_warn("yph for codepoint U+%04X in font and all fallbacks", codepoint);
+        if (status == glyph_status::missing) {
+            utils::log_warn("text: no glyph for codepoint U+%04X in font and all fallbacks", codepoint);
             ptr += bytes_read;
             continue;
         }
         
-        // if font changed, flush previous run
+        // copied: a variant miss below releases the table
+        const resources::glyph_info base_glyph = *found;
+        
+        // subpixel fonts place a phase variant at the whole pixel below the pen;
+        // until the variant is packed the whole-pixel glyph is snapped instead
+        resources::glyph_info glyph = base_glyph;
+        float pen_x = x;
+        const int phases = glyph_font->subpixel_positions();
+        if (phases > 1 && !base_glyph.colored) {
+            float whole = std::floor(x);
+            int phase = static_cast<int>((x - whole) * phases + 0.5f);
+            if (phase == phases) {
+                whole += 1.0f;
+                phase = 0;
+            }
+            pen_x = whole;
+            if (phase > 0) {
+                const uint32_t key = resources::font::glyph_key(codepoint, phase);
+                const resources::glyph_info* variant = reader.use(*glyph_font, key);
+                if (!variant) {
+                    // queues it, or packs it right away when async glyphs are off
+                    reader.unlock();
+                    glyph_font->subpixel_glyph(codepoint, phase);
+                    variant = reader.use(*glyph_font, key);
+                }
+                if (variant) {
+                    glyph = *variant;
+                } else {
+                    pen_x = std::round(x);
+                }
+            }
+        }
+
+        // flush the previous run when the atlas page or the shader changes;
+        // fonts sharing an atlas continue each other's runs
         if (!run_font) {
             run_font = glyph_font;
+            run_page = glyph.page;
+            run_frame = frame;
             utils::log_debug("text: start run with font '%s'", run_font->path().c_str());
         }
-        if (glyph_font.get() != run_font.get()) {
+        const bool same_run = glyph.page == run_page &&
+                              (glyph_font.get() == run_font.get() ||
+                               (glyph_font->atlas() == run_font->atlas() && glyph_font->is_sdf() == run_font->is_sdf() &&
+                                glyph_font->is_mcsdf() == run_font->is_mcsdf()));
+        if (!same_run) {
             if (!run_vertices.empty() && !run_indices.empty()) {
-                add_geometry_font(run_vertices, run_indices, run_font);
+                add_geometry_font(run_vertices, run_indices, run_font, run_font->get_atlas_tex(run_page), run_frame, run_page);
                 utils::log_debug("text: flush run font='%s' vtx=%zu idx=%zu", run_font->path().c_str(), run_vertices.size(), run_indices.size());
                 run_vertices.clear();
                 run_indices.clear();
             }
             run_font = glyph_font;
-            utils::log_debug("text: switch run to font '%s'", run_font->path().c_str());
+            run_page = glyph.page;
+            run_frame = frame;
+            utils::log_debug("text: switch run to font '%s' page %d", run_font->path().c_str(), run_page);
         }
-
-        const auto& glyph = glyph_font->glyphs().at(codepoint);
         
         // calculate glyph position relative to baseline
-        float x0 = x + glyph.bearingX;
-        float y0 = baseline_y - glyph.bearingY; // bearingY is distance from baseline to top
-        float x1 = x0 + glyph.width;
-        float y1 = y0 + glyph.height;
+        float x0 = pen_x + glyph.bearingX * scale;
+        float y0 = baseline_y - glyph.bearingY * scale; // bearingY is distance from baseline to top
+        float x1 = x0 + glyph.width * scale;
+        float y1 = y0 + glyph.height * scale;
          
         float u0 = glyph.u0, v0 = glyph.v0, u1 = glyph.u1, v1 = glyph.v1;
         
@@ -760,7 +825,7 @@ void draw_buffer::text(const std::string& str, const position& pos, uint32_t col
         run_indices.push_back(base_vertex + 3);
         
         // advance to next character position
-        x += glyph.advance;
+        x += base_glyph.advance * scale;
         
         ptr += bytes_read;
     }
@@ -768,8 +833,29 @@ void draw_buffer::text(const std::string& str, const position& pos, uint32_t col
     // flush last run
     if (!run_vertices.empty() && !run_indices.empty() && run_font) {
         utils::log_debug("text: flush final run font='%s' vtx=%zu idx=%zu", run_font->path().c_str(), run_vertices.size(), run_indices.size());
-        add_geometry_font(run_vertices, run_indices, run_font);
+        add_geometry_font(run_vertices, run_indices, run_font, run_font->get_atlas_tex(run_page), run_frame, run_page);
+    }
+}
+
+text_extent draw_buffer::text_box(const std::string& str, const position& pos, float max_width, uint32_t color, float size) {
+    FV_PROFILE_SCOPE("draw_buffer::text_box");
+    auto font = current_font();
+    if (!font) {
+        utils::log_warn("text_box: no font set, skipping text rendering");
+        return {};
+    }
+    
+    text_extent extent;
+    const float line_height = font->metrics().line_height * font->draw_scale(size);
+    for (const auto& line : wrap_text(*font, str, max_width, size)) {
+        if (line.end > line.begin) {
+            text(str.substr(line.begin, line.end - line.begin), position(pos.x, pos.y + extent.lines * line_height), color, size);
+        }
+        extent.width = std::max(extent.width, line.width);
+        ++extent.lines;
     }
+    extent.height = extent.lines * line_height;
+    return extent;
 }
 
 void draw_buffer::set_blur(uint8_t strength, uint8_t passes) {
@@ -908,11 +994,13 @@ void draw_buffer::add_geometry_textured(const std::vector<vertex>& vertices, con
     end_command();
 }
 
-void draw_buffer::add_geometry_font(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, std::shared_ptr<resources::font> font) {
+void draw_buffer::add_geometry_font(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, std::shared_ptr<resources::font> font, resources::tex atlas_page, uint32_t font_frame, int page_index) {
     // utils::log_info("add_geometry_font: vertices=%zu, indices=%zu, font=%s", 
     //                vertices.size(), indices.size(), font ? "valid" : "null");
     
-    begin_command(core::geometry_type::font_atlas, "generic");
+    const bool coverage = atlas_page && atlas_page->format() == resources::texture_format::r8;
+    const char* hint = (font && font->is_mcsdf()) ? "msdf" : !coverage ? "generic" : (font && font->is_sdf()) ? "sdf" : "font";
+    begin_command(core::geometry_type::font_atlas, hint);
     
     uint32_t base_vertex = static_cast<uint32_t>(this->vertices.size());
     uint32_t base_index = static_cast<uint32_t>(this->indices.size());
@@ -930,6 +1018,9 @@ void draw_buffer::add_geometry_font(const std::vector<vertex>& vertices, const s
         cmds.back().elem_count = static_cast<uint32_t>(indices.size());
         cmds.back().font_texture = true;
         cmds.back().font = font;
+        cmds.back().texture = atlas_page;
+        cmds.back().font_frame = font_frame ? font_frame : font ? font->frame() : 0;
+        cmds.back().atlas_page = page_index;
     }
     
     end_command();
@@ -958,6 +1049,7 @@ void draw_buffer::clear_all() {
     cmds.clear();
     clear_texture_stack();
     font_stack_.clear();
+    invalidate();
 }
 
 } // namespace core 
\ No newline at end of file
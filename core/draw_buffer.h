@@ -3,6 +3,7 @@
 #include <memory>
 #include <functional>
 #include "draw_types.h"
+#include "text_layout.h"
 #include <string>
 #include <stack>
 #include "../resources/font.h"
@@ -42,7 +43,9 @@ struct draw_command {
     
     // resources bound by this command
     std::shared_ptr<resources::font> font;       // for font_atlas commands
-    resources::tex texture;                      // for textured commands
+    resources::tex texture;                      // for textured commands, atlas page for font_atlas
+    uint32_t font_frame = 0;                     // font->frame() when recorded, see atlas_valid_since
+    int atlas_page = -1;                         // index of that page on font->atlas(), -1 if not known
     
     // matrix transform could be added here
 };
@@ -79,7 +82,10 @@ public:
     void circle_filled(const position& center, float radius, uint32_t color_inner, uint32_t color_outer, int segments = 32);
     void prim_rect_uv(const position& a, const position& c, const position& uv_a, const position& uv_c, uint32_t color, float rounding = 0.0f);
     void n_gon(const position& center, float radius, int sides, uint32_t color);
-    void text(const std::string& str, const position& pos, uint32_t color); // stub
+    // size is the pixel height to draw at; 0 uses the font size. only sdf/msdf fonts scale, bitmap fonts stay at their native size
+    void text(const std::string& str, const position& pos, uint32_t color, float size = 0.0f);
+    // wrapped to max_width (see wrap_text) with line_height spacing, pos is the top left of the first line
+    text_extent text_box(const std::string& str, const position& pos, float max_width, uint32_t color, float size = 0.0f);
     
     void push_font(std::shared_ptr<resources::font> font);
     void pop_font();
@@ -129,7 +135,8 @@ public:
     // Unified geometry methods that automatically handle command creation
     void add_geometry_color_only(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices);
     void add_geometry_textured(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, resources::tex texture);
-    void add_geometry_font(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, std::shared_ptr<resources::font> font);
+    // font_frame: the oldest font frame the glyphs were stamped in, 0 for the current one
+    void add_geometry_font(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, std::shared_ptr<resources::font> font, resources::tex atlas_page = nullptr, uint32_t font_frame = 0, int page_index = -1);
     
     // Command management
     void begin_command(geometry_type type, const std::string& shader_hint = "");
@@ -138,8 +145,18 @@ public:
     // Get current command for modification
     draw_command* current_command();
     
-    // Clear all geometry and commands
+    // Clear all geometry and commands (a new version, see invalidate)
     void clear_all();
+
+    // static contents: a frozen buffer is uploaded once and then drawn from the
+    // backend's copy (see frame_builder) until its version changes. call
+    // invalidate() after changing a frozen buffer in place. its glyphs are not
+    // stamped again: the builder pins their atlas pages while it keeps the copy
+    void freeze() { frozen_ = true; }
+    void thaw() { frozen_ = false; }
+    bool frozen() const { return frozen_; }
+    void invalidate() { ++version_; }
+    uint32_t version() const { return version_; }
     
     // Get rendering statistics
     size_t command_count() const { return cmds.size(); }
@@ -152,6 +169,8 @@ public:
 private:
     std::vector<std::shared_ptr<resources::font>> font_stack_;
     std::vector<resources::tex> texture_stack_;
+    bool frozen_ = false;
+    uint32_t version_ = 0;
 };
 
 using draw_buffer_ptr = std::shared_ptr<draw_buffer>;
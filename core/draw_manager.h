@@ -2,33 +2,53 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include "buffer_registry.h"
+#include "draw_buffer.h"
 #include "draw_types.h"
 
 namespace resources { struct font; }
 
 namespace core {
 
-class draw_buffer;
+// finished contents of a buffer, immutable once submitted, so the thread that
+// recorded it and the render thread drawing it never share mutable state
+using frame_packet = std::shared_ptr<const draw_buffer>;
 
 class draw_manager {
 public:
     virtual ~draw_manager() = default;
 
-    // buffer management
-    virtual size_t register_buffer(size_t init_priority) = 0;
-    virtual size_t register_child_buffer(size_t parent, size_t priority) = 0;
-    virtual void update_child_priority(size_t child_idx, size_t new_priority) = 0;
-    virtual void update_buffer_priority(size_t buffer_idx, size_t new_priority) = 0;
-    virtual void remove_buffer(size_t idx) = 0;
-    virtual draw_buffer* get_buffer(size_t idx) = 0;
-    virtual void swap_buffers(size_t idx) = 0;
+    // buffer management. ids are generational handles (see buffer_registry):
+    // a removed buffer's id stays stale instead of aliasing a newer buffer
+    virtual buffer_id register_buffer(size_t init_priority) = 0;
+    virtual buffer_id register_child_buffer(buffer_id parent, size_t priority) = 0;
+    virtual void update_child_priority(buffer_id child, size_t new_priority) = 0;
+    virtual void update_buffer_priority(buffer_id buffer, size_t new_priority) = 0;
+    virtual void remove_buffer(buffer_id buffer) = 0;
+    // in-place contents, for the render thread (the one that draws) only:
+    // draw reads them without a copy. other threads go through submit
+    virtual draw_buffer* get_buffer(buffer_id buffer) = 0;
+    virtual void swap_buffers(buffer_id buffer) = 0;
+
+    // submission from any thread: record into a draw_buffer you own, then hand
+    // it over. submit never waits on rendering or on other producers; the
+    // render thread takes the latest packet of each buffer at its next draw.
+    // once a buffer got a packet, that is drawn instead of its get_buffer
+    // contents. packets for a removed buffer are dropped.
+    // a frozen buffer or packet (draw_buffer::freeze) is uploaded once and
+    // drawn by reference until it changes version, thaws, or a new packet or
+    // swap_buffers replaces it; only the others cost an upload every frame
+    virtual void submit(buffer_id buffer, frame_packet packet) = 0;
+    void submit(buffer_id buffer, draw_buffer&& contents) {
+        submit(buffer, std::make_shared<const draw_buffer>(std::move(contents)));
+    }
     
     // font management
     virtual resources::font* add_font(const char* file, float size, bool italic, bool bold, int rasterizer_flags) = 0;
     virtual void remove_font(const resources::font* font_ptr) = 0;
     
     // matrix operations
-    virtual void update_matrix_translate(size_t buffer, const position& xy_translate, size_t cmd_idx) = 0;
+    virtual void update_matrix_translate(buffer_id buffer, const position& xy_translate, size_t cmd_idx) = 0;
     
     // initialization
     virtual void init() = 0;
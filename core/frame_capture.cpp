@@ -0,0 +1,433 @@
+#include "frame_capture.h"
+#include "../resources/cpu_texture.h"
+#include "../resources/face_cache.h"
+#include "../resources/font.h"
+#include "../utils/hash.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+namespace core {
+
+namespace {
+constexpr char MAGIC[4] = {'F', 'V', 'F', 'C'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t DATA_ALIGN = 16;
+constexpr uint32_t MAX_TEXTURE_SIZE = 16384;
+
+struct file_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t frame_count;
+    uint32_t texture_count;
+    uint32_t buffer_count;
+    uint32_t command_count;
+    uint32_t vertex_size; // sizeof(vertex) of the writer
+    uint32_t reserved;
+    uint64_t checksum; // over everything after the header
+};
+
+struct texture_record {
+    uint32_t width, height;
+    uint32_t format;
+    uint32_t captured; // pixels present
+    uint64_t offset, bytes;
+};
+
+struct frame_record {
+    uint64_t number;
+    uint32_t first_buffer, buffer_count;
+};
+
+struct buffer_record {
+    uint64_t vertex_offset, index_offset;
+    uint32_t vertex_count, index_count;
+    uint32_t first_command, command_count;
+};
+
+static_assert(std::is_trivially_copyable_v<file_header> && sizeof(file_header) == 40);
+static_assert(std::is_trivially_copyable_v<texture_record> && sizeof(texture_record) == 32);
+static_assert(std::is_trivially_copyable_v<frame_record> && sizeof(frame_record) == 16);
+static_assert(std::is_trivially_copyable_v<buffer_record> && sizeof(buffer_record) == 32);
+static_assert(std::is_trivially_copyable_v<vertex> && sizeof(vertex) == 24);
+
+size_t align_up(size_t v) { return (v + DATA_ALIGN - 1) & ~(DATA_ALIGN - 1); }
+
+void copy_rect(const rect& r, float (&out)[4]) {
+    out[0] = r.xy.x;
+    out[1] = r.xy.y;
+    out[2] = r.zw.x;
+    out[3] = r.zw.y;
+}
+} // namespace
+
+frame_capture::frame_capture(size_t window) : _window(std::max<size_t>(window, 1)) {}
+
+void frame_capture::set_window(size_t frames) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _window = std::max<size_t>(frames, 1);
+    while (_frames.size() > _window) _frames.pop_front();
+}
+
+size_t frame_capture::window() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _window;
+}
+
+void frame_capture::begin_frame() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // the oldest frame's vectors are reused for the new one
+    frame next;
+    if (_frames.size() >= _window) {
+        next = std::move(_frames.front());
+        _frames.pop_front();
+        next.buffers.clear();
+        next.textures.clear();
+    }
+    next.number = _next_frame++;
+    _frames.push_back(std::move(next));
+}
+
+void frame_capture::record(const draw_buffer& buf) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_frames.empty()) {
+        frame first;
+        first.number = _next_frame++;
+        _frames.push_back(std::move(first));
+    }
+    frame& target = _frames.back();
+    buffer& out = target.buffers.emplace_back();
+    out.vertices = buf.vertices;
+    out.indices = buf.indices;
+    out.commands.reserve(buf.cmds.size());
+    for (const auto& cmd : buf.cmds) {
+        command& rec = out.commands.emplace_back();
+        rec.elem_count = cmd.elem_count;
+        rec.type = cmd.type;
+        rec.flags = (cmd.font_texture ? command::font_texture : 0) | (cmd.native_texture ? command::native_texture : 0) |
+                    (cmd.circle_scissor ? command::circle_scissor : 0) | (cmd.callback ? command::has_callback : 0);
+        if (cmd.font) rec.flags |= (cmd.font->is_sdf() ? command::sdf : 0) | (cmd.font->is_mcsdf() ? command::msdf : 0);
+        rec.blur_strength = cmd.blur_strength;
+        rec.pass_count = cmd.pass_count;
+        rec.texture = capture_texture(cmd, target);
+        copy_rect(cmd.clip_rect, rec.clip_rect);
+        copy_rect(cmd.circle_outer_clip, rec.circle_outer_clip);
+        rec.key_color[0] = cmd.key_color.x;
+        rec.key_color[1] = cmd.key_color.y;
+        rec.key_color[2] = cmd.key_color.z;
+        rec.key_color[3] = cmd.key_color.w;
+        std::strncpy(rec.shader_hint, cmd.shader_hint.c_str(), sizeof(rec.shader_hint) - 1);
+    }
+}
+
+int32_t frame_capture::capture_texture(const draw_command& cmd, frame& target) {
+    const resources::tex& tex = cmd.texture;
+    if (!tex) return -1;
+
+    // current pixels come from the font's atlas page, whose generation says
+    // when they changed, or from a cpu texture; gpu textures keep their size only
+    const resources::atlas_page* page = nullptr;
+    std::unique_lock<std::mutex> atlas_lock;
+    if (cmd.type == geometry_type::font_atlas && cmd.font) {
+        auto& atlas = *cmd.font->atlas();
+        atlas_lock = std::unique_lock<std::mutex>(atlas.mutex());
+        for (const auto& p : atlas.pages()) {
+            if (p.texture() == tex) {
+                page = &p;
+                break;
+            }
+        }
+    }
+    const auto* cpu = page ? nullptr : dynamic_cast<const resources::cpu_texture*>(tex.get());
+    const uint64_t generation = page ? page->generation() : cpu ? cpu->upload_count() : 0;
+
+    auto& cached = _textures[tex.get()];
+    if (!cached.data || cached.owner.lock() != tex || cached.generation != generation) {
+        auto data = std::make_shared<texture_data>();
+        data->width = tex->width();
+        data->height = tex->height();
+        data->format = tex->format();
+        if (page) {
+            data->pixels.assign(page->pixels().begin(), page->pixels().end());
+        } else if (cpu) {
+            data->pixels = cpu->data();
+        }
+        cached.owner = tex;
+        cached.generation = generation;
+        cached.data = std::move(data);
+    }
+    if (atlas_lock) atlas_lock.unlock();
+
+    auto it = std::find(target.textures.begin(), target.textures.end(), cached.data);
+    if (it != target.textures.end()) return static_cast<int32_t>(it - target.textures.begin());
+    target.textures.push_back(cached.data);
+    return static_cast<int32_t>(target.textures.size() - 1);
+}
+
+void frame_capture::end_frame() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // forget textures that were destroyed; their pixels live on in the frames
+    // that used them
+    std::erase_if(_textures, [](const auto& entry) { return entry.second.owner.expired(); });
+}
+
+size_t frame_capture::frame_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _frames.size();
+}
+
+size_t frame_capture::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t bytes = 0;
+    std::unordered_set<const texture_data*> seen;
+    for (const auto& f : _frames) {
+        for (const auto& b : f.buffers) {
+            bytes += b.vertices.size() * sizeof(vertex) + b.indices.size() * sizeof(uint32_t) + b.commands.size() * sizeof(command);
+        }
+        for (const auto& t : f.textures) {
+            if (seen.insert(t.get()).second) bytes += t->pixels.size();
+        }
+    }
+    return bytes;
+}
+
+std::vector<frame_capture::frame> frame_capture::frames() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return {_frames.begin(), _frames.end()};
+}
+
+void frame_capture::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frames.clear();
+    _textures.clear();
+}
+
+bool frame_capture::save(const std::string& path) const {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_frames.empty()) return false;
+
+    // textures shared between frames are written once; commands are remapped
+    // from per-frame to file-wide texture indices
+    std::vector<const texture_data*> textures;
+    std::unordered_map<const texture_data*, int32_t> texture_index;
+    size_t buffer_count = 0, command_count = 0;
+    for (const auto& f : _frames) {
+        for (const auto& t : f.textures) {
+            if (texture_index.emplace(t.get(), static_cast<int32_t>(textures.size())).second) textures.push_back(t.get());
+        }
+        buffer_count += f.buffers.size();
+        for (const auto& b : f.buffers) command_count += b.commands.size();
+    }
+
+    // layout: header, texture, frame, buffer and command tables, then aligned
+    // vertex, index and pixel data
+    const size_t textures_at = sizeof(file_header);
+    const size_t frames_at = textures_at + textures.size() * sizeof(texture_record);
+    const size_t buffers_at = frames_at + _frames.size() * sizeof(frame_record);
+    const size_t commands_at = buffers_at + buffer_count * sizeof(buffer_record);
+    size_t offset = align_up(commands_at + command_count * sizeof(command));
+
+    std::vector<texture_record> texture_table;
+    texture_table.reserve(textures.size());
+    for (const auto* t : textures) {
+        texture_record rec = {};
+        rec.width = t->width;
+        rec.height = t->height;
+        rec.format = static_cast<uint32_t>(t->format);
+        rec.captured = t->pixels.empty() ? 0 : 1;
+        rec.offset = offset;
+        rec.bytes = t->pixels.size();
+        texture_table.push_back(rec);
+        offset = align_up(offset + t->pixels.size());
+    }
+    std::vector<frame_record> frame_table;
+    std::vector<buffer_record> buffer_table;
+    buffer_table.reserve(buffer_count);
+    uint32_t first_command = 0;
+    for (const auto& f : _frames) {
+        frame_table.push_back({f.number, static_cast<uint32_t>(buffer_table.size()), static_cast<uint32_t>(f.buffers.size())});
+        for (const auto& b : f.buffers) {
+            buffer_record rec = {};
+            rec.vertex_offset = offset;
+            rec.vertex_count = static_cast<uint32_t>(b.vertices.size());
+            offset = align_up(offset + b.vertices.size() * sizeof(vertex));
+            rec.index_offset = offset;
+            rec.index_count = static_cast<uint32_t>(b.indices.size());
+            offset = align_up(offset + b.indices.size() * sizeof(uint32_t));
+            rec.first_command = first_command;
+            rec.command_count = static_cast<uint32_t>(b.commands.size());
+            first_command += rec.command_count;
+            buffer_table.push_back(rec);
+        }
+    }
+
+    std::vector<unsigned char> blob(offset, 0);
+    std::memcpy(blob.data() + textures_at, texture_table.data(), texture_table.size() * sizeof(texture_record));
+    std::memcpy(blob.data() + frames_at, frame_table.data(), frame_table.size() * sizeof(frame_record));
+    std::memcpy(blob.data() + buffers_at, buffer_table.data(), buffer_table.size() * sizeof(buffer_record));
+    for (size_t i = 0; i < textures.size(); ++i) {
+        if (!textures[i]->pixels.empty()) {
+            std::memcpy(blob.data() + texture_table[i].offset, textures[i]->pixels.data(), textures[i]->pixels.size());
+        }
+    }
+    size_t at = commands_at;
+    size_t buffer = 0;
+    for (const auto& f : _frames) {
+        for (const auto& b : f.buffers) {
+            const auto& rec = buffer_table[buffer++];
+            if (!b.vertices.empty()) std::memcpy(blob.data() + rec.vertex_offset, b.vertices.data(), b.vertices.size() * sizeof(vertex));
+            if (!b.indices.empty()) std::memcpy(blob.data() + rec.index_offset, b.indices.data(), b.indices.size() * sizeof(uint32_t));
+            for (command cmd : b.commands) {
+                if (cmd.texture >= 0) cmd.texture = texture_index[f.textures[cmd.texture].get()];
+                std::memcpy(blob.data() + at, &cmd, sizeof(cmd));
+                at += sizeof(cmd);
+            }
+        }
+    }
+    const size_t frame_count = _frames.size();
+    lock.unlock();
+
+    file_header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.frame_count = static_cast<uint32_t>(frame_count);
+    header.texture_count = static_cast<uint32_t>(textures.size());
+    header.buffer_count = static_cast<uint32_t>(buffer_count);
+    header.command_count = static_cast<uint32_t>(command_count);
+    header.vertex_size = sizeof(vertex);
+    header.checksum = utils::hash_bytes(blob.data() + sizeof(file_header), blob.size() - sizeof(file_header));
+    std::memcpy(blob.data(), &header, sizeof(header));
+
+    const std::string temp = path + ".tmp";
+    std::error_code ec;
+    const auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            utils::log_warn("frame capture: cannot write %s", temp.c_str());
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        if (!out) {
+            utils::log_warn("frame capture: short write to %s", temp.c_str());
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        utils::log_warn("frame capture: cannot replace %s: %s", path.c_str(), ec.message().c_str());
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    utils::log_info("frame capture: wrote %zu frames (%zu bytes) to %s", frame_count, blob.size(), path.c_str());
+    return true;
+}
+
+bool frame_capture::reader::open(const std::string& path) {
+    _frames.clear();
+    _textures.clear();
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) return false;
+    _file = resources::font_file::map(path);
+    if (!_file) return false;
+
+    auto reject = [&](const char* why) {
+        utils::log_warn("frame capture: ignoring %s (%s)", path.c_str(), why);
+        _file.reset();
+        _frames.clear();
+        _textures.clear();
+        return false;
+    };
+
+    const unsigned char* base = _file->data();
+    const size_t size = _file->size();
+    if (size < sizeof(file_header)) return reject("truncated header");
+    file_header header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return reject("bad magic");
+    if (header.version != VERSION) return reject("unsupported version");
+    if (header.vertex_size != sizeof(vertex)) return reject("vertex layout mismatch");
+
+    const size_t textures_at = sizeof(file_header);
+    const size_t frames_at = textures_at + static_cast<size_t>(header.texture_count) * sizeof(texture_record);
+    const size_t buffers_at = frames_at + static_cast<size_t>(header.frame_count) * sizeof(frame_record);
+    const size_t commands_at = buffers_at + static_cast<size_t>(header.buffer_count) * sizeof(buffer_record);
+    const size_t tables_end = commands_at + static_cast<size_t>(header.command_count) * sizeof(command);
+    if (tables_end > size) return reject("truncated tables");
+    if (utils::hash_bytes(base + sizeof(file_header), size - sizeof(file_header)) != header.checksum) {
+        return reject("checksum mismatch");
+    }
+    // data is read in place: the mapping is page aligned and offsets are 16 byte aligned
+    auto in_bounds = [&](uint64_t offset, uint64_t bytes) {
+        return offset >= tables_end && offset % DATA_ALIGN == 0 && offset <= size && bytes <= size - offset;
+    };
+
+    _textures.reserve(header.texture_count);
+    for (uint32_t i = 0; i < header.texture_count; ++i) {
+        texture_record rec;
+        std::memcpy(&rec, base + textures_at + i * sizeof(texture_record), sizeof(rec));
+        if (rec.format > static_cast<uint32_t>(resources::texture_format::r8)) return reject("bad texture format");
+        if (rec.width > MAX_TEXTURE_SIZE || rec.height > MAX_TEXTURE_SIZE) return reject("bad texture size");
+        texture_view view;
+        view.width = rec.width;
+        view.height = rec.height;
+        view.format = static_cast<resources::texture_format>(rec.format);
+        if (rec.captured) {
+            const uint64_t bytes = static_cast<uint64_t>(rec.width) * rec.height * resources::bytes_per_texel(view.format);
+            if (rec.bytes != bytes || !in_bounds(rec.offset, bytes)) return reject("texture out of bounds");
+            view.pixels = base + rec.offset;
+        }
+        _textures.push_back(view);
+    }
+
+    const auto* commands = reinterpret_cast<const command*>(base + commands_at);
+    std::vector<buffer_record> buffers(header.buffer_count);
+    if (!buffers.empty()) std::memcpy(buffers.data(), base + buffers_at, buffers.size() * sizeof(buffer_record));
+    _frames.reserve(header.frame_count);
+    for (uint32_t i = 0; i < header.frame_count; ++i) {
+        frame_record rec;
+        std::memcpy(&rec, base + frames_at + i * sizeof(frame_record), sizeof(rec));
+        if (rec.first_buffer > header.buffer_count || rec.buffer_count > header.buffer_count - rec.first_buffer) {
+            return reject("bad frame buffers");
+        }
+        frame_view view;
+        view.number = rec.number;
+        for (uint32_t b = rec.first_buffer; b < rec.first_buffer + rec.buffer_count; ++b) {
+            const auto& buf = buffers[b];
+            if (!in_bounds(buf.vertex_offset, static_cast<uint64_t>(buf.vertex_count) * sizeof(vertex)) ||
+                !in_bounds(buf.index_offset, static_cast<uint64_t>(buf.index_count) * sizeof(uint32_t))) {
+                return reject("buffer out of bounds");
+            }
+            if (buf.first_command > header.command_count || buf.command_count > header.command_count - buf.first_command) {
+                return reject("bad buffer commands");
+            }
+            buffer_view bv;
+            bv.vertices = reinterpret_cast<const vertex*>(base + buf.vertex_offset);
+            bv.vertex_count = buf.vertex_count;
+            bv.indices = reinterpret_cast<const uint32_t*>(base + buf.index_offset);
+            bv.index_count = buf.index_count;
+            bv.commands = commands + buf.first_command;
+            bv.command_count = buf.command_count;
+            // everything a replay dereferences is checked once here
+            uint64_t elements = 0;
+            for (uint32_t c = 0; c < bv.command_count; ++c) {
+                const auto& cmd = bv.commands[c];
+                if (cmd.texture < -1 || cmd.texture >= static_cast<int32_t>(header.texture_count)) return reject("bad command texture");
+                elements += cmd.elem_count;
+            }
+            if (elements > bv.index_count) return reject("commands past the index data");
+            for (uint32_t k = 0; k < bv.index_count; ++k) {
+                if (bv.indices[k] >= bv.vertex_count) return reject("index out of range");
+            }
+            view.buffers.push_back(bv);
+        }
+        _frames.push_back(std::move(view));
+    }
+    return true;
+}
+
+} // namespace core
@@ -0,0 +1,135 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "draw_types.h"
+#include "draw_buffer.h"
+#include "../resources/texture.h"
+
+namespace resources { class font_file; }
+
+namespace core {
+
+// the draw_buffers submitted in the last N frames, for reproducing what was
+// drawn without the app. recording copies vertices, indices and flattened
+// commands; texture pixels are copied only when a texture changed since it
+// was last captured and are shared by every frame that uses them. save()
+// writes the window to a little-endian file that reader maps read-only
+class frame_capture {
+public:
+    // a draw_command without its resources: texture is an index into the
+    // capture's texture table (-1 for none), callbacks are only flagged
+    struct command {
+        enum : uint8_t {
+            font_texture = 1,
+            native_texture = 2,
+            circle_scissor = 4,
+            has_callback = 8,
+            sdf = 16,  // font commands: the font was a distance field font
+            msdf = 32,
+        };
+        uint32_t elem_count = 0;
+        geometry_type type = geometry_type::color_only;
+        uint8_t flags = 0;
+        uint8_t blur_strength = 0;
+        uint8_t pass_count = 0;
+        int32_t texture = -1;
+        float clip_rect[4] = {};
+        float circle_outer_clip[4] = {};
+        float key_color[4] = {};
+        char shader_hint[16] = {}; // truncated, nul terminated
+    };
+    static_assert(std::is_trivially_copyable_v<command> && sizeof(command) == 76);
+
+    struct texture_data {
+        uint32_t width = 0, height = 0;
+        resources::texture_format format = resources::texture_format::rgba8;
+        std::vector<uint8_t> pixels; // empty when the texture lives on the gpu only
+    };
+
+    struct buffer {
+        std::vector<vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<command> commands; // texture indexes the frame's textures
+    };
+
+    struct frame {
+        uint64_t number = 0;
+        std::vector<buffer> buffers;
+        std::vector<std::shared_ptr<const texture_data>> textures;
+    };
+
+    explicit frame_capture(size_t window = 120);
+
+    // frames kept; older ones are dropped as new ones begin
+    void set_window(size_t frames);
+    size_t window() const;
+
+    // hooks for a renderer (see renderer::set_capture): call record for every
+    // buffer it draws, after the font atlases were flushed
+    void begin_frame();
+    void record(const draw_buffer& buf);
+    void end_frame();
+
+    size_t frame_count() const;
+    size_t memory_bytes() const; // vertices, indices, commands and unique texture pixels
+    std::vector<frame> frames() const; // copy of the window, oldest first
+    void clear();
+
+    // writes the window, via a temporary file and a rename
+    bool save(const std::string& path) const;
+
+    // a validated, mapped capture file. views point into the mapping and stay
+    // valid while the reader lives
+    class reader {
+    public:
+        struct texture_view {
+            uint32_t width = 0, height = 0;
+            resources::texture_format format = resources::texture_format::rgba8;
+            const uint8_t* pixels = nullptr; // nullptr when not captured
+        };
+        struct buffer_view {
+            const vertex* vertices = nullptr;
+            uint32_t vertex_count = 0;
+            const uint32_t* indices = nullptr;
+            uint32_t index_count = 0;
+            const command* commands = nullptr; // texture indexes textures()
+            uint32_t command_count = 0;
+        };
+        struct frame_view {
+            uint64_t number = 0;
+            std::vector<buffer_view> buffers;
+        };
+
+        bool open(const std::string& path);
+        const std::vector<frame_view>& frames() const { return _frames; }
+        const std::vector<texture_view>& textures() const { return _textures; }
+
+    private:
+        std::shared_ptr<resources::font_file> _file;
+        std::vector<frame_view> _frames;
+        std::vector<texture_view> _textures;
+    };
+
+private:
+    // last capture of a texture; a new copy is taken when its generation moves
+    struct cached_texture {
+        std::weak_ptr<resources::texture> owner;
+        uint64_t generation = 0;
+        std::shared_ptr<const texture_data> data;
+    };
+    int32_t capture_texture(const draw_command& cmd, frame& target);
+
+    mutable std::mutex _mutex;
+    std::deque<frame> _frames;
+    std::unordered_map<const resources::texture*, cached_texture> _textures;
+    size_t _window;
+    uint64_t _next_frame = 0;
+};
+
+} // namespace core
@@ -0,0 +1,205 @@
+#include "frame_merge.h"
+#include "renderer.h"
+#include "../resources/font.h"
+#include "../utils/logger.h"
+#include "../utils/profiler.h"
+#include "../utils/thread_pool.h"
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <vector>
+
+namespace core {
+
+namespace {
+// vertices plus indices copied by one task. smaller frames stay on the calling
+// thread, where handing work to the pool would cost more than the copy
+constexpr size_t MERGE_CHUNK = 32768;
+
+// a slice of one source buffer and where that buffer lands in the frame
+struct merge_job {
+    const draw_buffer* src;
+    uint32_t vertex_base;
+    uint32_t index_base;
+    uint32_t vtx_begin, vtx_end;
+    uint32_t idx_begin, idx_end;
+
+    size_t work() const { return (vtx_end - vtx_begin) + (idx_end - idx_begin); }
+};
+
+void run(const merge_job& job, draw_buffer& out) {
+    std::copy(job.src->vertices.begin() + job.vtx_begin, job.src->vertices.begin() + job.vtx_end,
+              out.vertices.begin() + job.vertex_base + job.vtx_begin);
+    const uint32_t* src = job.src->indices.data();
+    uint32_t* dst = out.indices.data() + job.index_base;
+    for (uint32_t i = job.idx_begin; i < job.idx_end; ++i) dst[i] = src[i] + job.vertex_base;
+}
+
+uint32_t split(uint32_t count, size_t piece, size_t pieces) {
+    return static_cast<uint32_t>(static_cast<uint64_t>(count) * piece / pieces);
+}
+} // namespace
+
+bool merge_buffers(std::span<const draw_buffer* const> buffers, draw_buffer& out, utils::thread_pool* pool) {
+    FV_PROFILE_SCOPE("merge_buffers");
+    out.vertices.clear();
+    out.indices.clear();
+    out.cmds.clear();
+
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+    size_t cmd_count = 0;
+    for (const draw_buffer* buf : buffers) {
+        if (!buf) continue;
+        vertex_count += buf->vertices.size();
+        index_count += buf->indices.size();
+        cmd_count += buf->cmds.size();
+    }
+    if (vertex_count > std::numeric_limits<uint32_t>::max() || index_count > std::numeric_limits<uint32_t>::max()) {
+        utils::log_error("merge_buffers: %zu vertices and %zu indices do not fit 32-bit indices", vertex_count, index_count);
+        return false;
+    }
+    out.vertices.resize(vertex_count);
+    out.indices.resize(index_count);
+    out.cmds.reserve(cmd_count);
+
+    // large buffers are sliced so no task gets much more than a chunk
+    std::vector<merge_job> jobs;
+    jobs.reserve(buffers.size());
+    uint32_t vertex_base = 0;
+    uint32_t index_base = 0;
+    for (const draw_buffer* buf : buffers) {
+        if (!buf) continue;
+        const auto [vertices, indices] = buf->vtx_idx_count();
+        const size_t pieces = std::max<size_t>(1, (static_cast<size_t>(vertices) + indices + MERGE_CHUNK - 1) / MERGE_CHUNK);
+        for (size_t k = 0; k < pieces && vertices + indices > 0; ++k) {
+            jobs.push_back({buf, vertex_base, index_base,
+                            split(vertices, k, pieces), split(vertices, k + 1, pieces),
+                            split(indices, k, pieces), split(indices, k + 1, pieces)});
+        }
+        vertex_base += vertices;
+        index_base += indices;
+    }
+
+    // contiguous runs of about a chunk each; the first one runs here
+    auto& workers = pool ? *pool : utils::thread_pool::shared();
+    std::vector<size_t> batch_ends;
+    if (vertex_count + index_count >= 2 * MERGE_CHUNK && !workers.in_worker()) {
+        size_t work = 0;
+        for (size_t j = 0; j < jobs.size(); ++j) {
+            work += jobs[j].work();
+            if (work >= MERGE_CHUNK) {
+                batch_ends.push_back(j + 1);
+                work = 0;
+            }
+        }
+    }
+    if (batch_ends.empty() || batch_ends.back() != jobs.size()) batch_ends.push_back(jobs.size());
+
+    auto run_batch = [&](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j) run(jobs[j], out);
+    };
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(batch_ends.size() - 1);
+    for (size_t b = 1; b < batch_ends.size(); ++b) {
+        tasks.push_back(workers.async([&run_batch, begin = batch_ends[b - 1], end = batch_ends[b]]() {
+            FV_PROFILE_SCOPE("merge_buffers::chunk");
+            run_batch(begin, end);
+        }));
+    }
+
+    // commands are copied here while the workers copy geometry: they hold
+    // fonts and textures whose reference counts would bounce between threads
+    for (const draw_buffer* buf : buffers) {
+        if (buf) out.cmds.insert(out.cmds.end(), buf->cmds.begin(), buf->cmds.end());
+    }
+    run_batch(0, batch_ends.front());
+    for (auto& task : tasks) task.get();
+    return true;
+}
+
+frame_builder::~frame_builder() {
+    for (const auto& [id, copy] : _retained) unpin(copy);
+}
+
+void frame_builder::invalidate(buffer_id id) {
+    auto it = _retained.find(id);
+    if (it != _retained.end()) it->second.stale = true;
+}
+
+void frame_builder::draw(renderer& r) {
+    FV_PROFILE_SCOPE("frame_builder::draw");
+    for (auto& [id, copy] : _retained) copy.drawn = false;
+
+    for (const item& it : _items) {
+        const draw_buffer& buf = *it.buf;
+        const bool empty = buf.vertices.empty() || buf.indices.empty();
+        auto copy = _retained.find(it.id);
+        // the renderer's copy no longer matches what the buffer holds
+        if (copy != _retained.end() &&
+            (!buf.frozen() || empty || copy->second.stale || copy->second.version != buf.version())) {
+            r.release_retained(it.id);
+            unpin(copy->second);
+            _retained.erase(copy);
+            copy = _retained.end();
+        }
+        if (empty) continue;
+        if (!buf.frozen()) {
+            _run.push_back(&buf);
+            continue;
+        }
+
+        // draw order holds across the kinds: dynamic buffers before this one go first
+        flush_run(r);
+        if (copy == _retained.end()) {
+            copy = _retained.emplace(it.id, retained_copy{buf.version(), false, false, {}}).first;
+            pin(it.id, buf, copy->second);
+        }
+        r.draw_retained(it.id, &buf);
+        copy->second.drawn = true;
+    }
+    flush_run(r);
+    _items.clear();
+
+    std::erase_if(_retained, [&](const auto& entry) {
+        if (entry.second.drawn) return false;
+        r.release_retained(entry.first);
+        unpin(entry.second);
+        return true;
+    });
+}
+
+void frame_builder::pin(buffer_id id, const draw_buffer& buf, retained_copy& copy) {
+    // pinned first: once pinned, a page still valid for the command stays so
+    bool lost = false;
+    for (const auto& cmd : buf.cmds) {
+        if (cmd.type != geometry_type::font_atlas || !cmd.font || cmd.atlas_page < 0) continue;
+        auto atlas = cmd.font->atlas();
+        const bool known = std::any_of(copy.pins.begin(), copy.pins.end(), [&](const auto& pin) {
+            return pin.first == atlas && pin.second == cmd.atlas_page;
+        });
+        if (!known) {
+            atlas->pin_page(cmd.atlas_page);
+            copy.pins.emplace_back(std::move(atlas), cmd.atlas_page);
+        }
+        lost = lost || !cmd.font->atlas_valid_since(cmd.font_frame, cmd.atlas_page);
+    }
+    if (lost) utils::log_warn("frame_builder: frozen buffer %llu has text whose glyphs were evicted before it was drawn; record it again", static_cast<unsigned long long>(id));
+}
+
+void frame_builder::unpin(const retained_copy& copy) {
+    for (const auto& [atlas, page] : copy.pins) atlas->unpin_page(page);
+}
+
+void frame_builder::flush_run(renderer& r) {
+    if (_run.empty()) return;
+    // a lone buffer is drawn as it is, merging would only copy it
+    if (_run.size() == 1) {
+        r.draw_buffer(_run.front());
+    } else if (merge_buffers(_run, _frame)) {
+        r.draw_buffer(&_frame);
+    }
+    _run.clear();
+}
+
+} // namespace core
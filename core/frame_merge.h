@@ -0,0 +1,76 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "buffer_registry.h"
+#include "draw_buffer.h"
+
+namespace utils { class thread_pool; }
+namespace resources { class glyph_atlas; }
+
+namespace core {
+
+// concatenates buffers, in order, into out as one vertex and index stream, so
+// a backend uploads and binds a whole frame once. vertices are copied, indices
+// rebased by their buffer's vertex offset, and commands copied as they are
+// (they address indices sequentially, so they stay valid back to back).
+// large frames are copied in parallel chunks on pool (thread_pool::shared()
+// if null). out keeps its capacity, so a retained frame buffer stops
+// allocating once it has seen the largest frame.
+// false, with out empty, if the frame needs more than 2^32 vertices
+bool merge_buffers(std::span<const draw_buffer* const> buffers, draw_buffer& out, utils::thread_pool* pool = nullptr);
+
+class renderer;
+
+// turns a draw manager's buffers into renderer calls, a frame at a time: add
+// every buffer in draw order, then draw. each run of dynamic buffers between
+// frozen ones (draw_buffer::freeze) is merged and uploaded as one; frozen
+// buffers go through renderer::draw_retained under their id, so they are
+// uploaded once and then drawn by reference until their version changes,
+// they thaw, or invalidate is called. the copy of a buffer that was not added
+// in a frame (it was removed) is released. while a copy is kept, the atlas
+// pages its text samples are pinned (glyph_atlas::pin_page), so eviction
+// never takes glyphs it still draws. not synchronized
+class frame_builder {
+public:
+    frame_builder() = default;
+    frame_builder(const frame_builder&) = delete;
+    frame_builder& operator=(const frame_builder&) = delete;
+    ~frame_builder();
+
+    void add(buffer_id id, const draw_buffer& buf) { _items.push_back({id, &buf}); }
+    // the contents under id were replaced without a version change, e.g. by a
+    // new packet or a fresh buffer in the slot
+    void invalidate(buffer_id id);
+    void draw(renderer& r);
+
+    // frozen buffers the renderer keeps a copy of
+    size_t retained() const { return _retained.size(); }
+
+private:
+    struct item {
+        buffer_id id;
+        const draw_buffer* buf;
+    };
+    struct retained_copy {
+        uint32_t version;
+        bool stale = false;
+        bool drawn = false;
+        std::vector<std::pair<std::shared_ptr<resources::glyph_atlas>, int>> pins;
+    };
+
+    void flush_run(renderer& r);
+    void pin(buffer_id id, const draw_buffer& buf, retained_copy& copy);
+    static void unpin(const retained_copy& copy);
+
+    std::vector<item> _items;
+    std::unordered_map<buffer_id, retained_copy> _retained;
+    // the current run of dynamic buffers, and the frame they are merged into,
+    // kept so its storage is reused from frame to frame
+    std::vector<const draw_buffer*> _run;
+    draw_buffer _frame;
+};
+
+} // namespace core
@@ -0,0 +1,114 @@
+#include "render_stats.h"
+#include "draw_buffer.h"
+#include "../resources/glyph_atlas.h"
+#include "../resources/resource_counters.h"
+#include "../resources/texture.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+
+namespace core {
+
+const char* render_stats::upload_name(upload kind) {
+    switch (kind) {
+        case upload::vertices: return "vertices";
+        case upload::indices: return "indices";
+        case upload::constants: return "constants";
+        case upload::textures: return "textures";
+        case upload::glyph_atlas: return "glyph_atlas";
+        default: return "unknown";
+    }
+}
+
+uint64_t render_stats::total_uploaded_bytes() const {
+    uint64_t total = 0;
+    for (uint64_t bytes : uploaded) total += bytes;
+    return total;
+}
+
+std::string render_stats::to_json() const {
+    char buf[1024];
+    int n = std::snprintf(buf, sizeof(buf),
+        "{\"frame\":%llu,\"cpu_ms\":%.3f,\"buffers\":%u,\"retained_buffers\":%u,\"commands\":%u,\"merged_commands\":%u,\"draw_calls\":%u,"
+        "\"state_changes\":%u,\"vertices\":%llu,\"indices\":%llu,\"triangles\":%llu,\"pixels\":%llu,\"uploaded\":{",
+        static_cast<unsigned long long>(frame), cpu_ms, buffers, retained_buffers, commands, merged_commands, draw_calls, state_changes,
+        static_cast<unsigned long long>(vertices), static_cast<unsigned long long>(indices),
+        static_cast<unsigned long long>(triangles), static_cast<unsigned long long>(pixels));
+    std::string json(buf, n);
+    for (size_t i = 0; i < uploaded.size(); ++i) {
+        n = std::snprintf(buf, sizeof(buf), "%s\"%s\":%llu", i ? "," : "", upload_name(static_cast<upload>(i)),
+                          static_cast<unsigned long long>(uploaded[i]));
+        json.append(buf, n);
+    }
+    n = std::snprintf(buf, sizeof(buf),
+        "},\"glyph_hits\":%llu,\"glyph_misses\":%llu,\"glyph_rasterizations\":%llu,\"atlas_pages\":%u,"
+        "\"atlas_bytes\":%llu,\"atlas_used_bytes\":%llu,\"atlas_occupancy\":%.4f,\"textures\":%u,\"texture_bytes\":%llu,"
+        "\"resident_texture_bytes\":%llu,\"buffer_allocations\":%u,\"texture_allocations\":%u}",
+        static_cast<unsigned long long>(glyph_hits), static_cast<unsigned long long>(glyph_misses),
+        static_cast<unsigned long long>(glyph_rasterizations), atlas_pages, static_cast<unsigned long long>(atlas_bytes),
+        static_cast<unsigned long long>(atlas_used_bytes), atlas_occupancy(), textures,
+        static_cast<unsigned long long>(texture_bytes), static_cast<unsigned long long>(resident_texture_bytes),
+        buffer_allocations, texture_allocations);
+    json.append(buf, n);
+    return json;
+}
+
+render_stats_recorder::render_stats_recorder() : _last(read_totals()), _begin(std::chrono::steady_clock::now()) {}
+
+render_stats_recorder::totals render_stats_recorder::read_totals() {
+    const auto& c = resources::resource_counters::shared();
+    auto load = [](const std::atomic<uint64_t>& v) { return v.load(std::memory_order_relaxed); };
+    return {load(c.glyph_hits), load(c.glyph_misses), load(c.glyph_rasterizations),
+            load(c.texture_upload_bytes), load(c.atlas_upload_bytes), load(c.textures_created)};
+}
+
+void render_stats_recorder::begin_frame() {
+    _stats = {};
+    _stats.frame = _frames;
+    _seen.clear();
+    _begin = std::chrono::steady_clock::now();
+}
+
+void render_stats_recorder::end_frame(const resources::texture_dict* dict) {
+    _stats.cpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _begin).count();
+    const totals now = read_totals();
+    _stats.glyph_hits = now.glyph_hits - _last.glyph_hits;
+    _stats.glyph_misses = now.glyph_misses - _last.glyph_misses;
+    _stats.glyph_rasterizations = now.glyph_rasterizations - _last.glyph_rasterizations;
+    const uint64_t texture_bytes = now.texture_upload_bytes - _last.texture_upload_bytes;
+    const uint64_t atlas_bytes = now.atlas_upload_bytes - _last.atlas_upload_bytes;
+    // a backend may send atlas rectangles a frame after the flush queued them
+    _stats.uploaded_bytes(render_stats::upload::glyph_atlas) += atlas_bytes;
+    _stats.uploaded_bytes(render_stats::upload::textures) += texture_bytes - std::min(texture_bytes, atlas_bytes);
+    _stats.texture_allocations += static_cast<uint32_t>(now.textures_created - _last.textures_created);
+    if (dict) _stats.resident_texture_bytes = dict->memory_bytes();
+    _last = now;
+    ++_frames;
+}
+
+void render_stats_recorder::count_buffer(const draw_buffer& buf) {
+    ++_stats.buffers;
+    _stats.vertices += buf.vertices.size();
+    _stats.indices += buf.indices.size();
+}
+
+void render_stats_recorder::use_texture(const resources::texture* tex) {
+    if (!tex || std::find(_seen.begin(), _seen.end(), tex) != _seen.end()) return;
+    _seen.push_back(tex);
+    ++_stats.textures;
+    _stats.texture_bytes += static_cast<uint64_t>(tex->width()) * tex->height() * resources::bytes_per_texel(tex->format());
+}
+
+void render_stats_recorder::use_atlas(resources::glyph_atlas& atlas) {
+    if (std::find(_seen.begin(), _seen.end(), &atlas) != _seen.end()) return;
+    _seen.push_back(&atlas);
+    // other fonts on the atlas may be packing
+    std::lock_guard<std::mutex> lock(atlas.mutex());
+    for (const auto& page : atlas.pages()) {
+        ++_stats.atlas_pages;
+        _stats.atlas_bytes += page.pixels().size();
+        _stats.atlas_used_bytes += page.used_area() * page.bytes_per_pixel();
+    }
+}
+
+} // namespace core
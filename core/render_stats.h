@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace resources {
+class texture;
+class texture_dict;
+class glyph_atlas;
+} // namespace resources
+
+namespace core {
+
+class draw_buffer;
+
+// what a renderer did in one frame (see renderer::stats). submission counts
+// are the backend's; glyph, upload and allocation counts are taken from
+// resources::resource_counters between two end_frame calls, so they include
+// the text recorded before the frame began
+struct render_stats {
+    enum class upload : uint8_t { vertices, indices, constants, textures, glyph_atlas, count };
+    static const char* upload_name(upload kind);
+
+    uint64_t frame = 0; // renderer frames ended before this one
+    double cpu_ms = 0.0; // begin_frame to end_frame, the backend's own time
+
+    // submission
+    uint32_t buffers = 0;
+    uint32_t retained_buffers = 0; // of those, static ones drawn from a kept copy (see renderer::draw_retained)
+    uint32_t commands = 0;        // commands that drew geometry
+    uint32_t merged_commands = 0; // of those, drawn with the previous one in one call
+    uint32_t draw_calls = 0;
+    uint32_t state_changes = 0;   // shader or texture switches between commands
+    uint64_t vertices = 0, indices = 0;
+    uint64_t triangles = 0;
+    uint64_t pixels = 0;          // fragments shaded, overdraw included; software backend only
+
+    // bytes sent to the device (or the cpu textures) per resource type;
+    // textures excludes the atlas pages counted under glyph_atlas
+    std::array<uint64_t, static_cast<size_t>(upload::count)> uploaded{};
+    uint64_t& uploaded_bytes(upload kind) { return uploaded[static_cast<size_t>(kind)]; }
+    uint64_t uploaded_bytes(upload kind) const { return uploaded[static_cast<size_t>(kind)]; }
+    uint64_t total_uploaded_bytes() const;
+
+    // glyph lookups while recording and drawing
+    uint64_t glyph_hits = 0, glyph_misses = 0, glyph_rasterizations = 0;
+
+    // atlases the frame's text sampled
+    uint32_t atlas_pages = 0;
+    uint64_t atlas_bytes = 0;      // page storage
+    uint64_t atlas_used_bytes = 0; // space taken by the packer
+    float atlas_occupancy() const { return atlas_bytes ? static_cast<float>(atlas_used_bytes) / atlas_bytes : 0.0f; }
+
+    // textures the frame sampled, and every texture of the backend's dict
+    uint32_t textures = 0;
+    uint64_t texture_bytes = 0;
+    uint64_t resident_texture_bytes = 0; // 0 for backends without a dict
+
+    // device or cpu objects created for the frame
+    uint32_t buffer_allocations = 0; // vertex, index and constant buffers
+    uint32_t texture_allocations = 0;
+
+    // one json object on one line, e.g. for a jsonl log per frame
+    std::string to_json() const;
+};
+
+// fills a render_stats for a backend: begin_frame clears the frame's counts,
+// the backend counts submission while drawing and reports the textures and
+// atlases it samples, end_frame adds the resource counters
+class render_stats_recorder {
+public:
+    render_stats_recorder();
+
+    void begin_frame();
+    void end_frame(const resources::texture_dict* dict = nullptr);
+
+    // buffers, vertices and indices of a submitted buffer
+    void count_buffer(const draw_buffer& buf);
+    // counted once per frame each
+    void use_texture(const resources::texture* tex);
+    void use_atlas(resources::glyph_atlas& atlas);
+
+    render_stats& stats() { return _stats; }
+    const render_stats& stats() const { return _stats; }
+
+private:
+    struct totals {
+        uint64_t glyph_hits = 0, glyph_misses = 0, glyph_rasterizations = 0;
+        uint64_t texture_upload_bytes = 0, atlas_upload_bytes = 0;
+        uint64_t textures_created = 0;
+    };
+    static totals read_totals();
+
+    render_stats _stats;
+    totals _last;   // at the previous end_frame
+    uint64_t _frames = 0;
+    std::chrono::steady_clock::time_point _begin;
+    std::vector<const void*> _seen; // textures and atlases counted this frame
+};
+
+} // namespace core
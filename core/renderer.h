@@ -5,24 +5,56 @@
 #include "draw_types.h"
 #include "draw_buffer.h"
 #include "draw_manager.h"
+#include "render_stats.h"
 #include "../resources/texture.h"
 
 namespace core {
 
+class frame_capture;
+
+#ifdef _WIN32
+using native_window = HWND;
+#else
+using native_window = void*; // headless backends ignore it
+#endif
+
 class renderer {
 public:
     virtual ~renderer() = default;
 
-    virtual void initialize(int width, int height, HWND hwnd) = 0;
+    virtual void initialize(int width, int height, native_window hwnd) = 0;
     virtual void resize(int width, int height) = 0;
     virtual void begin_frame() = 0;
     virtual void end_frame() = 0;
 
     virtual void draw_buffer(const draw_buffer* buf) = 0;
+    // static buffers (see frame_builder): the first call for a key uploads buf
+    // into a copy the backend keeps, later ones draw buf's commands from that
+    // copy and upload nothing, until release_retained(key). backends that read
+    // buffers in place just draw them
+    virtual void draw_retained(uint64_t /*key*/, const core::draw_buffer* buf) {
+        draw_buffer(buf);
+        ++_stats.stats().retained_buffers;
+    }
+    virtual void release_retained(uint64_t /*key*/) {}
     virtual void set_texture(resources::tex tex, uint32_t slot = 0) = 0;
+#ifdef _WIN32
     virtual void set_font_atlas(ID3D11ShaderResourceView* srv) = 0;
+#endif
     virtual void set_pixel_shader(const std::string& shader_name) = 0;
     virtual void clear(const color& col) = 0;
+
+    // optional recording of every frame drawn (see frame_capture); backends
+    // call begin_frame/record/end_frame on it when set
+    void set_capture(std::shared_ptr<frame_capture> capture) { _capture = std::move(capture); }
+    const std::shared_ptr<frame_capture>& capture() const { return _capture; }
+
+    // counters of the current frame, complete once end_frame returned
+    const render_stats& stats() const { return _stats.stats(); }
+
+protected:
+    std::shared_ptr<frame_capture> _capture;
+    render_stats_recorder _stats;
 };
 
 using renderer_ptr = std::shared_ptr<renderer>;
@@ -0,0 +1,226 @@
+#include "text_layout.h"
+#include "../resources/font.h"
+#include "../utils/utf8.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace core {
+
+namespace {
+
+// line breaking classes, a simplified uax #14
+enum : uint8_t {
+    cls_space = 1,           // hangs at the end of a line, not counted in its width
+    cls_break_after = 2,     // hyphens
+    cls_no_break_before = 4, // closing punctuation never starts a line (light kinsoku)
+    cls_ideographic = 8,     // cjk: breaks on either side
+    cls_hard_break = 16,
+    cls_ignored = 32,        // '\r', zero width and never drawn
+};
+
+uint8_t classify(uint32_t c) {
+    switch (c) {
+    case '\n': case 0x2028: case 0x2029:
+        return cls_hard_break;
+    case '\r':
+        return cls_ignored;
+    case ' ': case '\t': case 0x200B:
+        return cls_space;
+    case 0x3000:
+        return cls_space | cls_ideographic;
+    case '-': case 0x2010: case 0x2013:
+        return cls_break_after;
+    case ',': case '.': case ';': case ':': case '!': case '?': case ')': case ']': case '}':
+    case 0xFF01: case 0xFF09: case 0xFF0C: case 0xFF0E: case 0xFF1F:
+        return cls_no_break_before;
+    case 0x3001: case 0x3002: case 0x300D: case 0x300F: case 0x30FC:
+        return cls_no_break_before | cls_ideographic;
+    default:
+        break;
+    }
+    const bool ideographic = (c >= 0x2E80 && c <= 0x9FFF) || (c >= 0xAC00 && c <= 0xD7AF) ||
+                             (c >= 0xF900 && c <= 0xFAFF) || (c >= 0xFF00 && c <= 0xFFEF) ||
+                             (c >= 0x20000 && c <= 0x3FFFF);
+    return ideographic ? cls_ideographic : 0;
+}
+
+bool can_break(uint8_t prev, uint8_t cls) {
+    if (cls & (cls_no_break_before | cls_space)) return false;
+    return (prev & (cls_space | cls_break_after | cls_ideographic)) || (cls & cls_ideographic);
+}
+
+// classes for ascii, built once
+const std::array<uint8_t, 128>& ascii_classes() {
+    static const std::array<uint8_t, 128> table = [] {
+        std::array<uint8_t, 128> t{};
+        for (uint32_t c = 0; c < 128; ++c) t[c] = classify(c);
+        return t;
+    }();
+    return table;
+}
+
+} // namespace
+
+std::vector<text_line> wrap_text(resources::font& font, std::string_view str, float max_width, float size) {
+    std::vector<text_line> lines;
+    if (str.empty()) return lines;
+    const bool wrap = max_width > 0.0f;
+    const float base_scale = font.draw_scale(size);
+
+    // scaled advances of the base font for ascii, negative when it lacks the
+    // glyph, and its ascii kerning pairs; most text never leaves these tables
+    const int16_t* ascii_kerning = font.has_kerning() ? font.ascii_kerning() : nullptr;
+    const auto& classes = ascii_classes();
+    float ascii_advance[128];
+    for (uint32_t c = 0; c < 128; ++c) {
+        ascii_advance[c] = font.covers(c) ? font.advance(c) * base_scale : -1.0f;
+    }
+
+    const char* const begin = str.data();
+    const char* const end = begin + str.size();
+    const char* ptr = begin;
+
+    // current line: pen x, and the end and width of its last non-space glyph
+    size_t line_begin = 0;
+    float x = 0.0f;
+    size_t content_end = 0;
+    float content_width = 0.0f;
+    // last break opportunity: the next line would start at break_pos
+    bool has_break = false;
+    size_t break_pos = 0;
+    float break_x = 0.0f;
+    float break_kern = 0.0f;
+    size_t break_content_end = 0;
+    float break_content_width = 0.0f;
+    // kerning applies between consecutive glyphs of the same font
+    resources::font* prev_font = nullptr;
+    uint32_t prev = 0;
+    uint8_t prev_cls = 0;
+
+    auto start_line = [&](size_t at) {
+        line_begin = content_end = at;
+        x = content_width = 0.0f;
+        has_break = false;
+        prev_font = nullptr;
+    };
+
+    while (ptr < end) {
+        const size_t pos = static_cast<size_t>(ptr - begin);
+        uint32_t cp = static_cast<unsigned char>(*ptr);
+        int n = 1;
+        uint8_t cls = 0;
+        resources::font* glyph_font = &font;
+        float scale = base_scale;
+        float adv = 0.0f;
+        if (cp < 128 && ascii_advance[cp] >= 0.0f) {
+            cls = classes[cp];
+            adv = ascii_advance[cp];
+        } else {
+            n = cp < 128 ? 1 : utils::decode_utf8(ptr, end, cp);
+            if (n == 0) {
+                ++ptr;
+                continue;
+            }
+            cls = classify(cp);
+            // same selection as draw_buffer::text
+            if (!(cls & (cls_hard_break | cls_ignored)) && !font.covers(cp) && !font.has_glyph(cp)) {
+                auto fallback = font.resolve_fallback(cp);
+                glyph_font = fallback.get(); // kept alive by the chain
+                if (glyph_font) scale = glyph_font->draw_scale(size);
+            }
+            if (glyph_font) adv = glyph_font->advance(cp) * scale;
+        }
+        ptr += n;
+
+        if (cls & cls_hard_break) {
+            lines.push_back({line_begin, content_end, content_width});
+            start_line(pos + n);
+            continue;
+        }
+        if ((cls & cls_ignored) || !glyph_font) continue; // not drawn
+
+        float kern = 0.0f;
+        if (glyph_font == prev_font) {
+            if (glyph_font == &font && (prev | cp) < 128) {
+                if (ascii_kerning) kern = ascii_kerning[prev * 128 + cp] * base_scale;
+            } else if (glyph_font->has_kerning()) {
+                kern = glyph_font->get_kerning(prev, cp) * scale;
+            }
+        }
+        const bool space = (cls & cls_space) != 0;
+
+        if (prev_font && can_break(prev_cls, cls)) {
+            has_break = true;
+            break_pos = pos;
+            break_x = x;
+            break_kern = kern;
+            break_content_end = content_end;
+            break_content_width = content_width;
+        }
+
+        // spaces hang past the edge; only visible glyphs push a line over
+        while (wrap && !space && x + kern + adv > max_width && content_end > line_begin) {
+            if (has_break) {
+                lines.push_back({line_begin, break_content_end, break_content_width});
+                if (break_pos == pos) {
+                    start_line(pos);
+                    kern = 0.0f;
+                } else {
+                    // glyphs after the break move over; the kerning pair
+                    // across the break no longer applies
+                    const float shift = break_x + break_kern;
+                    line_begin = break_pos;
+                    x -= shift;
+                    content_width -= shift;
+                    has_break = false;
+                }
+            } else {
+                // no opportunity on this line: split the word here
+                lines.push_back({line_begin, content_end, content_width});
+                start_line(pos);
+                kern = 0.0f;
+            }
+        }
+
+        x += kern + adv;
+        if (!space) {
+            content_end = pos + n;
+            content_width = x;
+        }
+        prev_font = glyph_font;
+        prev = cp;
+        prev_cls = cls;
+
+        // rest of a word in the base font: plain ascii letters have no break
+        // opportunities between them, so only the overflow check is left
+        if (glyph_font == &font && cls == 0 && cp < 128) {
+            while (ptr < end) {
+                const unsigned char c = static_cast<unsigned char>(*ptr);
+                if (c >= 128 || classes[c] != 0 || ascii_advance[c] < 0.0f) break;
+                float next = x + ascii_advance[c];
+                if (ascii_kerning) next += ascii_kerning[prev * 128 + c] * base_scale;
+                if (wrap && next > max_width) break; // the general path splits it
+                x = next;
+                prev = c;
+                ++ptr;
+            }
+            content_end = static_cast<size_t>(ptr - begin);
+            content_width = x;
+        }
+    }
+    lines.push_back({line_begin, content_end, content_width});
+    return lines;
+}
+
+text_extent measure_text(resources::font& font, std::string_view str, float max_width, float size) {
+    text_extent extent;
+    for (const auto& line : wrap_text(font, str, max_width, size)) {
+        extent.width = std::max(extent.width, line.width);
+        ++extent.lines;
+    }
+    extent.height = extent.lines * font.metrics().line_height * font.draw_scale(size);
+    return extent;
+}
+
+} // namespace core
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace resources { class font; }
+
+namespace core {
+
+struct text_extent {
+    float width = 0.0f;
+    float height = 0.0f;
+    size_t lines = 0;
+};
+
+// one laid out line: byte range into the source string with trailing spaces
+// and the line break excluded, and its pen width
+struct text_line {
+    size_t begin = 0;
+    size_t end = 0;
+    float width = 0.0f;
+};
+
+// layout uses the same font selection, advances, kerning and sdf scaling as
+// draw_buffer::text, without rasterizing glyphs. size 0 uses the font size.
+// '\n' (and "\r\n", U+2028, U+2029) always starts a new line
+
+// greedy line breaking: lines break after spaces and hyphens, around cjk
+// ideographs and at zero-width spaces; a word wider than max_width is split
+// between characters. max_width <= 0 only breaks at newlines
+std::vector<text_line> wrap_text(resources::font& font, std::string_view str, float max_width, float size = 0.0f);
+
+// width of the widest line and height of all lines (line_height each)
+text_extent measure_text(resources::font& font, std::string_view str, float max_width = 0.0f, float size = 0.0f);
+
+} // namespace core
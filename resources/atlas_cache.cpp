@@ -0,0 +1,281 @@
+#include "atlas_cache.h"
+#include "../utils/logger.h"
+#include "../utils/hash.h"
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <type_traits>
+
+namespace resources {
+
+namespace {
+constexpr char MAGIC[4] = {'F', 'V', 'A', 'C'};
+constexpr uint32_t VERSION = 2;
+constexpr uint32_t MAX_PAGES = 256;
+constexpr uint32_t MAX_GLYPHS = 1u << 21;
+constexpr int MAX_PAGE_SIZE = 16384;
+constexpr size_t PIXEL_ALIGN = 16;
+
+// rasterization can change between freetype releases
+constexpr uint32_t FT_VERSION_TAG = (FREETYPE_MAJOR << 16) | (FREETYPE_MINOR << 8) | FREETYPE_PATCH;
+
+struct file_header {
+    char magic[4];
+    uint32_t version;
+    uint64_t font_hash;
+    int32_t face_index;
+    float size;
+    uint32_t flags;
+    uint32_t ft_version;
+    uint32_t page_count;
+    uint32_t glyph_count;
+    float metrics[5]; // ascender, descender, line_gap, line_height, max_advance
+    uint32_t reserved;
+    uint64_t checksum; // over everything after the header
+};
+
+struct page_record {
+    uint32_t format;
+    uint32_t width, height;
+    int32_t shelf_x, shelf_y, shelf_row;
+    uint64_t offset;
+};
+
+struct glyph_record {
+    uint32_t codepoint;
+    float u0, v0, u1, v1;
+    int32_t width, height;
+    float advance;
+    int32_t bearing_x, bearing_y;
+    int32_t page;
+    uint16_t colored;
+    uint16_t phase;
+};
+
+static_assert(std::is_trivially_copyable_v<file_header> && sizeof(file_header) == 72);
+static_assert(std::is_trivially_copyable_v<page_record> && sizeof(page_record) == 32);
+static_assert(std::is_trivially_copyable_v<glyph_record> && sizeof(glyph_record) == 48);
+
+std::mutex g_settings_mutex;
+std::string g_directory = "cache/glyphs";
+std::atomic<bool> g_enabled{true};
+
+size_t align_up(size_t v) { return (v + PIXEL_ALIGN - 1) & ~(PIXEL_ALIGN - 1); }
+
+bool key_matches(const file_header& h, const atlas_cache_key& key) {
+    return h.font_hash == key.font_hash && h.face_index == key.face_index &&
+           std::memcmp(&h.size, &key.size, sizeof(float)) == 0 && h.flags == key.flags &&
+           h.ft_version == FT_VERSION_TAG;
+}
+} // namespace
+
+void atlas_cache::set_directory(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(g_settings_mutex);
+    g_directory = dir;
+}
+
+std::string atlas_cache::directory() {
+    std::lock_guard<std::mutex> lock(g_settings_mutex);
+    return g_directory;
+}
+
+void atlas_cache::set_enabled(bool enabled) { g_enabled = enabled; }
+bool atlas_cache::enabled() { return g_enabled; }
+
+std::string atlas_cache::path_for(const atlas_cache_key& key) {
+    // everything in the key goes into the name; the header repeats it for validation
+    uint32_t size_bits;
+    std::memcpy(&size_bits, &key.size, sizeof(size_bits));
+    char name[96];
+    std::snprintf(name, sizeof(name), "%016llx_%d_%08x_%x.fvatlas",
+                  static_cast<unsigned long long>(key.font_hash), key.face_index, size_bits, key.flags);
+    return (std::filesystem::path(directory()) / name).string();
+}
+
+bool atlas_cache::reader::open(const atlas_cache_key& key) {
+    const std::string path = path_for(key);
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) return false;
+
+    _file = font_file::map(path);
+    if (!_file) return false;
+
+    auto reject = [&](const char* why) {
+        utils::log_warn("atlas cache: ignoring %s (%s)", path.c_str(), why);
+        _file.reset();
+        _pages.clear();
+        _glyphs.clear();
+        return false;
+    };
+
+    const unsigned char* base = _file->data();
+    const size_t size = _file->size();
+    if (size < sizeof(file_header)) return reject("truncated header");
+
+    file_header header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return reject("bad magic");
+    if (header.version != VERSION) return reject("old version");
+    if (!key_matches(header, key)) return reject("key mismatch");
+    if (header.page_count == 0 || header.page_count > MAX_PAGES || header.glyph_count > MAX_GLYPHS) {
+        return reject("bad counts");
+    }
+
+    const size_t pages_at = sizeof(file_header);
+    const size_t glyphs_at = pages_at + header.page_count * sizeof(page_record);
+    const size_t tables_end = glyphs_at + static_cast<size_t>(header.glyph_count) * sizeof(glyph_record);
+    if (tables_end > size) return reject("truncated tables");
+    if (utils::hash_bytes(base + sizeof(file_header), size - sizeof(file_header)) != header.checksum) {
+        return reject("checksum mismatch");
+    }
+
+    _pages.clear();
+    _pages.reserve(header.page_count);
+    for (uint32_t i = 0; i < header.page_count; ++i) {
+        page_record rec;
+        std::memcpy(&rec, base + pages_at + i * sizeof(page_record), sizeof(rec));
+        if (rec.format > static_cast<uint32_t>(texture_format::r8)) return reject("bad page format");
+        if (rec.width == 0 || rec.height == 0 || rec.width > MAX_PAGE_SIZE || rec.height > MAX_PAGE_SIZE) {
+            return reject("bad page size");
+        }
+        page_data page;
+        page.format = static_cast<texture_format>(rec.format);
+        page.width = static_cast<int>(rec.width);
+        page.height = static_cast<int>(rec.height);
+        const size_t bytes = static_cast<size_t>(page.width) * page.height * bytes_per_texel(page.format);
+        if (rec.offset < tables_end || rec.offset > size || bytes > size - rec.offset) return reject("page out of bounds");
+        if (rec.shelf_x < 0 || rec.shelf_y < 0 || rec.shelf_row < 0 || rec.shelf_x > page.width || rec.shelf_y > page.height) {
+            return reject("bad packer state");
+        }
+        page.shelf = {rec.shelf_x, rec.shelf_y, rec.shelf_row};
+        page.pixels = base + rec.offset;
+        _pages.push_back(page);
+    }
+
+    _glyphs.clear();
+    _glyphs.reserve(header.glyph_count);
+    for (uint32_t i = 0; i < header.glyph_count; ++i) {
+        glyph_record rec;
+        std::memcpy(&rec, base + glyphs_at + static_cast<size_t>(i) * sizeof(glyph_record), sizeof(rec));
+        if (rec.page < 0 || rec.page >= static_cast<int32_t>(header.page_count)) return reject("bad glyph page");
+        if (rec.phase >= 8) return reject("bad glyph phase");
+        glyph_info info;
+        info.codepoint = rec.codepoint;
+        info.u0 = rec.u0;
+        info.v0 = rec.v0;
+        info.u1 = rec.u1;
+        info.v1 = rec.v1;
+        info.width = rec.width;
+        info.height = rec.height;
+        info.advance = rec.advance;
+        info.bearingX = rec.bearing_x;
+        info.bearingY = rec.bearing_y;
+        info.page = rec.page;
+        info.colored = rec.colored != 0;
+        info.phase = rec.phase;
+        _glyphs.push_back(info);
+    }
+
+    _metrics.ascender = header.metrics[0];
+    _metrics.descender = header.metrics[1];
+    _metrics.line_gap = header.metrics[2];
+    _metrics.line_height = header.metrics[3];
+    _metrics.max_advance = header.metrics[4];
+    return true;
+}
+
+bool atlas_cache::write(const atlas_cache_key& key, const font_metrics& metrics, const std::vector<atlas_page>& pages,
+                        const std::unordered_map<uint32_t, glyph_info>& glyphs) {
+    if (pages.empty() || pages.size() > MAX_PAGES) return false;
+
+    file_header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.font_hash = key.font_hash;
+    header.face_index = key.face_index;
+    header.size = key.size;
+    header.flags = key.flags;
+    header.ft_version = FT_VERSION_TAG;
+    header.page_count = static_cast<uint32_t>(pages.size());
+    header.glyph_count = static_cast<uint32_t>(glyphs.size());
+    header.metrics[0] = metrics.ascender;
+    header.metrics[1] = metrics.descender;
+    header.metrics[2] = metrics.line_gap;
+    header.metrics[3] = metrics.line_height;
+    header.metrics[4] = metrics.max_advance;
+
+    // layout: header, page table, glyph table, aligned page pixels
+    const size_t pages_at = sizeof(file_header);
+    const size_t glyphs_at = pages_at + pages.size() * sizeof(page_record);
+    size_t offset = align_up(glyphs_at + glyphs.size() * sizeof(glyph_record));
+    std::vector<page_record> page_table;
+    for (const auto& page : pages) {
+        auto shelf = page.shelf();
+        page_record rec = {};
+        rec.format = static_cast<uint32_t>(page.format());
+        rec.width = static_cast<uint32_t>(page.width());
+        rec.height = static_cast<uint32_t>(page.height());
+        rec.shelf_x = shelf.x;
+        rec.shelf_y = shelf.y;
+        rec.shelf_row = shelf.row_height;
+        rec.offset = offset;
+        page_table.push_back(rec);
+        offset = align_up(offset + page.pixels().size());
+    }
+
+    std::vector<unsigned char> blob(offset, 0);
+    std::memcpy(blob.data() + pages_at, page_table.data(), page_table.size() * sizeof(page_record));
+    size_t at = glyphs_at;
+    for (const auto& [key, info] : glyphs) {
+        glyph_record rec = {};
+        rec.codepoint = info.codepoint;
+        rec.u0 = info.u0;
+        rec.v0 = info.v0;
+        rec.u1 = info.u1;
+        rec.v1 = info.v1;
+        rec.width = info.width;
+        rec.height = info.height;
+        rec.advance = info.advance;
+        rec.bearing_x = info.bearingX;
+        rec.bearing_y = info.bearingY;
+        rec.page = info.page;
+        rec.colored = info.colored ? 1 : 0;
+        rec.phase = static_cast<uint16_t>(info.phase);
+        std::memcpy(blob.data() + at, &rec, sizeof(rec));
+        at += sizeof(rec);
+    }
+    for (size_t i = 0; i < pages.size(); ++i) {
+        std::memcpy(blob.data() + page_table[i].offset, pages[i].pixels().data(), pages[i].pixels().size());
+    }
+    header.checksum = utils::hash_bytes(blob.data() + sizeof(file_header), blob.size() - sizeof(file_header));
+    std::memcpy(blob.data(), &header, sizeof(header));
+
+    const std::string path = path_for(key);
+    const std::string temp = path + ".tmp";
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            utils::log_warn("atlas cache: cannot write %s", temp.c_str());
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        if (!out) {
+            utils::log_warn("atlas cache: short write to %s", temp.c_str());
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        utils::log_warn("atlas cache: cannot replace %s: %s", path.c_str(), ec.message().c_str());
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace resources
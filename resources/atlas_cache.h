@@ -0,0 +1,68 @@
+#pragma once
+
+#include "font.h"
+#include "glyph_atlas.h"
+#include "face_cache.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace resources {
+
+// identifies one rasterization of a face: same bytes, size and flags give the same atlas
+struct atlas_cache_key {
+    uint64_t font_hash = 0;
+    int face_index = 0;
+    float size = 0.f;
+    uint32_t flags = 0; // atlas_cache::flag_* bits
+};
+
+// on-disk snapshot of a font atlas: pages with their packer state, the glyph
+// table and metrics. files are little-endian, mapped read-only and validated
+// (key, bounds, checksum) before anything is used; a bad file is a cache miss
+class atlas_cache {
+public:
+    enum : uint32_t {
+        flag_sdf = 1,
+        flag_msdf = 2,
+        flag_colored = 4,
+        subpixel_shift = 8, // subpixel positions - 1, in bits 8..10
+    };
+
+    static void set_directory(const std::string& dir); // default "cache/glyphs"
+    static std::string directory();
+    static void set_enabled(bool enabled);
+    static bool enabled();
+
+    static std::string path_for(const atlas_cache_key& key);
+
+    struct page_data {
+        texture_format format = texture_format::r8;
+        int width = 0, height = 0;
+        atlas_page::shelf_state shelf;
+        const unsigned char* pixels = nullptr; // points into the mapping
+    };
+
+    // a validated, mapped cache file; views stay valid while the reader lives
+    class reader {
+    public:
+        bool open(const atlas_cache_key& key);
+
+        const font_metrics& metrics() const { return _metrics; }
+        const std::vector<page_data>& pages() const { return _pages; }
+        const std::vector<glyph_info>& glyphs() const { return _glyphs; }
+
+    private:
+        std::shared_ptr<font_file> _file;
+        font_metrics _metrics;
+        std::vector<page_data> _pages;
+        std::vector<glyph_info> _glyphs;
+    };
+
+    // written to a temporary file and renamed, so readers never see a partial file
+    static bool write(const atlas_cache_key& key, const font_metrics& metrics, const std::vector<atlas_page>& pages,
+                      const std::unordered_map<uint32_t, glyph_info>& glyphs);
+};
+
+} // namespace resources
@@ -0,0 +1,28 @@
+#include "codepoint_set.h"
+
+namespace resources {
+
+void codepoint_set::insert(uint32_t codepoint) {
+    if (codepoint > max_codepoint) return;
+    const uint32_t block_number = codepoint >> 8;
+    if (block_number >= _index.size()) _index.resize(block_number + 1, 0);
+    uint32_t& slot = _index[block_number];
+    if (slot == 0) {
+        _blocks.push_back(block{});
+        slot = static_cast<uint32_t>(_blocks.size());
+    }
+    uint64_t& word = _blocks[slot - 1][(codepoint >> 6) & 3];
+    const uint64_t bit = uint64_t(1) << (codepoint & 63);
+    if (!(word & bit)) {
+        word |= bit;
+        ++_count;
+    }
+}
+
+void codepoint_set::clear() {
+    _index.clear();
+    _blocks.clear();
+    _count = 0;
+}
+
+} // namespace resources
@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace resources {
+
+// set of unicode codepoints as one 256-bit block per populated 256-codepoint
+// range. lookups are two array reads and a bit test; a latin font costs a few
+// hundred bytes, a full cjk face around 100kb
+class codepoint_set {
+public:
+    static constexpr uint32_t max_codepoint = 0x10FFFF;
+
+    void insert(uint32_t codepoint);
+    bool contains(uint32_t codepoint) const {
+        const uint32_t block = codepoint >> 8;
+        if (block >= _index.size()) return false;
+        const uint32_t slot = _index[block];
+        if (slot == 0) return false;
+        return (_blocks[slot - 1][(codepoint >> 6) & 3] >> (codepoint & 63)) & 1;
+    }
+
+    size_t size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    size_t block_count() const { return _blocks.size(); }
+    void clear();
+
+private:
+    using block = std::array<uint64_t, 4>;
+    std::vector<uint32_t> _index; // block number -> slot + 1, 0 when empty; grows to the highest block
+    std::vector<block> _blocks;
+    size_t _count = 0;
+};
+
+} // namespace resources
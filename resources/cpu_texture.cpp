@@ -0,0 +1,110 @@
+#include "cpu_texture.h"
+#include "resource_counters.h"
+#include "../utils/logger.h"
+#include "../utils/profiler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace resources {
+
+cpu_texture::cpu_texture(uint32_t width, uint32_t height, texture_format format)
+    : _width(width), _height(height), _format(format) {
+    create();
+}
+
+void cpu_texture::create() {
+    _data.assign(static_cast<size_t>(_width) * _height * bytes_per_texel(_format), 0);
+}
+
+bool cpu_texture::set_data(const uint8_t* data, uint32_t width, uint32_t height) {
+    if (!data) return false;
+    _width = width;
+    _height = height;
+    size_t bytes = static_cast<size_t>(width) * height * bytes_per_texel(_format);
+    _data.assign(data, data + bytes);
+    _upload_count++;
+    _uploaded_bytes += bytes;
+    resource_counters::shared().texture_upload_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    return true;
+}
+
+bool cpu_texture::update_region(const texture_region& region, const uint8_t* data, uint32_t pitch) {
+    if (!data || region.width == 0 || region.height == 0) return false;
+    if (region.x + region.width > _width || region.y + region.height > _height) {
+        utils::log_error("cpu_texture: region %u,%u %ux%u out of bounds (%ux%u)",
+                         region.x, region.y, region.width, region.height, _width, _height);
+        return false;
+    }
+    const uint32_t bpp = bytes_per_texel(_format);
+    size_t row_bytes = static_cast<size_t>(region.width) * bpp;
+    for (uint32_t row = 0; row < region.height; ++row) {
+        size_t dst = (static_cast<size_t>(region.y + row) * _width + region.x) * bpp;
+        std::memcpy(_data.data() + dst, data + static_cast<size_t>(row) * pitch, row_bytes);
+    }
+    _upload_count++;
+    _uploaded_bytes += row_bytes * region.height;
+    resource_counters::shared().texture_upload_bytes.fetch_add(row_bytes * region.height, std::memory_order_relaxed);
+    return true;
+}
+
+bool cpu_texture::apply_changes() {
+    return true;
+}
+
+bool cpu_texture::get_size(uint32_t& width, uint32_t& height) const {
+    width = _width;
+    height = _height;
+    return true;
+}
+
+void cpu_texture::clear_data() {
+    _data.clear();
+    _width = _height = 0;
+}
+
+// --- cpu_texture_dict ---
+
+tex cpu_texture_dict::create_texture(uint32_t width, uint32_t height, texture_format format) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto tex = std::make_shared<cpu_texture>(width, height, format);
+    _textures.push_back(tex);
+    resource_counters::shared().textures_created.fetch_add(1, std::memory_order_relaxed);
+    return tex;
+}
+
+void cpu_texture_dict::destroy_texture(tex tex) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _textures.erase(std::remove(_textures.begin(), _textures.end(), tex), _textures.end());
+}
+
+bool cpu_texture_dict::set_texture_data(tex tex, const uint8_t* data, uint32_t width, uint32_t height) {
+    if (!tex) return false;
+    return tex->set_data(data, width, height);
+}
+
+bool cpu_texture_dict::update_texture_region(tex tex, const texture_region& region, const uint8_t* data, uint32_t pitch) {
+    FV_PROFILE_SCOPE("cpu_texture_dict::update_texture_region");
+    if (!tex) return false;
+    return tex->update_region(region, data, pitch);
+}
+
+bool cpu_texture_dict::get_texture_size(tex tex, uint32_t& width, uint32_t& height) {
+    if (!tex) return false;
+    return tex->get_size(width, height);
+}
+
+size_t cpu_texture_dict::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t bytes = 0;
+    for (const auto& tex : _textures) {
+        bytes += static_cast<size_t>(tex->width()) * tex->height() * bytes_per_texel(tex->format());
+    }
+    return bytes;
+}
+
+void cpu_texture_dict::clear_textures() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _textures.clear();
+}
+
+} // namespace resources
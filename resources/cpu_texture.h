@@ -0,0 +1,72 @@
+#pragma once
+#include "texture.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace resources {
+
+// system-memory texture, used headless (tests, tools) and as a reference for backend uploads
+class cpu_texture : public texture {
+public:
+    cpu_texture(uint32_t width, uint32_t height, texture_format format = texture_format::rgba8);
+    ~cpu_texture() override = default;
+
+    uint32_t width() const override { return _width; }
+    uint32_t height() const override { return _height; }
+    texture_format format() const override { return _format; }
+    void bind(uint32_t /*slot*/ = 0) override {}
+    void unbind() override {}
+
+    bool set_data(const uint8_t* data, uint32_t width, uint32_t height) override;
+    bool update_region(const texture_region& region, const uint8_t* data, uint32_t pitch) override;
+    bool apply_changes() override;
+    bool get_size(uint32_t& width, uint32_t& height) const override;
+    void clear_data() override;
+    void invalidate() override {}
+    void create() override;
+#ifdef _WIN32
+    ID3D11ShaderResourceView* get_srv() const override { return nullptr; }
+#endif
+
+    const std::vector<uint8_t>& data() const { return _data; }
+
+    // upload accounting, so callers can verify only changed texels were sent
+    size_t upload_count() const { return _upload_count; }
+    size_t uploaded_bytes() const { return _uploaded_bytes; }
+    void reset_upload_stats() { _upload_count = 0; _uploaded_bytes = 0; }
+
+private:
+    std::vector<uint8_t> _data;
+    uint32_t _width = 0, _height = 0;
+    texture_format _format = texture_format::rgba8;
+    size_t _upload_count = 0;
+    size_t _uploaded_bytes = 0;
+};
+
+class cpu_texture_dict : public texture_dict {
+public:
+    cpu_texture_dict() = default;
+    ~cpu_texture_dict() override = default;
+
+    tex create_texture(uint32_t width, uint32_t height, texture_format format = texture_format::rgba8) override;
+#ifdef _WIN32
+    tex create_texture_from_d3d11(ID3D11Texture2D* d3d_texture, ID3D11ShaderResourceView* srv = nullptr) override { return nullptr; }
+#endif
+    void destroy_texture(tex tex) override;
+    bool set_texture_data(tex tex, const uint8_t* data, uint32_t width, uint32_t height) override;
+    bool update_texture_region(tex tex, const texture_region& region, const uint8_t* data, uint32_t pitch) override;
+    bool get_texture_size(tex tex, uint32_t& width, uint32_t& height) override;
+    void clear_textures() override;
+    void pre_reset() override {}
+    void post_reset() override {}
+
+    size_t memory_bytes() const override;
+    size_t texture_count() const { return _textures.size(); }
+
+private:
+    std::vector<tex> _textures;
+    mutable std::mutex _mutex;
+};
+
+} // namespace resources
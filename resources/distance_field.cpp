@@ -0,0 +1,531 @@
+#include "distance_field.h"
+#include FT_OUTLINE_H
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace resources {
+
+namespace {
+constexpr float INF = 1e20f;
+
+// per-thread scratch so per-glyph generation doesn't allocate once warmed up
+struct edt_scratch {
+    std::vector<float> outer, inner;
+    std::vector<float> f, d, z;
+    std::vector<int> v;
+
+    void reserve(int w, int h) {
+        size_t area = static_cast<size_t>(w) * h;
+        size_t line = static_cast<size_t>(std::max(w, h));
+        if (outer.size() < area) { outer.resize(area); inner.resize(area); }
+        if (f.size() < line) { f.resize(line); d.resize(line); v.resize(line); z.resize(line + 1); }
+    }
+};
+
+edt_scratch& scratch() {
+    thread_local edt_scratch s;
+    return s;
+}
+
+// 1d squared euclidean distance transform (lower envelope of parabolas)
+void edt_1d(const float* f, float* d, int* v, float* z, int n) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -INF;
+    z[1] = INF;
+    for (int q = 1; q < n; ++q) {
+        float s = ((f[q] + float(q) * q) - (f[v[k]] + float(v[k]) * v[k])) / (2.f * q - 2.f * v[k]);
+        while (s <= z[k]) {
+            --k;
+            s = ((f[q] + float(q) * q) - (f[v[k]] + float(v[k]) * v[k])) / (2.f * q - 2.f * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INF;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q) ++k;
+        float dq = float(q - v[k]);
+        d[q] = dq * dq + f[v[k]];
+    }
+}
+
+// separable 2d transform: columns, then rows
+void edt_2d(float* grid, int w, int h, edt_scratch& s) {
+    for (int x = 0; x < w; ++x) {
+        for (int y = 0; y < h; ++y) s.f[y] = grid[y * w + x];
+        edt_1d(s.f.data(), s.d.data(), s.v.data(), s.z.data(), h);
+        for (int y = 0; y < h; ++y) grid[y * w + x] = s.d[y];
+    }
+    for (int y = 0; y < h; ++y) {
+        float* row = grid + static_cast<size_t>(y) * w;
+        std::copy(row, row + w, s.f.data());
+        edt_1d(s.f.data(), row, s.v.data(), s.z.data(), w);
+    }
+}
+
+// --- msdf ---
+
+// channel masks used for edge colors
+enum : uint8_t {
+    CH_R = 1, CH_G = 2, CH_B = 4,
+    CH_YELLOW = CH_R | CH_G, CH_MAGENTA = CH_R | CH_B, CH_CYAN = CH_G | CH_B,
+    CH_WHITE = CH_R | CH_G | CH_B
+};
+
+// flattened segments may extend past their end into a pseudo-distance only
+// where the original edge ends, never at joints inside a curve
+enum : uint8_t { EXTEND_START = 1, EXTEND_END = 2 };
+
+struct vec2 {
+    float x = 0.f, y = 0.f;
+};
+inline vec2 operator+(vec2 a, vec2 b) { return {a.x + b.x, a.y + b.y}; }
+inline vec2 operator-(vec2 a, vec2 b) { return {a.x - b.x, a.y - b.y}; }
+inline vec2 operator*(vec2 a, float s) { return {a.x * s, a.y * s}; }
+inline float dot(vec2 a, vec2 b) { return a.x * b.x + a.y * b.y; }
+inline float cross(vec2 a, vec2 b) { return a.x * b.y - a.y * b.x; }
+inline float length(vec2 a) { return std::sqrt(dot(a, a)); }
+inline vec2 normalize(vec2 a) {
+    float len = length(a);
+    return len > 0.f ? a * (1.f / len) : vec2{};
+}
+
+// line (order 1), conic (2) or cubic (3) bezier edge of an outline contour
+struct outline_edge {
+    vec2 p[4];
+    int order = 1;
+    uint8_t color = CH_WHITE;
+
+    vec2 point(float t) const {
+        float u = 1.f - t;
+        switch (order) {
+        case 1: return p[0] * u + p[1] * t;
+        case 2: return p[0] * (u * u) + p[1] * (2.f * u * t) + p[2] * (t * t);
+        default: return p[0] * (u * u * u) + p[1] * (3.f * u * u * t) + p[2] * (3.f * u * t * t) + p[3] * (t * t * t);
+        }
+    }
+    // tangents at the ends, skipping control points that coincide with the end
+    vec2 dir_start() const {
+        for (int i = 1; i <= order; ++i) {
+            vec2 d = p[i] - p[0];
+            if (dot(d, d) > 1e-12f) return d;
+        }
+        return {};
+    }
+    vec2 dir_end() const {
+        for (int i = order - 1; i >= 0; --i) {
+            vec2 d = p[order] - p[i];
+            if (dot(d, d) > 1e-12f) return d;
+        }
+        return {};
+    }
+};
+
+struct outline_shape {
+    std::vector<std::vector<outline_edge>> contours;
+    vec2 last;
+    float origin_x = 0.f, origin_y = 0.f;
+
+    // 26.6 y-up outline space -> bitmap space (y down, spread included)
+    vec2 map(const FT_Vector* v) const { return {v->x / 64.f + origin_x, origin_y - v->y / 64.f}; }
+    void add(const outline_edge& e) {
+        if (contours.empty()) contours.emplace_back();
+        contours.back().push_back(e);
+    }
+};
+
+int outline_move_to(const FT_Vector* to, void* user) {
+    auto* shape = static_cast<outline_shape*>(user);
+    shape->contours.emplace_back();
+    shape->last = shape->map(to);
+    return 0;
+}
+
+int outline_line_to(const FT_Vector* to, void* user) {
+    auto* shape = static_cast<outline_shape*>(user);
+    vec2 p = shape->map(to);
+    outline_edge e;
+    e.p[0] = shape->last;
+    e.p[1] = p;
+    if (dot(p - shape->last, p - shape->last) > 1e-12f) shape->add(e);
+    shape->last = p;
+    return 0;
+}
+
+int outline_conic_to(const FT_Vector* control, const FT_Vector* to, void* user) {
+    auto* shape = static_cast<outline_shape*>(user);
+    outline_edge e;
+    e.order = 2;
+    e.p[0] = shape->last;
+    e.p[1] = shape->map(control);
+    e.p[2] = shape->map(to);
+    shape->add(e);
+    shape->last = e.p[2];
+    return 0;
+}
+
+int outline_cubic_to(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector* to, void* user) {
+    auto* shape = static_cast<outline_shape*>(user);
+    outline_edge e;
+    e.order = 3;
+    e.p[0] = shape->last;
+    e.p[1] = shape->map(control1);
+    e.p[2] = shape->map(control2);
+    e.p[3] = shape->map(to);
+    shape->add(e);
+    shape->last = e.p[3];
+    return 0;
+}
+
+bool is_corner(vec2 a, vec2 b) {
+    // ~3 radians, the usual msdf threshold: anything sharper than a gentle bend
+    constexpr float SIN_THRESHOLD = 0.1411f;
+    a = normalize(a);
+    b = normalize(b);
+    return dot(a, b) <= 0.f || std::fabs(cross(a, b)) > SIN_THRESHOLD;
+}
+
+// neighbouring edges across a corner get colors that share exactly one channel,
+// so each channel sees the corner as the meeting point of two straight fields
+void color_edges(std::vector<outline_edge>& contour) {
+    const int m = static_cast<int>(contour.size());
+    std::vector<int> corners;
+    for (int i = 0; i < m; ++i) {
+        const auto& prev = contour[(i + m - 1) % m];
+        if (is_corner(prev.dir_end(), contour[i].dir_start())) corners.push_back(i);
+    }
+
+    if (corners.empty() || (corners.size() == 1 && m < 3)) {
+        // smooth contour (or a teardrop too short to split): plain distance
+        for (auto& e : contour) e.color = CH_WHITE;
+    } else if (corners.size() == 1) {
+        // teardrop: the two sides of the single corner use different channels
+        static const uint8_t colors[3] = {CH_MAGENTA, CH_WHITE, CH_YELLOW};
+        for (int k = 0; k < m; ++k) {
+            contour[(corners[0] + k) % m].color = colors[k * 3 / m];
+        }
+    } else {
+        static const uint8_t colors[3] = {CH_CYAN, CH_MAGENTA, CH_YELLOW};
+        const int spans = static_cast<int>(corners.size());
+        int span = 0;
+        for (int k = 0; k < m; ++k) {
+            int i = (corners[0] + k) % m;
+            if (span + 1 < spans && i == corners[span + 1]) ++span;
+            int c = span % 3;
+            // the last span wraps around to the first (cyan) and follows a yellow one
+            if (span == spans - 1 && c == 0) c = 1;
+            contour[i].color = colors[c];
+        }
+    }
+}
+
+// flattened edges stored as structure of arrays so the per-texel distance
+// pass runs as one straight loop the compiler can vectorize
+struct segment_list {
+    std::vector<float> ax, ay, dx, dy, inv_len2;
+    std::vector<uint8_t> color, flags;
+
+    void add(vec2 a, vec2 b, uint8_t c, uint8_t f) {
+        vec2 d = b - a;
+        float len2 = dot(d, d);
+        if (len2 <= 1e-12f) return;
+        ax.push_back(a.x);
+        ay.push_back(a.y);
+        dx.push_back(d.x);
+        dy.push_back(d.y);
+        inv_len2.push_back(1.f / len2);
+        color.push_back(c);
+        flags.push_back(f);
+    }
+    size_t size() const { return ax.size(); }
+};
+
+void flatten(const outline_edge& e, segment_list& out) {
+    // chord error below ~1/50 px from the second derivative bound
+    constexpr float TOLERANCE = 0.02f;
+    int pieces = 1;
+    if (e.order == 2) {
+        float dd = length(e.p[0] - e.p[1] * 2.f + e.p[2]);
+        pieces = static_cast<int>(std::ceil(std::sqrt(dd / (4.f * TOLERANCE))));
+    } else if (e.order == 3) {
+        float dd = std::max(length(e.p[0] - e.p[1] * 2.f + e.p[2]), length(e.p[1] - e.p[2] * 2.f + e.p[3]));
+        pieces = static_cast<int>(std::ceil(std::sqrt(3.f * dd / (4.f * TOLERANCE))));
+    }
+    pieces = std::clamp(pieces, 1, 64);
+
+    vec2 prev = e.p[0];
+    for (int i = 1; i <= pieces; ++i) {
+        vec2 next = i == pieces ? e.p[e.order] : e.point(float(i) / pieces);
+        uint8_t f = (i == 1 ? EXTEND_START : 0) | (i == pieces ? EXTEND_END : 0);
+        out.add(prev, next, e.color, f);
+        prev = next;
+    }
+}
+
+float median(float a, float b, float c) {
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+// texel a is flagged when it and neighbour b interpolate to a false edge
+bool detect_clash(const float* a, const float* b, float threshold) {
+    float a0 = a[0], a1 = a[1], a2 = a[2];
+    float b0 = b[0], b1 = b[1], b2 = b[2];
+    // order channel pairs from largest to smallest difference
+    if (std::fabs(b0 - a0) < std::fabs(b1 - a1)) { std::swap(a0, a1); std::swap(b0, b1); }
+    if (std::fabs(b1 - a1) < std::fabs(b2 - a2)) {
+        std::swap(a1, a2);
+        std::swap(b1, b2);
+        if (std::fabs(b0 - a0) < std::fabs(b1 - a1)) { std::swap(a0, a1); std::swap(b0, b1); }
+    }
+    return std::fabs(b1 - a1) >= threshold &&
+           !(b0 == b1 && b0 == b2) &&                       // neighbour already equalized
+           std::fabs(a2 - 0.5f) >= std::fabs(b2 - 0.5f);    // only the texel farther from the edge
+}
+
+struct msdf_scratch {
+    segment_list segments;
+    std::vector<float> dist2, param, side;
+    std::vector<float> field;   // 4 floats per texel, normalized 0..1
+    std::vector<uint8_t> clash;
+    std::vector<std::pair<float, int>> crossings;
+};
+
+msdf_scratch& msdf_scratch_for_thread() {
+    thread_local msdf_scratch s;
+    return s;
+}
+} // namespace
+
+void make_sdf(const unsigned char* coverage, int w, int h, int pitch, unsigned char* dst, int spread) {
+    const int dw = sdf_extent(w, spread);
+    const int dh = sdf_extent(h, spread);
+    auto& s = scratch();
+    s.reserve(dw, dh);
+
+    // padding is fully outside
+    const size_t area = static_cast<size_t>(dw) * dh;
+    std::fill(s.outer.begin(), s.outer.begin() + area, INF);
+    std::fill(s.inner.begin(), s.inner.begin() + area, 0.f);
+
+    // seed: solid texels are distance 0 from the shape, partial coverage
+    // places the edge inside the texel (0.5 - coverage) for sub-pixel accuracy
+    for (int y = 0; y < h; ++y) {
+        const unsigned char* src = coverage + static_cast<size_t>(y) * pitch;
+        for (int x = 0; x < w; ++x) {
+            unsigned char c = src[x];
+            if (c == 0) continue;
+            size_t i = static_cast<size_t>(y + spread) * dw + (x + spread);
+            if (c == 255) {
+                s.outer[i] = 0.f;
+                s.inner[i] = INF;
+            } else {
+                float d = 0.5f - c / 255.f;
+                s.outer[i] = d > 0.f ? d * d : 0.f;
+                s.inner[i] = d < 0.f ? d * d : 0.f;
+            }
+        }
+    }
+
+    edt_2d(s.outer.data(), dw, dh, s);
+    edt_2d(s.inner.data(), dw, dh, s);
+
+    // positive outside, negative inside; map [-spread, spread] to [255, 0]
+    const float scale = 127.f / float(spread);
+    for (size_t i = 0; i < area; ++i) {
+        float d = std::sqrt(s.outer[i]) - std::sqrt(s.inner[i]);
+        float value = std::clamp(128.f - d * scale + 0.5f, 0.f, 255.f);
+        dst[i] = static_cast<unsigned char>(value);
+    }
+}
+
+bool make_msdf(const FT_Outline& outline, int spread, msdf_bitmap& out) {
+    out.width = out.height = 0;
+    out.rgba.clear();
+    if (outline.n_contours <= 0 || outline.n_points <= 0) return false;
+
+    FT_BBox box;
+    FT_Outline_Get_CBox(&outline, &box);
+    const int x_min = static_cast<int>(std::floor(box.xMin / 64.0));
+    const int x_max = static_cast<int>(std::ceil(box.xMax / 64.0));
+    const int y_min = static_cast<int>(std::floor(box.yMin / 64.0));
+    const int y_max = static_cast<int>(std::ceil(box.yMax / 64.0));
+    if (x_max <= x_min || y_max <= y_min) return false;
+
+    // collect contours in bitmap space
+    outline_shape shape;
+    shape.origin_x = static_cast<float>(spread - x_min);
+    shape.origin_y = static_cast<float>(spread + y_max);
+    FT_Outline_Funcs funcs = {};
+    funcs.move_to = outline_move_to;
+    funcs.line_to = outline_line_to;
+    funcs.conic_to = outline_conic_to;
+    funcs.cubic_to = outline_cubic_to;
+    if (FT_Outline_Decompose(const_cast<FT_Outline*>(&outline), &funcs, &shape) != 0) return false;
+
+    auto& s = msdf_scratch_for_thread();
+    auto& segs = s.segments;
+    segs = segment_list{};
+    float area = 0.f;
+    for (auto& contour : shape.contours) {
+        if (contour.empty()) continue;
+        // freetype leaves the closing line implicit when it is degenerate
+        vec2 first = contour.front().p[0];
+        vec2 last = contour.back().p[contour.back().order];
+        if (dot(last - first, last - first) > 1e-12f) {
+            outline_edge e;
+            e.p[0] = last;
+            e.p[1] = first;
+            contour.push_back(e);
+        }
+        color_edges(contour);
+        for (const auto& e : contour) flatten(e, segs);
+    }
+    const size_t n = segs.size();
+    if (n == 0) return false;
+    for (size_t i = 0; i < n; ++i) {
+        area += cross({segs.ax[i], segs.ay[i]}, {segs.ax[i] + segs.dx[i], segs.ay[i] + segs.dy[i]});
+    }
+    // positive distances inside regardless of the font's contour direction
+    const float polarity = area >= 0.f ? 1.f : -1.f;
+
+    const int w = sdf_extent(x_max - x_min, spread);
+    const int h = sdf_extent(y_max - y_min, spread);
+    s.dist2.resize(n);
+    s.param.resize(n);
+    s.side.resize(n);
+    s.field.resize(static_cast<size_t>(w) * h * 4);
+
+    const float* ax = segs.ax.data();
+    const float* ay = segs.ay.data();
+    const float* dx = segs.dx.data();
+    const float* dy = segs.dy.data();
+    const float* inv_len2 = segs.inv_len2.data();
+    float* dist2 = s.dist2.data();
+    float* param = s.param.data();
+    float* side = s.side.data();
+    const float to_unit = 1.f / (2.f * spread);
+
+    for (int y = 0; y < h; ++y) {
+        const float py = y + 0.5f;
+
+        // nonzero winding along this row for the sign check
+        s.crossings.clear();
+        for (size_t i = 0; i < n; ++i) {
+            float y0 = ay[i], y1 = ay[i] + dy[i];
+            if ((y0 <= py) != (y1 <= py)) {
+                float x = ax[i] + (py - y0) / dy[i] * dx[i];
+                s.crossings.emplace_back(x, y1 > y0 ? 1 : -1);
+            }
+        }
+        std::sort(s.crossings.begin(), s.crossings.end());
+        size_t next_crossing = 0;
+        int winding = 0;
+
+        for (int x = 0; x < w; ++x) {
+            const float px = x + 0.5f;
+            while (next_crossing < s.crossings.size() && s.crossings[next_crossing].first < px) {
+                winding += s.crossings[next_crossing++].second;
+            }
+
+            // distance to every segment, branch free
+            for (size_t i = 0; i < n; ++i) {
+                float rx = px - ax[i], ry = py - ay[i];
+                float t = (rx * dx[i] + ry * dy[i]) * inv_len2[i];
+                float tc = std::min(std::max(t, 0.f), 1.f);
+                float qx = rx - tc * dx[i], qy = ry - tc * dy[i];
+                dist2[i] = qx * qx + qy * qy;
+                param[i] = t;
+                side[i] = dx[i] * ry - dy[i] * rx;
+            }
+
+            // nearest segment per channel; ties at shared endpoints go to the
+            // segment the texel is more perpendicular to
+            int best[3] = {-1, -1, -1};
+            int nearest = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (dist2[i] < dist2[nearest]) nearest = static_cast<int>(i);
+                for (int c = 0; c < 3; ++c) {
+                    if (!(segs.color[i] & (1 << c))) continue;
+                    int b = best[c];
+                    if (b < 0 || dist2[i] < dist2[b] - 1e-6f) {
+                        best[c] = static_cast<int>(i);
+                    } else if (dist2[i] <= dist2[b] + 1e-6f) {
+                        auto ortho = [&](int k) {
+                            if (param[k] >= 0.f && param[k] <= 1.f) return 0.f;
+                            vec2 end = param[k] < 0.f ? vec2{ax[k], ay[k]} : vec2{ax[k] + dx[k], ay[k] + dy[k]};
+                            return std::fabs(dot(normalize({dx[k], dy[k]}), normalize(vec2{px, py} - end)));
+                        };
+                        if (ortho(static_cast<int>(i)) < ortho(b)) best[c] = static_cast<int>(i);
+                    }
+                }
+            }
+
+            float channel[3];
+            const float true_dist = std::sqrt(dist2[nearest]);
+            for (int c = 0; c < 3; ++c) {
+                int k = best[c] < 0 ? nearest : best[c];
+                float d = std::sqrt(dist2[k]);
+                float sd = (side[k] * polarity >= 0.f ? 1.f : -1.f) * d;
+                // past the end of an edge, the distance to its extension keeps corners sharp
+                bool beyond = (param[k] < 0.f && (segs.flags[k] & EXTEND_START)) ||
+                              (param[k] > 1.f && (segs.flags[k] & EXTEND_END));
+                if (beyond) {
+                    float pseudo = side[k] * polarity * std::sqrt(inv_len2[k]);
+                    if (std::fabs(pseudo) <= d) sd = pseudo;
+                }
+                channel[c] = sd;
+            }
+
+            // the winding decides inside/outside; flip channels that disagree
+            const bool inside = winding != 0;
+            float med = median(channel[0], channel[1], channel[2]);
+            if (med != 0.f && (med > 0.f) != inside) {
+                for (float& c : channel) c = -c;
+            }
+
+            float* texel = s.field.data() + (static_cast<size_t>(y) * w + x) * 4;
+            for (int c = 0; c < 3; ++c) texel[c] = channel[c] * to_unit + 0.5f;
+            texel[3] = (inside ? true_dist : -true_dist) * to_unit + 0.5f;
+        }
+    }
+
+    // equalize texels whose channels would interpolate into a false edge
+    s.clash.assign(static_cast<size_t>(w) * h, 0);
+    const float threshold = 1.001f * to_unit;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const float* a = s.field.data() + (static_cast<size_t>(y) * w + x) * 4;
+            if ((x > 0 && detect_clash(a, a - 4, threshold)) ||
+                (x + 1 < w && detect_clash(a, a + 4, threshold)) ||
+                (y > 0 && detect_clash(a, a - w * 4, threshold)) ||
+                (y + 1 < h && detect_clash(a, a + w * 4, threshold))) {
+                s.clash[static_cast<size_t>(y) * w + x] = 1;
+            }
+        }
+    }
+
+    out.width = w;
+    out.height = h;
+    out.left = x_min - spread;
+    out.top = y_max + spread;
+    out.rgba.resize(static_cast<size_t>(w) * h * 4);
+    for (size_t i = 0; i < static_cast<size_t>(w) * h; ++i) {
+        float* texel = s.field.data() + i * 4;
+        if (s.clash[i]) {
+            float m = median(texel[0], texel[1], texel[2]);
+            texel[0] = texel[1] = texel[2] = m;
+        }
+        // same encoding as make_sdf: 128 on the edge, +-127 at the spread
+        for (int c = 0; c < 4; ++c) {
+            float value = std::clamp(128.f + (texel[c] - 0.5f) * 254.f + 0.5f, 0.f, 255.f);
+            out.rgba[i * 4 + c] = static_cast<unsigned char>(value);
+        }
+    }
+    return true;
+}
+
+} // namespace resources
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace resources {
+
+// signed distance field from an 8-bit coverage bitmap.
+// dst is (w + 2 * spread) x (h + 2 * spread), one byte per texel: 128 on the
+// outline, 255 at `spread` pixels inside, 0 at `spread` pixels outside.
+// exact euclidean distances via the linear-time felzenszwalb/huttenlocher
+// transform, seeded with sub-pixel edge offsets from the coverage values.
+void make_sdf(const unsigned char* coverage, int w, int h, int pitch, unsigned char* dst, int spread);
+
+// size of the field produced for a w x h bitmap
+inline int sdf_extent(int size, int spread) { return size + 2 * spread; }
+
+// multi-channel field for a glyph outline (26.6 pixel units, y up).
+// rgb hold per-channel distances to differently colored edges so the median
+// keeps sharp corners; alpha holds the true distance. same encoding as make_sdf.
+struct msdf_bitmap {
+    int width = 0, height = 0;  // includes the spread on every side
+    int left = 0, top = 0;      // bitmap origin relative to the pen, like FT bitmap_left/top
+    std::vector<unsigned char> rgba;
+};
+
+// false for empty outlines (spaces); out is left with zero size
+bool make_msdf(const FT_Outline& outline, int spread, msdf_bitmap& out);
+
+} // namespace resources
@@ -0,0 +1,245 @@
+#include "face_cache.h"
+#include "../utils/logger.h"
+#include "../utils/hash.h"
+#include FT_SIZES_H
+#include <cstring>
+#include <cstdio>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace resources {
+
+// FT_New_Face/FT_Done_Face on one library must not run concurrently
+struct ft_library {
+    FT_Library handle = nullptr;
+    std::mutex mutex;
+
+    ~ft_library() {
+        if (handle) FT_Done_FreeType(handle);
+    }
+};
+
+// --- font_file ---
+
+std::shared_ptr<font_file> font_file::map(const std::string& path) {
+    std::shared_ptr<font_file> file(new font_file());
+    file->_key = path;
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        utils::log_error("font_file: cannot open %s", path.c_str());
+        return nullptr;
+    }
+    file->_file = handle;
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        utils::log_error("font_file: %s is empty", path.c_str());
+        return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        utils::log_error("font_file: CreateFileMapping failed for %s", path.c_str());
+        return nullptr;
+    }
+    file->_mapping = mapping;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        utils::log_error("font_file: MapViewOfFile failed for %s", path.c_str());
+        return nullptr;
+    }
+    file->_data = static_cast<const unsigned char*>(view);
+    file->_size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        utils::log_error("font_file: cannot open %s", path.c_str());
+        return nullptr;
+    }
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        utils::log_error("font_file: %s is empty", path.c_str());
+        ::close(fd);
+        return nullptr;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        utils::log_error("font_file: mmap failed for %s", path.c_str());
+        return nullptr;
+    }
+    file->_data = static_cast<const unsigned char*>(view);
+    file->_size = static_cast<size_t>(st.st_size);
+#endif
+    file->_mapped = true;
+    return file;
+}
+
+std::shared_ptr<font_file> font_file::copy(const void* data, size_t size) {
+    if (!data || size == 0) return nullptr;
+    std::shared_ptr<font_file> file(new font_file());
+    char key[64];
+    std::snprintf(key, sizeof(key), "memory:%p:%zu", data, size);
+    file->_key = key;
+    file->_copy = std::make_unique<unsigned char[]>(size);
+    std::memcpy(file->_copy.get(), data, size);
+    file->_data = file->_copy.get();
+    file->_size = size;
+    return file;
+}
+
+font_file::~font_file() {
+    if (!_mapped) return;
+#ifdef _WIN32
+    if (_data) UnmapViewOfFile(_data);
+    if (_mapping) CloseHandle(_mapping);
+    if (_file) CloseHandle(_file);
+#else
+    if (_data) munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+}
+
+uint64_t font_file::content_hash() const {
+    std::call_once(_hash_once, [this]() { _hash = utils::hash_bytes(_data, _size); });
+    return _hash;
+}
+
+// --- shared_face ---
+
+shared_face::~shared_face() {
+    if (_face && _library) {
+        std::lock_guard<std::mutex> lock(_library->mutex);
+        FT_Done_Face(_face);
+    }
+}
+
+// --- face_size ---
+
+face_size::face_size(std::shared_ptr<shared_face> face, float pixel_height) : _face(std::move(face)) {
+    if (!_face || !_face->face()) return;
+    auto lock = _face->lock();
+    if (FT_New_Size(_face->face(), &_size) != 0) {
+        utils::log_error("FT_New_Size failed for %s", _face->key().c_str());
+        _size = nullptr;
+        return;
+    }
+    FT_Activate_Size(_size);
+
+    FT_Size_RequestRec req;
+    req.type = FT_SIZE_REQUEST_TYPE_REAL_DIM;
+    req.width = 0;
+    req.height = static_cast<FT_Long>(pixel_height * 64);
+    req.horiResolution = 0;
+    req.vertResolution = 0;
+    if (FT_Request_Size(_face->face(), &req) != 0) {
+        utils::log_error("FT_Request_Size failed");
+        FT_Done_Size(_size);
+        _size = nullptr;
+    }
+}
+
+face_size::~face_size() {
+    if (!_size) return;
+    auto lock = _face->lock();
+    FT_Done_Size(_size);
+}
+
+FT_Face face_size::activate() const {
+    if (!_size) return nullptr;
+    FT_Activate_Size(_size);
+    return _face->face();
+}
+
+// --- face_cache ---
+
+face_cache& face_cache::instance() {
+    static face_cache cache;
+    return cache;
+}
+
+face_cache::face_cache() : _library(std::make_shared<ft_library>()) {
+    if (FT_Init_FreeType(&_library->handle)) {
+        utils::log_error("Could not init FreeType");
+        _library->handle = nullptr;
+    }
+}
+
+std::shared_ptr<shared_face> face_cache::open(const std::string& path, int face_index) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto file = _files[path].lock();
+    if (!file) {
+        file = font_file::map(path);
+        if (!file) return nullptr;
+        _files[path] = file;
+    }
+    return open_locked(file, face_index);
+}
+
+std::shared_ptr<shared_face> face_cache::open(const std::shared_ptr<font_file>& file, int face_index) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return open_locked(file, face_index);
+}
+
+std::shared_ptr<shared_face> face_cache::open_locked(const std::shared_ptr<font_file>& file, int face_index) {
+    if (!file || !_library->handle) return nullptr;
+
+    std::string key = file->key() + "#" + std::to_string(face_index);
+    if (auto face = _faces[key].lock()) return face;
+
+    std::shared_ptr<shared_face> face(new shared_face());
+    face->_key = key;
+    face->_file = file;
+    {
+        std::lock_guard<std::mutex> lib_lock(_library->mutex);
+        if (FT_New_Memory_Face(_library->handle, file->data(), static_cast<FT_Long>(file->size()), face_index, &face->_face)) {
+            utils::log_error("Failed to create face %d from %s", face_index, file->key().c_str());
+            face->_face = nullptr;
+            return nullptr;
+        }
+    }
+    face->_library = _library;
+    _faces[key] = face;
+    return face;
+}
+
+std::shared_ptr<font_file> face_cache::share_memory(const void* data, size_t size) {
+    if (!data || size == 0) return nullptr;
+    char key[64];
+    std::snprintf(key, sizeof(key), "memory:%p:%zu", data, size);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    // same address and size is only a hint; the bytes must match too
+    auto file = _files[key].lock();
+    if (file && std::memcmp(file->data(), data, size) == 0) return file;
+
+    file = font_file::copy(data, size);
+    _files[key] = file;
+    return file;
+}
+
+size_t face_cache::face_count() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t count = 0;
+    for (const auto& [key, face] : _faces) {
+        if (!face.expired()) ++count;
+    }
+    return count;
+}
+
+size_t face_cache::file_count() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t count = 0;
+    for (const auto& [key, file] : _files) {
+        if (!file.expired()) ++count;
+    }
+    return count;
+}
+
+} // namespace resources
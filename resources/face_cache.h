@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace resources {
+
+struct ft_library;
+
+// read-only font file contents: a memory mapping for files on disk, or one
+// owned copy for fonts handed in from memory. shared by every face opened on it
+class font_file {
+public:
+    static std::shared_ptr<font_file> map(const std::string& path);
+    static std::shared_ptr<font_file> copy(const void* data, size_t size);
+    ~font_file();
+
+    font_file(const font_file&) = delete;
+    font_file& operator=(const font_file&) = delete;
+
+    const unsigned char* data() const { return _data; }
+    size_t size() const { return _size; }
+    bool mapped() const { return _mapped; }
+    const std::string& key() const { return _key; } // path, or address and size for memory fonts
+    uint64_t content_hash() const; // hash of the bytes, computed once
+
+private:
+    font_file() = default;
+
+    std::string _key;
+    std::unique_ptr<unsigned char[]> _copy;
+    mutable std::once_flag _hash_once;
+    mutable uint64_t _hash = 0;
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+    bool _mapped = false;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+};
+
+// one FT_Face per (file, face index); sizes are separate FT_Size objects.
+// the face and its glyph slot are not thread safe, hold lock() while loading
+class shared_face {
+public:
+    ~shared_face();
+
+    shared_face(const shared_face&) = delete;
+    shared_face& operator=(const shared_face&) = delete;
+
+    FT_Face face() const { return _face; }
+    const std::string& key() const { return _key; }
+    const std::shared_ptr<font_file>& file() const { return _file; }
+    std::unique_lock<std::mutex> lock() { return std::unique_lock<std::mutex>(_mutex); }
+
+private:
+    friend class face_cache;
+    shared_face() = default;
+
+    FT_Face _face = nullptr;
+    std::string _key;
+    std::shared_ptr<font_file> _file;
+    std::shared_ptr<ft_library> _library; // keeps the FT_Library alive until the last face is gone
+    std::mutex _mutex;
+};
+
+// a pixel size on a shared face; activate() before loading glyphs or reading metrics
+class face_size {
+public:
+    face_size(std::shared_ptr<shared_face> face, float pixel_height);
+    ~face_size();
+
+    face_size(const face_size&) = delete;
+    face_size& operator=(const face_size&) = delete;
+
+    bool valid() const { return _size != nullptr; }
+    FT_Face activate() const;
+    const std::shared_ptr<shared_face>& face() const { return _face; }
+    std::unique_lock<std::mutex> lock() const { return _face->lock(); }
+
+private:
+    std::shared_ptr<shared_face> _face;
+    FT_Size _size = nullptr;
+};
+
+// process-wide freetype state: one library, files mapped once, faces shared
+// and released when the last font using them goes away
+class face_cache {
+public:
+    static face_cache& instance();
+
+    std::shared_ptr<shared_face> open(const std::string& path, int face_index = 0);
+    std::shared_ptr<shared_face> open(const std::shared_ptr<font_file>& file, int face_index = 0);
+
+    // memory fonts: the same buffer (pointer and size) is copied only once
+    std::shared_ptr<font_file> share_memory(const void* data, size_t size);
+
+    size_t face_count();
+    size_t file_count();
+
+private:
+    face_cache();
+    std::shared_ptr<shared_face> open_locked(const std::shared_ptr<font_file>& file, int face_index);
+
+    std::mutex _mutex;
+    std::shared_ptr<ft_library> _library;
+    std::unordered_map<std::string, std::weak_ptr<font_file>> _files;
+    std::unordered_map<std::string, std::weak_ptr<shared_face>> _faces;
+};
+
+} // namespace resources
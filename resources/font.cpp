@@ -1,5 +1,13 @@
 #include "font.h"
+#include "atlas_cache.h"
+#include "resource_counters.h"
 #include "../utils/logger.h"
+#include "../utils/profiler.h"
+#include "../utils/thread_pool.h"
+#include "../utils/utf8.h"
+#include FT_GLYPH_H
+#include FT_ADVANCES_H
+#include FT_OUTLINE_H
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <vector>
@@ -9,6 +17,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <future>
 #ifdef _WIN32
 #include <wrl/client.h>
 #include <d3d11.h>
@@ -17,427 +26,880 @@
 namespace resources {
 
 namespace {
-constexpr int ATLAS_W = 1024;
-constexpr int ATLAS_H = 1024;
-constexpr uint32_t FIRST_CODEPOINT = 32;
-constexpr uint32_t LAST_CODEPOINT = 0x2FFF; // back to full unicode range
+// glyphs rasterized per pool task when preloading
+constexpr size_t PRELOAD_CHUNK = 32;
+// when over the atlas budget, this share of the evictable glyphs goes at once
+// so the scan for the oldest is paid once per batch, not per glyph
+constexpr size_t EVICT_DIVISOR = 4;
 
-// simple stubs for now
-void make_sdf(const unsigned char* src, int w, int h, unsigned char* dst, int spread = 8) {
-    // copy source to destination for now
-    std::memcpy(dst, src, w * h);
+// printable ascii, the default preload set
+std::vector<uint32_t> ascii_preload() {
+    std::vector<uint32_t> codepoints;
+    for (uint32_t c = 32; c < 127; ++c) codepoints.push_back(c);
+    return codepoints;
 }
 
-void make_mcsdf(const unsigned char* src, int w, int h, unsigned char* dst, int spread = 8) {
-    // copy source to destination for now
-    for (int i = 0; i < w * h; ++i) {
-        dst[3 * i + 0] = src[i];
-        dst[3 * i + 1] = src[i];
-        dst[3 * i + 2] = src[i];
-    }
+// last_used is stamped by glyph readers holding the table shared
+void stamp(glyph_info& glyph, uint32_t frame) {
+    std::atomic_ref<uint32_t>(glyph.last_used).store(frame, std::memory_order_relaxed);
+}
+
+// distance field range in texels around each sdf glyph
+constexpr int SDF_SPREAD = 8;
+
+// msdf fonts work from the outline and never render a bitmap
+bool supported_glyph(FT_GlyphSlot g, bool outline) {
+    if (outline) return g->format == FT_GLYPH_FORMAT_OUTLINE;
+    return g->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY || g->bitmap.pixel_mode == FT_PIXEL_MODE_MONO ||
+           g->bitmap.pixel_mode == FT_PIXEL_MODE_BGRA;
 }
 
 } // namespace
 
 font::font(const char* path, float size, bool sdf, bool mcsdf)
-    : _path(path), _size(size), _sdf(false), _mcsdf(false) {}
+    : _path(path), _size(size), _sdf(sdf), _mcsdf(mcsdf), _preload(ascii_preload()) {}
 
 font::font(const void* data, size_t size, float pixel_height, bool sdf, bool mcsdf)
-    : _path(), _size(pixel_height), _from_memory(true), _font_data(static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size), _sdf(false), _mcsdf(false) {}
+    : _path(), _size(pixel_height), _memory_file(face_cache::instance().share_memory(data, size)), _from_memory(true), _sdf(sdf), _mcsdf(mcsdf), _preload(ascii_preload()) {}
+
+font::~font() {
+    detach_atlas();
+}
+
+void font::set_atlas(std::shared_ptr<glyph_atlas> atlas) {
+    if (_face_size) {
+        utils::log_warn("font: set_atlas on loaded font '%s' ignored, unload first", _path.c_str());
+        return;
+    }
+    _shared_atlas = atlas != nullptr;
+    _atlas = atlas ? std::move(atlas) : std::make_shared<glyph_atlas>();
+}
+
+void font::detach_atlas() {
+    std::lock_guard<std::mutex> lock(_atlas->mutex());
+    if (_shared_atlas) {
+        // the other fonts keep their glyphs; geometry drawn with ours is stale
+        for (const auto& [key, glyph] : _glyphs) evict_glyph(glyph, true);
+    } else {
+        _atlas->clear();
+        _atlas->invalidate();
+    }
+    _atlas->remove_font(this);
+}
 
 #ifdef _WIN32
 bool font::load(ID3D11Device* device, resources::texture_dict* tex_dict) {
+    if (_from_memory) return load_from_memory(device, tex_dict);
 #else
 bool font::load(resources::texture_dict* tex_dict) {
+    if (_from_memory) return load_from_memory(tex_dict);
 #endif
-    if (_from_memory) return load_from_memory(device, tex_dict);
-    
-    // initialize freetype
-    if (FT_Init_FreeType(&_ft_library)) {
-        utils::log_error("Could not init FreeType");
-        return false;
-    }
-    
-    if (FT_New_Face(_ft_library, _path.c_str(), 0, &_ft_face)) {
-        utils::log_error("Failed to load font file: %s", _path.c_str());
-        FT_Done_FreeType(_ft_library);
-        _ft_library = nullptr;
+    return load_face(tex_dict);
+}
+
+#ifdef _WIN32
+bool font::load_from_memory(ID3D11Device* device, resources::texture_dict* tex_dict) {
+#else
+bool font::load_from_memory(resources::texture_dict* tex_dict) {
+#endif
+    if (!_from_memory) {
+        utils::log_error("font: load_from_memory on file font '%s'", _path.c_str());
         return false;
     }
+    return load_face(tex_dict);
+}
+
+bool font::load_face(resources::texture_dict* tex_dict) {
+    FV_PROFILE_SCOPE("font::load");
+    // faces come from the shared cache: the file is mapped once for every size,
+    // memory fonts share one copy of their buffer
+    if (!open_face()) return false;
     
-    // set font size using proper size request (like inspiration code)
-    FT_Size_RequestRec req;
-    req.type = FT_SIZE_REQUEST_TYPE_REAL_DIM;
-    req.width = 0;
-    req.height = static_cast<FT_Long>(_size * 64);
-    req.horiResolution = 0;
-    req.vertResolution = 0;
-    if (FT_Request_Size(_ft_face, &req) != 0) {
-        utils::log_error("FT_Request_Size failed");
-        return false;
+    // pages get their textures through the dict and only receive the
+    // rectangles packed since the last flush
+    if (!tex_dict && !_atlas->dict()) {
+        utils::log_warn("font: no texture dictionary for '%s', atlas stays in system memory", _path.c_str());
     }
-    
-    // initialize first atlas page
-    _atlas_pages.clear();
-    _atlas_page_widths.clear();
-    _atlas_page_heights.clear();
-    
-    // allocate RGBA atlas
-    _atlas_pages.push_back(std::vector<unsigned char>(ATLAS_W * ATLAS_H * 4, 0));
-    _atlas_page_widths.push_back(ATLAS_W);
-    _atlas_page_heights.push_back(ATLAS_H);
-    
-    _current_page = 0;
-    _current_x = 0;
-    _current_y = 0;
-    _current_row_height = 0;
-    
+    // a shared atlas may have fonts loading on other threads; until this one
+    // is done the others leave its glyphs alone, and it evicts nothing
+    auto set_loading = [this, tex_dict](bool loading) {
+        std::lock_guard<std::mutex> lock(_atlas->mutex());
+        _atlas->attach(tex_dict);
+        _atlas->add_font(this);
+        _loading = loading;
+    };
+    set_loading(true);
     _has_kerning = FT_HAS_KERNING(_ft_face);
     _colored = (FT_HAS_COLOR(_ft_face) != 0);
+    check_mcsdf();
+    build_coverage();
+    clear_layout_caches();
+    _atlas_width = _atlas->page_width();
+    _atlas_height = _atlas->page_height();
     
-    // load basic ascii glyphs immediately
-    for (uint32_t c = 32; c <= 127; ++c) {
-        ensure_glyph(c);
+    // warm start: pages, glyphs and metrics come from the disk cache; only
+    // preload glyphs it does not hold yet are rasterized
+    if (restore_atlas_cache()) {
+        if (preload_glyphs() > 0) save_atlas_cache();
+        set_loading(false);
+        flush_atlas();
+        return true;
     }
     
+    {
+        std::lock_guard<std::mutex> lock(_atlas->mutex());
+        if (!_shared_atlas) _atlas->clear();
+        int& current = _atlas->current_page(_mcsdf ? texture_format::rgba8 : texture_format::r8);
+        if (current < 0) current = _atlas->add_page(_mcsdf ? texture_format::rgba8 : texture_format::r8);
+    }
+    
+    // only the preload set is rasterized up front; everything else is paged
+    // in by ensure_glyph / ensure_glyph_async on first use
+    preload_glyphs();
+    
     // calculate metrics using FT_CEIL (like inspiration code)
+    auto face_lock = _face_size->lock();
+    _ft_face = _face_size->activate();
     const auto& metrics = _ft_face->size->metrics;
     _metrics.ascender = static_cast<float>((metrics.ascender + 63) >> 6);  // equivalent to FT_CEIL
     _metrics.descender = static_cast<float>((metrics.descender + 63) >> 6);
     _metrics.line_height = static_cast<float>((metrics.height + 63) >> 6);
     _metrics.line_gap = static_cast<float>((metrics.height - metrics.ascender + metrics.descender + 63) >> 6);
     _metrics.max_advance = static_cast<float>((metrics.max_advance + 63) >> 6);
+    face_lock.unlock();
     
-    // ensure atlas dimensions and bitmap are set for D3D11
-    _atlas_width = ATLAS_W;
-    _atlas_height = ATLAS_H;
-    _atlas_bitmap = _atlas_pages[0];
+    save_atlas_cache();
+    set_loading(false);
+    flush_atlas();
+    return true;
+}
+
+size_t font::preload_glyphs() {
+    FV_PROFILE_SCOPE("font::preload_glyphs");
+    std::vector<uint32_t> todo;
+    {
+        std::shared_lock<std::shared_mutex> glyphs(_glyph_mutex);
+        std::lock_guard<std::mutex> queue(_queue_mutex);
+        for (uint32_t c : _preload) {
+            if (covers(c) && !find_glyph(c) && !_missing.count(c)) todo.push_back(c);
+        }
+    }
+    if (todo.empty()) return 0;
     
-#ifdef _WIN32
-    // Create D3D11 texture for the atlas
-    ID3D11Device* device_to_use = device ? device : nullptr; // TODO: get device from renderer
-    D3D11_TEXTURE2D_DESC desc = {};
-    desc.Width = _atlas_width;
-    desc.Height = _atlas_height;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM; // DXGI_FORMAT_R8G8B8A8_UNORM for rgba, DXGI_FORMAT_R8_UNORM for grayscale
-    desc.SampleDesc.Count = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-
-    D3D11_SUBRESOURCE_DATA subres = {};
-    subres.pSysMem = _atlas_bitmap.data();
-    subres.SysMemPitch = _atlas_width * 4; // 4 for RGBA, 1 for grayscale
-
-    Microsoft::WRL::ComPtr<ID3D11Texture2D> tex;
-    HRESULT hr = device_to_use->CreateTexture2D(&desc, &subres, &tex);
-   
-    if (FAILED(hr)) {
-        utils::log_error("CreateTexture2D failed: 0x%08X", hr);
-    }
-    if (SUCCEEDED(hr)) {
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Format = desc.Format;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
-        device_to_use->CreateShaderResourceView(tex.Get(), &srvDesc, &_atlas_srv);
-        
-        // create proper resources::tex handle using texture dictionary
-        if (tex_dict) {
-            _atlas_tex = tex_dict->create_texture_from_d3d11(tex.Get(), _atlas_srv.Get());
+    // rasterize in chunks on the shared pool and pack in preload order here,
+    // so the atlas layout does not depend on thread timing. small sets, and
+    // loads already running on a pool worker, stay on this thread
+    auto& pool = utils::thread_pool::shared();
+    const size_t chunk = PRELOAD_CHUNK;
+    std::vector<std::future<std::vector<glyph_bitmap>>> jobs;
+    if (todo.size() > chunk && !pool.in_worker()) {
+        for (size_t i = chunk; i < todo.size(); i += chunk) {
+            std::vector<uint32_t> codepoints(todo.begin() + i, todo.begin() + std::min(todo.size(), i + chunk));
+            jobs.push_back(pool.async([size = _face_size, options = raster_mode(), codepoints = std::move(codepoints)]() {
+                std::vector<glyph_bitmap> out;
+                out.reserve(codepoints.size());
+                for (uint32_t c : codepoints) {
+                    glyph_bitmap bitmap;
+                    if (rasterize(*size, c, options, bitmap)) out.push_back(std::move(bitmap));
+                }
+                return out;
+            }));
         }
+        todo.resize(chunk);
     }
-#endif
-    return true;
+    
+    size_t packed = 0;
+    auto pack = [&](const glyph_bitmap& bitmap) {
+        std::unique_lock<std::shared_mutex> glyphs(_glyph_mutex);
+        if (find_glyph(bitmap.codepoint)) return;
+        if (pack_bitmap(bitmap, true)) ++packed;
+    };
+    // the first chunk (or everything) runs here while the workers start up
+    for (uint32_t c : todo) {
+        glyph_bitmap bitmap;
+        if (!rasterize(*_face_size, c, raster_mode(), bitmap)) {
+            std::lock_guard<std::mutex> queue(_queue_mutex);
+            _missing.insert(c);
+            continue;
+        }
+        pack(bitmap);
+    }
+    for (auto& job : jobs) {
+        for (const auto& bitmap : job.get()) pack(bitmap);
+    }
+    return packed;
 }
 
-#ifdef _WIN32
-bool font::load_from_memory(ID3D11Device* device, resources::texture_dict* tex_dict) {
-#else
-bool font::load_from_memory(resources::texture_dict* tex_dict) {
-#endif
-    if (FT_Init_FreeType(&_ft_library)) {
-        utils::log_error("Could not init FreeType");
+void font::set_preload(std::vector<uint32_t> codepoints) {
+    _preload = std::move(codepoints);
+}
+
+void font::add_preload_text(std::string_view utf8) {
+    std::unordered_set<uint32_t> known(_preload.begin(), _preload.end());
+    for (uint32_t c : utils::decode_utf8(utf8)) {
+        if (c >= 32 && known.insert(c).second) _preload.push_back(c);
+    }
+}
+
+void font::build_coverage() {
+    // walk the active charmap once; fallback resolution and glyph requests
+    // then answer "is it in this face" without touching freetype
+    _coverage.clear();
+    {
+        std::unique_lock<std::shared_mutex> fallbacks(_fallback_mutex);
+        _fallback_cache.clear();
+    }
+    auto lock = _face_size->lock();
+    FT_Face face = _face_size->activate();
+    FT_UInt index = 0;
+    FT_ULong c = FT_Get_First_Char(face, &index);
+    while (index != 0) {
+        _coverage.insert(static_cast<uint32_t>(c));
+        c = FT_Get_Next_Char(face, c, &index);
+    }
+}
+
+bool font::open_face() {
+    auto& cache = face_cache::instance();
+    _face = _from_memory ? cache.open(_memory_file) : cache.open(_path);
+    if (!_face) {
+        utils::log_error(_from_memory ? "Failed to load font from memory" : "Failed to load font file: %s", _path.c_str());
         return false;
     }
-    if (FT_New_Memory_Face(_ft_library, _font_data.data(), static_cast<FT_Long>(_font_data.size()), 0, &_ft_face)) {
-        utils::log_error("Failed to load font from memory");
-        FT_Done_FreeType(_ft_library);
+    _face_size = std::make_shared<face_size>(_face, _size);
+    if (!_face_size->valid()) {
+        close_face();
         return false;
     }
-    // set font size using proper size request (like inspiration code)
-    FT_Size_RequestRec req;
-    req.type = FT_SIZE_REQUEST_TYPE_REAL_DIM;
-    req.width = 0;
-    req.height = static_cast<FT_Long>(_size * 64);
-    req.horiResolution = 0;
-    req.vertResolution = 0;
-    if (FT_Request_Size(_ft_face, &req) != 0) {
-        utils::log_error("FT_Request_Size failed");
-    return false;
+    _ft_face = _face_size->activate();
+    return true;
+}
+
+void font::close_face() {
+    // the size goes first, it lives on the face
+    _face_size.reset();
+    _face.reset();
+    _ft_face = nullptr;
 }
+
+void font::check_mcsdf() {
+    // bitmap-only and color faces have no usable outlines for msdf
+    if (_mcsdf && (!FT_IS_SCALABLE(_ft_face) || _colored)) {
+        utils::log_warn("font: '%s' has no plain outlines, using %s instead of msdf", _path.c_str(), _sdf ? "sdf" : "coverage");
+        _mcsdf = false;
+    }
+}
+
+atlas_cache_key font::atlas_key() const {
+    atlas_cache_key key;
+    const auto& file = _from_memory ? _memory_file : (_face ? _face->file() : nullptr);
+    if (file) key.font_hash = file->content_hash();
+    key.size = _size;
+    key.flags = (_sdf ? static_cast<uint32_t>(atlas_cache::flag_sdf) : 0u) |
+                (_mcsdf ? static_cast<uint32_t>(atlas_cache::flag_msdf) : 0u) |
+                (_colored ? static_cast<uint32_t>(atlas_cache::flag_colored) : 0u) |
+                (static_cast<uint32_t>(subpixel_positions() - 1) << atlas_cache::subpixel_shift);
+    return key;
+}
+
+bool font::restore_atlas_cache() {
+    // cached pages hold one font's glyphs only
+    if (!atlas_cache::enabled() || _shared_atlas) return false;
+    atlas_cache::reader reader;
+    if (!reader.open(atlas_key())) return false;
+    for (const auto& page : reader.pages()) {
+        if (page.width != _atlas->page_width() || page.height != _atlas->page_height()) return false;
+    }
     
-    _atlas_width = ATLAS_W;
-    _atlas_height = ATLAS_H;
-    _atlas_bitmap.assign(_atlas_width * _atlas_height * 4, 0);
-    int x = 0, y = 0, row_h = 0;
-    _has_kerning = FT_HAS_KERNING(_ft_face);
-    _colored = (FT_HAS_COLOR(_ft_face) != 0);
-    for (uint32_t c = FIRST_CODEPOINT; c <= LAST_CODEPOINT; ++c) {
-        // skip codepoints not present in this face; avoid packing .notdef
-        FT_UInt glyph_index = FT_Get_Char_Index(_ft_face, c);
-        if (glyph_index == 0) continue;
-        if (FT_Load_Char(_ft_face, c, FT_LOAD_RENDER)) continue;
-        FT_GlyphSlot g = _ft_face->glyph;
-        
-        // atlas layout logic
-        if (x + g->bitmap.width >= _atlas_width) {
-            x = 0;
-            y += row_h;
-            row_h = 0;
-        }
-        if (y + g->bitmap.rows >= _atlas_height) {
-            utils::log_error("Font atlas overflow for memory font at codepoint U+%04X", c);
-            break;
-        }
-        
+    std::unique_lock<std::shared_mutex> glyphs(_glyph_mutex);
+    std::lock_guard<std::mutex> lock(_atlas->mutex());
+    _atlas->clear();
+    _glyphs.clear();
+    for (const auto& page : reader.pages()) {
+        int index = _atlas->add_page(page.format);
+        _atlas->pages()[index].restore(page.pixels, page.shelf);
+        // packing continues on the last page of each format
+        _atlas->current_page(page.format) = index;
+    }
+    for (const auto& glyph : reader.glyphs()) {
+        _glyphs[glyph_key(glyph.codepoint, glyph.phase)] = glyph;
+    }
+    _metrics = reader.metrics();
+    utils::log_debug("font: '%s' %.1fpx restored %zu glyphs from the atlas cache", _path.c_str(), _size, _glyphs.size());
+    return true;
+}
+
+bool font::save_atlas_cache() const {
+    if (!atlas_cache::enabled() || _shared_atlas || _atlas->pages().empty()) return false;
+    auto key = atlas_key();
+    if (key.font_hash == 0) return false;
+    std::shared_lock<std::shared_mutex> glyphs(_glyph_mutex);
+    std::lock_guard<std::mutex> lock(_atlas->mutex());
+    return atlas_cache::write(key, _metrics, _atlas->pages(), _glyphs);
+}
+
+bool font::rasterize(const face_size& size, uint32_t codepoint, const raster_options& options, glyph_bitmap& out, int phase) {
+    FV_PROFILE_SCOPE("font::rasterize");
+    out = glyph_bitmap{};
+    out.codepoint = codepoint;
+    out.phase = phase;
+    
+    // the face and its glyph slot are shared with other sizes: everything read
+    // from the slot is copied out before the lock is released
+    auto lock = size.lock();
+    FT_Face face = size.activate();
+    if (!face) return false;
+    
+    // ensure this face actually contains the character; skip .notdef (index 0)
+    if (FT_Get_Char_Index(face, codepoint) == 0) return false;
+    resource_counters::shared().glyph_rasterizations.fetch_add(1, std::memory_order_relaxed);
+    
+    // subpixel fonts hint vertically only, so every phase has the same shape;
+    // variants render after shifting the outline right by phase / subpixel px
+    FT_Int32 flags = options.msdf ? FT_LOAD_NO_BITMAP : FT_LOAD_RENDER | (options.colored ? FT_LOAD_COLOR : 0);
+    if (options.subpixel > 1) flags |= FT_LOAD_TARGET_LIGHT;
+    if (phase > 0) flags &= ~(FT_LOAD_RENDER | FT_LOAD_COLOR);
+    if (FT_Load_Char(face, codepoint, flags)) {
+        utils::log_warn("Failed to load glyph U+%04X", codepoint);
+        return false;
+    }
+    FT_GlyphSlot g = face->glyph;
+    if (phase > 0) {
+        if (g->format != FT_GLYPH_FORMAT_OUTLINE) return false; // bitmap strikes can't shift
+        FT_Outline_Translate(&g->outline, phase * 64 / options.subpixel, 0);
+        if (FT_Render_Glyph(g, FT_RENDER_MODE_LIGHT)) return false;
+    }
+    if (!supported_glyph(g, options.msdf)) {
+        utils::log_warn("Unsupported pixel mode %d for glyph U+%04X", g->bitmap.pixel_mode, codepoint);
+        return false;
+    }
+    out.advance = options.subpixel > 1 ? g->linearHoriAdvance / 65536.0f : static_cast<float>(g->advance.x >> 6);
+    
+    if (options.msdf) {
+        // work on a copy of the outline so other threads can use the face meanwhile
+        FT_Glyph glyph = nullptr;
+        if (FT_Get_Glyph(g, &glyph) != 0) return false;
+        lock.unlock();
+        msdf_bitmap field;
+        make_msdf(reinterpret_cast<FT_OutlineGlyph>(glyph)->outline, SDF_SPREAD, field);
+        FT_Done_Glyph(glyph);
+        out.width = field.width;
+        out.height = field.height;
+        out.bearing_x = field.left;
+        out.bearing_y = field.top;
+        out.format = texture_format::rgba8;
+        out.pixels = std::move(field.rgba);
+        return true;
+    }
+    
+    const int w = static_cast<int>(g->bitmap.width);
+    const int h = static_cast<int>(g->bitmap.rows);
+    
+    // coverage goes to single-channel pages; rgba pages only exist once a
+    // color glyph actually shows up
+    out.colored = g->bitmap.pixel_mode == FT_PIXEL_MODE_BGRA;
+    out.format = out.colored ? texture_format::rgba8 : texture_format::r8;
+    out.width = w;
+    out.height = h;
+    out.bearing_x = g->bitmap_left;
+    out.bearing_y = g->bitmap_top;
+    
+    const int bpp = static_cast<int>(bytes_per_texel(out.format));
+    out.pixels.resize(static_cast<size_t>(w) * h * bpp);
+    for (int j = 0; j < h; ++j) {
+        unsigned char* dst = out.pixels.data() + static_cast<size_t>(j) * w * bpp;
+        const unsigned char* src = g->bitmap.buffer + j * g->bitmap.pitch;
         if (g->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY) {
-            // 8-bit per pixel
-            for (int j = 0; j < g->bitmap.rows; ++j) {
-                for (int i = 0; i < g->bitmap.width; ++i) {
-                    int atlas_idx = 4 * ((x + i) + (y + j) * _atlas_width);
-                    unsigned char mask = g->bitmap.buffer[j * g->bitmap.pitch + i];
-                    _atlas_bitmap[atlas_idx + 0] = 255;
-                    _atlas_bitmap[atlas_idx + 1] = 255;
-                    _atlas_bitmap[atlas_idx + 2] = 255;
-                    _atlas_bitmap[atlas_idx + 3] = mask;
-                }
-            }
+            std::memcpy(dst, src, w);
         } else if (g->bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
             // 1-bit per pixel, each byte is 8 pixels
-            for (int j = 0; j < g->bitmap.rows; ++j) {
-                for (int i = 0; i < g->bitmap.width; ++i) {
-                    int atlas_idx = 4 * ((x + i) + (y + j) * _atlas_width);
-                    int byte = g->bitmap.buffer[j * g->bitmap.pitch + (i >> 3)];
-                    int bit = 7 - (i & 7);
-                    unsigned char mask = (byte & (1 << bit)) ? 255 : 0;
-                    _atlas_bitmap[atlas_idx + 0] = 255;
-                    _atlas_bitmap[atlas_idx + 1] = 255;
-                    _atlas_bitmap[atlas_idx + 2] = 255;
-                    _atlas_bitmap[atlas_idx + 3] = mask;
-                }
+            for (int i = 0; i < w; ++i) {
+                dst[i] = (src[i >> 3] & (1 << (7 - (i & 7)))) ? 255 : 0;
             }
         } else {
-            // unsupported pixel mode
-            utils::log_warn("Unsupported pixel mode %d for glyph U+%04X", g->bitmap.pixel_mode, c);
-            continue;
+            // premultiplied bgra -> straight rgba for the alpha blend state
+            for (int i = 0; i < w; ++i) {
+                unsigned char b = src[4 * i + 0], gr = src[4 * i + 1], r = src[4 * i + 2], a = src[4 * i + 3];
+                dst[4 * i + 0] = a ? static_cast<unsigned char>(std::min(255, r * 255 / a)) : 0;
+                dst[4 * i + 1] = a ? static_cast<unsigned char>(std::min(255, gr * 255 / a)) : 0;
+                dst[4 * i + 2] = a ? static_cast<unsigned char>(std::min(255, b * 255 / a)) : 0;
+                dst[4 * i + 3] = a;
+            }
         }
-        glyph_info info;
-        info.u0 = float(x) / _atlas_width;
-        info.v0 = float(y) / _atlas_height;
-        info.u1 = float(x + g->bitmap.width) / _atlas_width;
-        info.v1 = float(y + g->bitmap.rows) / _atlas_height;
-        info.width = g->bitmap.width;
-        info.height = g->bitmap.rows;
-        info.advance = g->advance.x >> 6;
-        info.bearingX = g->bitmap_left;
-        info.bearingY = g->bitmap_top;
-        info.codepoint = c;
-        info.colored = _colored;
-        _glyphs[c] = info;
-        x += g->bitmap.width + 1;
-        row_h = (row_h > static_cast<int>(g->bitmap.rows)) ? row_h : static_cast<int>(g->bitmap.rows);
     }
-    // calculate metrics using FT_CEIL (like inspiration code)
-    const auto& metrics = _ft_face->size->metrics;
-    _metrics.ascender = static_cast<float>((metrics.ascender + 63) >> 6);  // equivalent to FT_CEIL
-    _metrics.descender = static_cast<float>((metrics.descender + 63) >> 6);
-    _metrics.line_height = static_cast<float>((metrics.height + 63) >> 6);
-    _metrics.line_gap = static_cast<float>((metrics.height - metrics.ascender + metrics.descender + 63) >> 6);
-    _metrics.max_advance = static_cast<float>((metrics.max_advance + 63) >> 6);
-    FT_Done_Face(_ft_face);
-    FT_Done_FreeType(_ft_library);
-#ifdef _WIN32
-    // Create D3D11 texture for the atlas
-    ID3D11Device* device_to_use = device ? device : nullptr;
-    D3D11_TEXTURE2D_DESC desc = {};
-    desc.Width = _atlas_width;
-    desc.Height = _atlas_height;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    desc.SampleDesc.Count = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    D3D11_SUBRESOURCE_DATA subres = {};
-    subres.pSysMem = _atlas_bitmap.data();
-    subres.SysMemPitch = _atlas_width * 4;
-    Microsoft::WRL::ComPtr<ID3D11Texture2D> tex;
-    HRESULT hr = device_to_use->CreateTexture2D(&desc, &subres, &tex);
-    if (SUCCEEDED(hr)) {
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Format = desc.Format;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
-        device_to_use->CreateShaderResourceView(tex.Get(), &srvDesc, &_atlas_srv);
+    lock.unlock();
+    
+    // sdf glyphs grow by the spread on every side so the field can fall off
+    // outside the outline; color glyphs stay as plain bitmaps
+    if (options.sdf && !out.colored && w > 0 && h > 0) {
+        const int sw = sdf_extent(w, SDF_SPREAD);
+        const int sh = sdf_extent(h, SDF_SPREAD);
+        std::vector<unsigned char> field(static_cast<size_t>(sw) * sh);
+        make_sdf(out.pixels.data(), w, h, w, field.data(), SDF_SPREAD);
+        out.pixels = std::move(field);
+        out.width = sw;
+        out.height = sh;
+        out.bearing_x -= SDF_SPREAD;
+        out.bearing_y += SDF_SPREAD;
     }
-#endif
     return true;
 }
 
-#ifdef _WIN32
-void font::update_atlas_texture(ID3D11Device* device) {
-    if (!device) return;
+bool font::pack_bitmap(const glyph_bitmap& bitmap, bool allow_new_page) {
+    const int w = bitmap.width;
+    const int h = bitmap.height;
     
-    // create new texture with updated atlas data
-    D3D11_TEXTURE2D_DESC desc = {};
-    desc.Width = _atlas_width;
-    desc.Height = _atlas_height;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    desc.SampleDesc.Count = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-
-    D3D11_SUBRESOURCE_DATA subres = {};
-    subres.pSysMem = _atlas_bitmap.data();
-    subres.SysMemPitch = _atlas_width * 4;
-
-    Microsoft::WRL::ComPtr<ID3D11Texture2D> tex;
-    HRESULT hr = device->CreateTexture2D(&desc, &subres, &tex);
+    // color glyphs go to rgba pages, msdf fonts are rgba throughout. fonts
+    // sharing the atlas continue on the same page of each format
+    std::lock_guard<std::mutex> lock(_atlas->mutex());
+    auto& pages = _atlas->pages();
+    int& current = _atlas->current_page(bitmap.format);
+    atlas_rect rect;
+    if (current < 0 || !pages[current].pack(w, h, rect)) {
+        if (current >= 0 && !allow_new_page) return false;
+        int page = -1;
+        const size_t page_bytes = static_cast<size_t>(_atlas->page_width()) * _atlas->page_height() * bytes_per_texel(bitmap.format);
+        const size_t budget = _atlas->budget();
+        if (budget > 0 && !_loading && _atlas->bytes() + page_bytes > budget) {
+            page = make_room(bitmap.format, w, h, rect);
+            if (page < 0) {
+                utils::log_warn("font: '%s' %.1fpx atlas over its %zu byte budget, nothing old enough to evict",
+                                _path.c_str(), _size, budget);
+            }
+        }
+        if (page < 0) {
+            page = _atlas->add_page(bitmap.format);
+            if (!pages[page].pack(w, h, rect)) {
+                utils::log_warn("Glyph U+%04X (%dx%d) does not fit in an atlas page", bitmap.codepoint, w, h);
+                return false;
+            }
+        }
+        current = page;
+    }
     
-    if (SUCCEEDED(hr)) {
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Format = desc.Format;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
-        device->CreateShaderResourceView(tex.Get(), &srvDesc, &_atlas_srv);
-        
-        // update the texture handle if we have a texture dictionary
-        // note: this requires the font to have been loaded with a texture dictionary
-        // for now, we'll keep the existing handle and just update the SRV
-        if (_atlas_tex) {
-            // the texture handle should already exist, so we just need to update the underlying D3D11 texture
-            // for now, we'll keep the existing handle and just update the SRV
+    auto& page = pages[current];
+    page.write(rect, bitmap.pixels.data(), w * page.bytes_per_pixel());
+    
+    glyph_info info;
+    info.u0 = float(rect.x) / page.width();
+    info.v0 = float(rect.y) / page.height();
+    info.u1 = float(rect.x + w) / page.width();
+    info.v1 = float(rect.y + h) / page.height();
+    info.width = w;
+    info.height = h;
+    info.advance = bitmap.advance;
+    info.bearingX = bitmap.bearing_x;
+    info.bearingY = bitmap.bearing_y;
+    info.codepoint = bitmap.codepoint;
+    info.colored = bitmap.colored;
+    info.page = current;
+    info.phase = bitmap.phase;
+    _glyphs[glyph_key(bitmap.codepoint, bitmap.phase)] = info;
+    return true;
+}
+
+int font::make_room(texture_format format, int w, int h, atlas_rect& out) {
+    auto& pages = _atlas->pages();
+    const uint32_t frame = _atlas->frame();
+    // after evictions the free lists are rebuilt from the glyphs left, which
+    // merges the space of neighbours evicted one by one
+    auto pack_any = [&](bool reclaim) {
+        for (int i = 0; i < static_cast<int>(pages.size()); ++i) {
+            if (pages[i].format() != format) continue;
+            if (pages[i].pack(w, h, out)) return i;
+            if (!reclaim) continue;
+            std::vector<atlas_rect> live;
+            for (const font* f : _atlas->fonts()) {
+                for (const auto& [key, glyph] : f->_glyphs) {
+                    if (glyph.page == i) live.push_back(glyph_rect(glyph));
+                }
+            }
+            pages[i].reclaim(std::move(live));
+            if (pages[i].pack(w, h, out)) return i;
+        }
+        return -1;
+    };
+    // space freed by earlier evictions
+    int page = pack_any(false);
+    if (page >= 0) return page;
+
+    // glyphs of other fonts only go when their table can be taken for
+    // writing right away: a font being drawn or packing on another thread
+    // keeps its glyphs this time. try_lock only, this thread already holds
+    // its own table and the atlas mutex
+    std::vector<std::unique_lock<std::shared_mutex>> locked;
+    std::vector<font*> owners;
+    for (font* f : _atlas->fonts()) {
+        if (f->_loading) continue;
+        if (f != this) {
+            std::unique_lock<std::shared_mutex> lock(f->_glyph_mutex, std::try_to_lock);
+            if (!lock.owns_lock()) continue;
+            locked.push_back(std::move(lock));
+        }
+        owners.push_back(f);
+    }
+
+    // least recently drawn glyphs of this format among them. never ones
+    // drawn this frame, whose geometry may not have been submitted yet, nor
+    // ones on pages pinned by static text
+    struct candidate {
+        uint32_t last_used;
+        font* owner;
+        uint32_t key;
+    };
+    std::vector<candidate> candidates;
+    for (font* f : owners) {
+        for (const auto& [key, glyph] : f->_glyphs) {
+            if (glyph.last_used < frame && pages[glyph.page].format() == format && !_atlas->pinned(glyph.page)) {
+                candidates.push_back({glyph.last_used, f, key});
+            }
+        }
+    }
+    auto older = [](const candidate& a, const candidate& b) { return a.last_used < b.last_used; };
+    const size_t batch = std::max<size_t>(candidates.size() / EVICT_DIVISOR, 1);
+    for (size_t first = 0; first < candidates.size(); first += batch) {
+        const size_t last = std::min(first + batch, candidates.size());
+        std::nth_element(candidates.begin() + first, candidates.begin() + (last - 1), candidates.end(), older);
+        for (size_t i = first; i < last; ++i) {
+            auto& glyphs = candidates[i].owner->_glyphs;
+            auto it = glyphs.find(candidates[i].key);
+            evict_glyph(it->second, true);
+            glyphs.erase(it);
+        }
+        page = pack_any(true);
+        if (page >= 0) return page;
+    }
+
+    // freed space too fragmented for this glyph: recycle the page drawn from
+    // least recently, provided nothing on it was drawn this frame
+    std::vector<uint32_t> newest(pages.size(), 0);
+    for (const font* f : _atlas->fonts()) {
+        const bool owned = std::find(owners.begin(), owners.end(), f) != owners.end();
+        for (const auto& [key, glyph] : f->_glyphs) {
+            newest[glyph.page] = owned ? std::max(newest[glyph.page], glyph.last_used) : UINT32_MAX;
+        }
+    }
+    for (int i = 0; i < static_cast<int>(pages.size()); ++i) {
+        if (pages[i].format() != format || newest[i] >= frame || _atlas->pinned(i)) continue;
+        if (page < 0 || newest[i] < newest[page]) page = i;
+    }
+    if (page < 0) return -1;
+    for (font* f : owners) {
+        for (auto it = f->_glyphs.begin(); it != f->_glyphs.end();) {
+            if (it->second.page == page) {
+                evict_glyph(it->second, false);
+                it = f->_glyphs.erase(it);
+            } else {
+                ++it;
+            }
         }
-    } else {
-        utils::log_error("Failed to update atlas texture: 0x%08X", hr);
     }
+    pages[page].reset();
+    return pages[page].pack(w, h, out) ? page : -1;
+}
+
+atlas_rect font::glyph_rect(const glyph_info& glyph) const {
+    const auto& page = _atlas->pages()[glyph.page];
+    return {static_cast<int>(std::lround(glyph.u0 * page.width())), static_cast<int>(std::lround(glyph.v0 * page.height())),
+            glyph.width, glyph.height};
+}
+
+void font::evict_glyph(const glyph_info& glyph, bool release) {
+    if (release) _atlas->pages()[glyph.page].release(glyph_rect(glyph));
+    _atlas->note_evicted(glyph.last_used, glyph.page);
+}
+
+const glyph_info* font::find_glyph(uint32_t key) const {
+    auto it = _glyphs.find(key);
+    return it != _glyphs.end() ? &it->second : nullptr;
+}
+
+const glyph_info* font::use_glyph(uint32_t key) {
+    std::shared_lock<std::shared_mutex> lock(_glyph_mutex);
+    auto it = _glyphs.find(key);
+    auto& counters = resource_counters::shared();
+    if (it == _glyphs.end()) {
+        counters.glyph_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    counters.glyph_hits.fetch_add(1, std::memory_order_relaxed);
+    stamp(it->second, _atlas->frame());
+    return &it->second;
+}
+
+const glyph_info* glyph_reader::use(font& f, uint32_t key) {
+    auto held = std::find_if(_held.begin(), _held.end(), [&](const auto& entry) { return entry.first == &f; });
+    if (held == _held.end()) {
+        // blocking on a second table while holding others could deadlock
+        // against a writer waiting on one of them: start over holding none
+        std::shared_lock<std::shared_mutex> lock(f._glyph_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            _held.clear();
+            lock.lock();
+        }
+        _held.emplace_back(&f, std::move(lock));
+    }
+    auto it = f._glyphs.find(key);
+    auto& counters = resource_counters::shared();
+    if (it == f._glyphs.end()) {
+        counters.glyph_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    counters.glyph_hits.fetch_add(1, std::memory_order_relaxed);
+    stamp(it->second, f._atlas->frame());
+    return &it->second;
+}
+
+const std::vector<unsigned char>& font::atlas_bitmap() const {
+    static const std::vector<unsigned char> empty;
+    const auto& pages = _atlas->pages();
+    return pages.empty() ? empty : pages.front().pixels();
+}
+
+resources::tex font::get_atlas_tex(int page) const {
+    // another font on the atlas may be adding a page
+    std::lock_guard<std::mutex> lock(_atlas->mutex());
+    const auto& pages = _atlas->pages();
+    if (page < 0 || page >= static_cast<int>(pages.size())) return nullptr;
+    return pages[page].texture();
+}
+
+bool font::atlas_dirty() const {
+    return _atlas->dirty();
+}
+
+size_t font::flush_atlas() {
+    FV_PROFILE_SCOPE("font::flush_atlas");
+    std::lock_guard<std::mutex> lock(_atlas->mutex());
+    return _atlas->flush();
+}
+
+#ifdef _WIN32
+ID3D11ShaderResourceView* font::get_atlas_srv(int page) const {
+    auto tex = get_atlas_tex(page);
+    return tex ? tex->get_srv() : nullptr;
 }
 #endif
 
 void font::unload() {
-    _glyphs.clear();
-    _atlas_pages.clear();
-    _atlas_page_widths.clear();
-    _atlas_page_heights.clear();
-    _pending_glyphs.clear();
-    
-    if (_ft_face) {
-        FT_Done_Face(_ft_face);
-        _ft_face = nullptr;
+    {
+        std::unique_lock<std::shared_mutex> glyphs(_glyph_mutex);
+        detach_atlas();
+        _glyphs.clear();
     }
-    if (_ft_library) {
-        FT_Done_FreeType(_ft_library);
-        _ft_library = nullptr;
+    {
+        // running jobs finish into the old queue and are dropped
+        std::lock_guard<std::mutex> queue(_queue_mutex);
+        _jobs->cancelled = true;
+        _jobs = std::make_shared<glyph_jobs>();
+        _pending.clear();
+        _missing.clear();
     }
+    _coverage.clear();
+    {
+        std::unique_lock<std::shared_mutex> fallbacks(_fallback_mutex);
+        _fallback_cache.clear();
+    }
+    clear_layout_caches();
+    
+    close_face();
 }
 
 int font::get_glyph_page(uint32_t codepoint) const {
-    auto it = _glyphs.find(codepoint);
-    if (it != _glyphs.end()) {
-        // for now, assume all glyphs are on page 0 since we're not using multi-page atlas yet
-        return 0;
-    }
-    return -1;
+    std::shared_lock<std::shared_mutex> lock(_glyph_mutex);
+    const auto* glyph = find_glyph(codepoint);
+    return glyph ? glyph->page : -1;
 }
 
 float font::size() const { return _size; }
 
-int font::get_kerning(uint32_t left, uint32_t right) {
-    if (_glyphs.empty() || !_has_kerning) return 0;
-    FT_Init_FreeType(&_ft_library);
-    if (_from_memory) {
-        FT_New_Memory_Face(_ft_library, _font_data.data(), static_cast<FT_Long>(_font_data.size()), 0, &_ft_face);
+float font::load_advance(uint32_t codepoint) {
+    const bool ascii = codepoint < 128;
+    std::lock_guard<std::mutex> layout(_layout_mutex);
+    if (!ascii) {
+        if (auto it = _advances.find(codepoint); it != _advances.end()) return it->second;
+    }
+    
+    // ask freetype for the hinted advance with the flags rasterize uses, which
+    // skips rendering. the glyph table isn't consulted: callers may be holding
+    // it through a glyph_reader
+    float result = 0.0f;
+    if (_face_size && covers(codepoint)) {
+        auto lock = _face_size->lock();
+        FT_Face face = _face_size->activate();
+        FT_Fixed fixed = 0;
+        // subpixel fonts advance by the unhinted (linear) width
+        FT_Int32 flags = _mcsdf ? FT_LOAD_NO_BITMAP : FT_LOAD_DEFAULT;
+        if (subpixel_positions() > 1) flags = FT_LOAD_NO_HINTING;
+        if (FT_Get_Advance(face, FT_Get_Char_Index(face, codepoint), flags, &fixed) == 0) {
+            result = subpixel_positions() > 1 ? fixed / 65536.0f : static_cast<float>(fixed >> 16);
+        }
+    } else {
+        return 0.0f; // unknown, don't cache before load
+    }
+    
+    if (ascii) {
+        if (_ascii_advances.empty()) return result; // not loaded
+        std::atomic_ref<float>(_ascii_advances[codepoint]).store(result, std::memory_order_relaxed);
+    } else {
+        _advances[codepoint] = result;
+    }
+    return result;
+}
+
+int font::load_kerning(uint32_t left, uint32_t right) {
+    const bool ascii = (left | right) < 128;
+    const uint64_t pair = (static_cast<uint64_t>(left) << 32) | right;
+    std::lock_guard<std::mutex> layout(_layout_mutex);
+    if (!ascii) {
+        if (auto it = _kerning.find(pair); it != _kerning.end()) return it->second;
+    } else if (!_ascii_kerning.empty() && _ascii_kerning[left * 128 + right] != UNKNOWN_METRIC) {
+        return _ascii_kerning[left * 128 + right]; // filled while we waited
+    }
+    
+    // after unload the face is gone; reopening goes through the cache and
+    // reuses the shared mapping or memory copy
+    std::unique_ptr<face_size> temp;
+    const face_size* sized = _face_size.get();
+    if (!sized) {
+        auto& cache = face_cache::instance();
+        auto face = _from_memory ? cache.open(_memory_file) : cache.open(_path);
+        if (!face) return 0;
+        temp = std::make_unique<face_size>(face, _size);
+        if (!temp->valid()) return 0;
+        sized = temp.get();
+    }
+    int result = 0;
+    {
+        auto lock = sized->lock();
+        FT_Face face = sized->activate();
+        FT_UInt l = FT_Get_Char_Index(face, left);
+        FT_UInt r = FT_Get_Char_Index(face, right);
+        FT_Vector kerning;
+        kerning.x = kerning.y = 0;
+        if (FT_Get_Kerning(face, l, r, FT_KERNING_DEFAULT, &kerning) == 0) {
+            result = kerning.x >> 6;
+        }
+    }
+    
+    if (ascii) {
+        if (_ascii_kerning.empty()) return result; // not loaded
+        std::atomic_ref<int16_t>(_ascii_kerning[left * 128 + right]).store(static_cast<int16_t>(result), std::memory_order_relaxed);
     } else {
-        FT_New_Face(_ft_library, _path.c_str(), 0, &_ft_face);
+        _kerning[pair] = result;
     }
-    FT_Set_Pixel_Sizes(_ft_face, 0, static_cast<FT_UInt>(_size));
-    FT_UInt l = FT_Get_Char_Index(_ft_face, left);
-    FT_UInt r = FT_Get_Char_Index(_ft_face, right);
-    FT_Vector kerning;
-    kerning.x = kerning.y = 0;
-    if (FT_Get_Kerning(_ft_face, l, r, FT_KERNING_DEFAULT, &kerning) == 0) {
-        FT_Done_Face(_ft_face);
-        FT_Done_FreeType(_ft_library);
-        return kerning.x >> 6;
+    return result;
+}
+
+const int16_t* font::ascii_kerning() {
+    std::lock_guard<std::mutex> layout(_layout_mutex);
+    if (_ascii_kerning_state == table_state::partial) {
+        _ascii_kerning_state = table_state::empty;
+        if (_has_kerning && _face_size && !_ascii_kerning.empty()) {
+            // in place: get_kerning may be reading entries on other threads
+            for (auto& entry : _ascii_kerning) std::atomic_ref<int16_t>(entry).store(0, std::memory_order_relaxed);
+            auto lock = _face_size->lock();
+            FT_Face face = _face_size->activate();
+            FT_UInt index[128] = {};
+            for (uint32_t c = 32; c < 127; ++c) index[c] = FT_Get_Char_Index(face, c);
+            for (uint32_t l = 32; l < 127; ++l) {
+                for (uint32_t r = 32; r < 127; ++r) {
+                    FT_Vector kerning{};
+                    if (!index[l] || !index[r] || FT_Get_Kerning(face, index[l], index[r], FT_KERNING_DEFAULT, &kerning) != 0) continue;
+                    std::atomic_ref<int16_t>(_ascii_kerning[l * 128 + r]).store(static_cast<int16_t>(kerning.x >> 6), std::memory_order_relaxed);
+                    if (kerning.x >> 6) _ascii_kerning_state = table_state::full;
+                }
+            }
+        }
+    }
+    return _ascii_kerning_state == table_state::full ? _ascii_kerning.data() : nullptr;
+}
+
+void font::clear_layout_caches() {
+    // sized once here so lookups on other threads never see a reallocation;
+    // unloaded fonts keep them empty and cache nothing
+    std::lock_guard<std::mutex> layout(_layout_mutex);
+    _advances.clear();
+    _kerning.clear();
+    _ascii_kerning_state = table_state::partial;
+    if (_face_size) {
+        _ascii_advances.assign(128, -1.0f);
+        _ascii_kerning.assign(128 * 128, UNKNOWN_METRIC);
+    } else {
+        _ascii_advances.clear();
+        _ascii_kerning.clear();
     }
-    FT_Done_Face(_ft_face);
-    FT_Done_FreeType(_ft_library);
-    return 0;
 }
 
 void font::add_fallback(std::shared_ptr<font> fallback) {
     if (fallback && fallback.get() != this) {
         _fallbacks.push_back(fallback);
+        std::unique_lock<std::shared_mutex> lock(_fallback_mutex);
+        _fallback_cache.clear();
     }
 }
 
-std::shared_ptr<font> font::get_fallback_for_codepoint(uint32_t codepoint) const {
-    // first check if we have the glyph
-    if (has_glyph(codepoint)) {
-        return nullptr; // no fallback needed
-    }
-    // cache lookup
-    if (auto it = _fallback_cache.find(codepoint); it != _fallback_cache.end()) {
-        if (auto cached = it->second.lock()) {
-            return cached;
+std::shared_ptr<font> font::resolve_fallback(uint32_t codepoint) const {
+    const int default_slot = static_cast<int>(_fallbacks.size());
+    auto at = [&](int slot) -> std::shared_ptr<font> {
+        if (slot < 0) return nullptr;
+        return slot == default_slot ? _default_fallback : _fallbacks[slot];
+    };
+    {
+        std::shared_lock<std::shared_mutex> lock(_fallback_mutex);
+        if (auto it = _fallback_cache.find(codepoint); it != _fallback_cache.end()) {
+            return at(it->second);
         }
     }
     
-    // check fallback fonts in order
-    for (const auto& fallback : _fallbacks) {
-        if (fallback && fallback->has_glyph(codepoint)) {
-            _fallback_cache[codepoint] = fallback;
-            return fallback;
+    // a fallback that is not loaded yet has no coverage; don't remember a
+    // miss that could turn into a hit once it is
+    bool cacheable = true;
+    int found = -1;
+    for (int slot = 0; slot <= default_slot && found < 0; ++slot) {
+        auto candidate = at(slot);
+        if (!candidate) continue;
+        if (candidate->covers(codepoint)) {
+            found = slot;
+        } else if (candidate->coverage().empty()) {
+            cacheable = false;
         }
     }
-    
-    // check default fallback
-    if (_default_fallback && _default_fallback->has_glyph(codepoint)) {
-        _fallback_cache[codepoint] = _default_fallback;
-        return _default_fallback;
+    if (cacheable || found >= 0) {
+        std::unique_lock<std::shared_mutex> lock(_fallback_mutex);
+        _fallback_cache[codepoint] = found;
     }
-    
-    return nullptr;
+    return at(found);
 }
 
-bool font::has_glyph_in_fallbacks(uint32_t codepoint) const {
-    // check fallback fonts
-    for (const auto& fallback : _fallbacks) {
-        if (fallback && fallback->has_glyph(codepoint)) {
-            return true;
-        }
-    }
-    
-    // check default fallback
-    if (_default_fallback && _default_fallback->has_glyph(codepoint)) {
-        return true;
+std::shared_ptr<font> font::get_fallback_for_codepoint(uint32_t codepoint) const {
+    // no fallback needed when this face has it
+    if (has_glyph(codepoint) || covers(codepoint)) {
+        return nullptr;
     }
-    
-    return false;
+    return resolve_fallback(codepoint);
+}
+
+bool font::has_glyph_in_fallbacks(uint32_t codepoint) const {
+    return resolve_fallback(codepoint) != nullptr;
 }
 
 void font::set_default_fallback(std::shared_ptr<font> fallback) {
     if (fallback && fallback.get() != this) {
         _default_fallback = fallback;
+        std::unique_lock<std::shared_mutex> lock(_fallback_mutex);
+        _fallback_cache.clear();
     }
 }
 
 bool font::has_glyph(uint32_t codepoint) const {
-    return _glyphs.find(codepoint) != _glyphs.end();
+    std::shared_lock<std::shared_mutex> lock(_glyph_mutex);
+    return find_glyph(codepoint) != nullptr;
+}
+
+bool font::has_pending_glyphs() const {
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    return !_pending.empty();
 }
 
 bool font::request_glyph(uint32_t codepoint) {
@@ -447,116 +909,127 @@ bool font::request_glyph(uint32_t codepoint) {
 bool font::ensure_glyph(uint32_t codepoint) {
     if (has_glyph(codepoint)) return true;
     
-    if (!_ft_face) {
+    if (!_face_size) {
         utils::log_error("Font not loaded");
         return false;
     }
+    if (!covers(codepoint)) return false;
     
-    // ensure this face actually contains the character; skip .notdef (index 0)
-    FT_UInt glyph_index = FT_Get_Char_Index(_ft_face, codepoint);
-    if (glyph_index == 0) {
-        return false;
-    }
+    glyph_bitmap bitmap;
+    if (!rasterize(*_face_size, codepoint, raster_mode(), bitmap)) return false;
+    
+    // pack into the current page (new page when full); the rectangle is
+    // recorded as dirty and uploaded on the next flush_atlas. another thread
+    // may have packed it while this one rasterized
+    std::unique_lock<std::shared_mutex> lock(_glyph_mutex);
+    return find_glyph(codepoint) || pack_bitmap(bitmap, true);
+}
 
-    // load the glyph
-    if (FT_Load_Char(_ft_face, codepoint, FT_LOAD_RENDER)) {
-        utils::log_warn("Failed to load glyph U+%04X", codepoint);
-        return false;
+glyph_status font::ensure_glyph_async(uint32_t codepoint) {
+    if (has_glyph(codepoint)) return glyph_status::ready;
+    if (!_async_glyphs) return ensure_glyph(codepoint) ? glyph_status::ready : glyph_status::missing;
+    // coverage answers without the face lock, so callers move on to a
+    // fallback font right away instead of waiting for a worker
+    if (!_face_size || !covers(codepoint)) return glyph_status::missing;
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    if (_pending.count(codepoint)) return glyph_status::pending;
+    if (_missing.count(codepoint)) return glyph_status::missing;
+    queue_glyph(codepoint);
+    return glyph_status::pending;
+}
+
+void font::set_subpixel_positions(int phases) {
+    _subpixel_positions = std::clamp(phases, 1, MAX_SUBPIXEL_POSITIONS);
+}
+
+const glyph_info* font::subpixel_glyph(uint32_t codepoint, int phase) {
+    const uint32_t key = glyph_key(codepoint, phase);
+    if (const auto* glyph = use_glyph(key)) return glyph;
+    if (!_face_size) return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        if (_pending.count(key) || _missing.count(key)) return nullptr;
+        if (_async_glyphs) {
+            queue_glyph(key);
+            return nullptr;
+        }
     }
-    
-    FT_GlyphSlot g = _ft_face->glyph;
-    
-    // check if we need a new page
-    if (_current_x + g->bitmap.width >= _atlas_page_widths[_current_page]) {
-        _current_x = 0;
-        _current_y += _current_row_height;
-        _current_row_height = 0;
+    glyph_bitmap bitmap;
+    bool packed = rasterize(*_face_size, codepoint, raster_mode(), bitmap, phase);
+    if (packed) {
+        std::unique_lock<std::shared_mutex> lock(_glyph_mutex);
+        packed = find_glyph(key) || pack_bitmap(bitmap, true);
     }
-    
-    if (_current_y + g->bitmap.rows >= _atlas_page_heights[_current_page]) {
-        // create new page
-        _current_page++;
-        _current_x = 0;
-        _current_y = 0;
-        _current_row_height = 0;
-        
-        _atlas_pages.push_back(std::vector<unsigned char>(ATLAS_W * ATLAS_H * 4, 0));
-        _atlas_page_widths.push_back(ATLAS_W);
-        _atlas_page_heights.push_back(ATLAS_H);
-        
+    if (!packed) {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        _missing.insert(key);
+        return nullptr;
     }
-    
-    // copy glyph data to atlas
-    auto& current_page = _atlas_pages[_current_page];
-    int page_width = _atlas_page_widths[_current_page];
-    int page_height = _atlas_page_heights[_current_page];
-    
-    if (g->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY) {
-        // 8-bit per pixel
-        for (int j = 0; j < g->bitmap.rows; ++j) {
-            for (int i = 0; i < g->bitmap.width; ++i) {
-                int atlas_idx = 4 * ((_current_x + i) + (_current_y + j) * page_width);
-                unsigned char mask = g->bitmap.buffer[j * g->bitmap.pitch + i];
-                current_page[atlas_idx + 0] = 255; // R
-                current_page[atlas_idx + 1] = 255; // G
-                current_page[atlas_idx + 2] = 255; // B
-                current_page[atlas_idx + 3] = mask; // A
-            }
-        }
-    } else if (g->bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
-        // 1-bit per pixel, each byte is 8 pixels
-        for (int j = 0; j < g->bitmap.rows; ++j) {
-            for (int i = 0; i < g->bitmap.width; ++i) {
-                int atlas_idx = 4 * ((_current_x + i) + (_current_y + j) * page_width);
-                int byte = g->bitmap.buffer[j * g->bitmap.pitch + (i >> 3)];
-                int bit = 7 - (i & 7);
-                unsigned char mask = (byte & (1 << bit)) ? 255 : 0;
-                current_page[atlas_idx + 0] = 255; // R
-                current_page[atlas_idx + 1] = 255; // G
-                current_page[atlas_idx + 2] = 255; // B
-                current_page[atlas_idx + 3] = mask; // A
-            }
+    return use_glyph(key);
+}
+
+void font::prefetch(const std::vector<uint32_t>& codepoints) {
+    if (!_face_size) return;
+    std::shared_lock<std::shared_mutex> glyphs(_glyph_mutex);
+    std::lock_guard<std::mutex> queue(_queue_mutex);
+    for (uint32_t c : codepoints) {
+        if (!covers(c) || find_glyph(c) || _pending.count(c) || _missing.count(c)) continue;
+        queue_glyph(c);
+    }
+}
+
+void font::queue_glyph(uint32_t key) {
+    _pending.insert(key);
+    // the job keeps the size (and through it the face) alive, so unload or
+    // destruction of the font never races a running rasterization
+    utils::thread_pool::shared().submit([jobs = _jobs, size = _face_size, options = raster_mode(), key]() {
+        if (jobs->cancelled) return;
+        glyph_bitmap bitmap;
+        bool found = rasterize(*size, key & 0xFFFFFF, options, bitmap, static_cast<int>(key >> 24));
+        std::lock_guard<std::mutex> lock(jobs->mutex);
+        if (found) {
+            jobs->done.push_back(std::move(bitmap));
+        } else {
+            jobs->missing.push_back(key);
         }
-    } else {
-        utils::log_warn("Unsupported pixel mode %d for glyph U+%04X", g->bitmap.pixel_mode, codepoint);
-        return false;
+    });
+}
+
+size_t font::pack_ready_glyphs() {
+    FV_PROFILE_SCOPE("font::pack_ready_glyphs");
+    std::vector<glyph_bitmap> done;
+    std::vector<uint32_t> missing;
+    {
+        std::lock_guard<std::mutex> lock(_jobs->mutex);
+        if (_jobs->done.empty() && _jobs->missing.empty()) return 0;
+        done.swap(_jobs->done);
+        missing.swap(_jobs->missing);
     }
     
-    // create glyph info
-    glyph_info info;
-    info.u0 = float(_current_x) / page_width;
-    info.v0 = float(_current_y) / page_height;
-    info.u1 = float(_current_x + g->bitmap.width) / page_width;
-    info.v1 = float(_current_y + g->bitmap.rows) / page_height;
-    info.width = g->bitmap.width;
-    info.height = g->bitmap.rows;
-    info.advance = g->advance.x >> 6;
-    info.bearingX = g->bitmap_left;
-    info.bearingY = g->bitmap_top;  // keep the actual bearingY
-    info.codepoint = codepoint;
-    info.colored = _colored;
-    
-    // store page number in a different way - we'll use a separate field or encode it differently
-    // for now, let's not overwrite bearingY
-    
-    _glyphs[codepoint] = info;
-    
-    // update position
-    _current_x += g->bitmap.width + 1;
-    if (g->bitmap.rows > _current_row_height) {
-        _current_row_height = g->bitmap.rows;
+    // whichever thread took the batch packs it; readers of this font finish
+    // their current text call first
+    size_t packed = 0;
+    std::unique_lock<std::shared_mutex> glyphs(_glyph_mutex);
+    std::vector<uint32_t> failed;
+    for (const auto& bitmap : done) {
+        const uint32_t key = glyph_key(bitmap.codepoint, bitmap.phase);
+        // a blocking ensure_glyph may have packed it in the meantime
+        if (find_glyph(key)) continue;
+        if (pack_bitmap(bitmap, true)) {
+            ++packed;
+        } else {
+            failed.push_back(key);
+        }
     }
-    
-    // update the atlas bitmap with the new glyph data
-    _atlas_bitmap = _atlas_pages[_current_page];
-    
-    // update the D3D11 texture with the new atlas data
-#ifdef _WIN32
-    // we need to get the device from somewhere - for now, we'll update it later
-    // this is a temporary solution - ideally we'd pass the device to ensure_glyph
-#endif
-    
-    return true;
+    // only now: a glyph neither packed nor pending would be queued again
+    std::lock_guard<std::mutex> queue(_queue_mutex);
+    for (const auto& bitmap : done) _pending.erase(glyph_key(bitmap.codepoint, bitmap.phase));
+    for (uint32_t key : failed) _missing.insert(key);
+    for (uint32_t c : missing) {
+        _pending.erase(c);
+        _missing.insert(c);
+    }
+    return packed;
 }
 
 void font::set_opentype_features(const opentype_features& features) {
@@ -566,23 +1039,59 @@ void font::set_opentype_features(const opentype_features& features) {
 
 std::vector<std::shared_ptr<font>> font::load_all_from_folder(const std::string& folder, float size, bool sdf, bool mcsdf, resources::texture_dict* tex_dict) {
     std::vector<std::shared_ptr<font>> fonts;
+    for (auto& load : load_all_from_folder_async(folder, size, sdf, mcsdf, tex_dict)) {
+        if (load.ready.get()) fonts.push_back(std::move(load.handle));
+    }
+    return fonts;
+}
+
+std::vector<font_load> font::load_all_from_folder_async(const std::string& folder, float size, bool sdf, bool mcsdf, resources::texture_dict* tex_dict) {
     namespace fs = std::filesystem;
-    for (const auto& entry : fs::directory_iterator(folder)) {
-        if (!entry.is_regular_file()) continue;
-        auto ext = entry.path().extension().string();
+    struct entry {
+        fs::path path;
+        uintmax_t bytes;
+    };
+    std::vector<entry> files;
+    std::error_code ec;
+    for (const auto& item : fs::directory_iterator(folder, ec)) {
+        if (!item.is_regular_file()) continue;
+        auto ext = item.path().extension().string();
         std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-        if (ext == ".ttf" || ext == ".otf") {
-            auto f = std::make_shared<font>(entry.path().string().c_str(), size, sdf, mcsdf);
+        if (ext == ".ttf" || ext == ".otf") files.push_back({item.path(), item.file_size(ec)});
+    }
+    if (ec) utils::log_warn("font: listing '%s': %s", folder.c_str(), ec.message().c_str());
+    std::sort(files.begin(), files.end(), [](const entry& a, const entry& b) { return a.path < b.path; });
+
+    std::vector<font_load> loads(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        loads[i].handle = std::make_shared<font>(files[i].path.string().c_str(), size, sdf, mcsdf);
+    }
+
+    // every load runs on its own worker (preloads inline there); the biggest
+    // files go first so a large cjk face doesn't start last and set the tail
+    std::vector<size_t> order(files.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return files[a].bytes > files[b].bytes; });
+    auto& pool = utils::thread_pool::shared();
+    const bool inline_load = pool.in_worker();
+    for (size_t i : order) {
+        auto f = loads[i].handle;
+        auto job = [f, tex_dict]() {
 #ifdef _WIN32
-            if (f->load(nullptr, tex_dict)) fonts.push_back(f);
+            return f->load(nullptr, tex_dict);
 #else
-            if (f->load(tex_dict)) fonts.push_back(f);
+            return f->load(tex_dict);
 #endif
+        };
+        if (inline_load) {
+            std::promise<bool> done;
+            done.set_value(job());
+            loads[i].ready = done.get_future().share();
+        } else {
+            loads[i].ready = pool.async(std::move(job)).share();
         }
     }
-    return fonts;
+    return loads;
 }
 
-
-
 } // namespace resources 
\ No newline at end of file
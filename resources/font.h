@@ -1,12 +1,22 @@
 #pragma once
 
 #include "texture.h"
+#include "glyph_atlas.h"
+#include "codepoint_set.h"
+#include "distance_field.h"
+#include "face_cache.h"
 #include <string>
+#include <string_view>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <cstdint>
-#include <unordered_map>
+#include <climits>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <future>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
@@ -17,13 +27,38 @@
 
 namespace resources {
 
+struct atlas_cache_key;
+struct font_load;
+class glyph_reader;
+
 struct glyph_info {
     float u0, v0, u1, v1; // uv coordinates in atlas
     int width, height;    // glyph size in pixels
-    int advance;          // advance to next glyph
+    float advance;        // advance to next glyph, fractional for subpixel fonts
     int bearingX, bearingY; // offset from baseline
     uint32_t codepoint;     // unicode codepoint
-    bool colored = false;   // true if glyph is color (colr/cpal)
+    bool colored = false;   // true if glyph is color (colr/cpal), stored on an rgba page
+    int page = 0;           // atlas page holding the bitmap
+    int phase = 0;          // subpixel variant (see set_subpixel_positions), 0 for the whole-pixel glyph
+    uint32_t last_used = 0; // font frame it was last drawn in (see use_glyph), not cached on disk
+};
+
+// rasterized glyph waiting to be packed, pixels already in the page format
+struct glyph_bitmap {
+    uint32_t codepoint = 0;
+    int width = 0, height = 0;
+    int bearing_x = 0, bearing_y = 0;
+    float advance = 0.0f;
+    int phase = 0;
+    texture_format format = texture_format::r8;
+    bool colored = false;
+    std::vector<unsigned char> pixels;
+};
+
+enum class glyph_status {
+    ready,   // in the atlas
+    pending, // rasterizing on a worker, packed by a later pack_ready_glyphs
+    missing  // not in this face, try a fallback
 };
 
 struct font_metrics {
@@ -43,7 +78,7 @@ class font {
 public:
     font(const char* path, float size, bool sdf = false, bool mcsdf = false);
     font(const void* data, size_t size, float pixel_height, bool sdf = false, bool mcsdf = false);
-    virtual ~font() = default;
+    virtual ~font();
 
 #ifdef _WIN32
     virtual bool load(ID3D11Device* device = nullptr, resources::texture_dict* tex_dict = nullptr);
@@ -57,24 +92,58 @@ public:
 
     float size() const;
     const std::string& path() const { return _path; }
+    // unlocked view of the glyph table: only while no other thread packs
     const std::unordered_map<uint32_t, glyph_info>& glyphs() const { return _glyphs; }
-    const std::vector<unsigned char>& atlas_bitmap() const { return _atlas_bitmap; }
+    const std::vector<unsigned char>& atlas_bitmap() const;
     int atlas_width() const { return _atlas_width; }
     int atlas_height() const { return _atlas_height; }
     const font_metrics& metrics() const { return _metrics; }
-    bool is_sdf() const { return _sdf; }
-    bool is_mcsdf() const { return _mcsdf; }
+    bool is_sdf() const { return _sdf; } // atlas holds distance fields, scales to any size
+    bool is_mcsdf() const { return _mcsdf; } // rgb median field on rgba pages, keeps corners sharp when scaled up
+    bool is_distance_field() const { return _sdf || _mcsdf; }
     bool is_colored() const { return _colored; }
 
-    // kerning api
-    int get_kerning(uint32_t left, uint32_t right);
+    // quad scale for drawing at a pixel height; 1 for bitmap fonts or size 0
+    float draw_scale(float pixel_height) const {
+        return (pixel_height > 0.0f && is_distance_field() && _size > 0.0f) ? pixel_height / _size : 1.0f;
+    }
+
+    // pen advance in pixels without rasterizing; cached per codepoint. the
+    // ascii tables are sized at load and read lock free from any thread
+    float advance(uint32_t codepoint) {
+        if (codepoint < 128 && !_ascii_advances.empty()) {
+            const float cached = std::atomic_ref<float>(_ascii_advances[codepoint]).load(std::memory_order_relaxed);
+            if (cached >= 0.0f) return cached;
+        }
+        return load_advance(codepoint);
+    }
+
+    // kerning api, cached per pair
+    int get_kerning(uint32_t left, uint32_t right) {
+        if (!_has_kerning) return 0;
+        if ((left | right) < 128 && !_ascii_kerning.empty()) {
+            const int16_t cached = std::atomic_ref<int16_t>(_ascii_kerning[left * 128 + right]).load(std::memory_order_relaxed);
+            if (cached != UNKNOWN_METRIC) return cached;
+        }
+        return load_kerning(left, right);
+    }
+    // every ascii pair at once (left * 128 + right) for layout loops; built on
+    // first use, nullptr when the face has no kerning between them
+    const int16_t* ascii_kerning();
     bool has_kerning() const { return _has_kerning; }
 
+    // cmap coverage, built at load: true when the face has a glyph for codepoint
+    bool covers(uint32_t codepoint) const { return _coverage.contains(codepoint); }
+    const codepoint_set& coverage() const { return _coverage; }
+
     // fallback font chain
     void add_fallback(std::shared_ptr<font> fallback);
     const std::vector<std::shared_ptr<font>>& fallbacks() const { return _fallbacks; }
     
     // enhanced fallback system
+    // first fallback (declared order, then the default) covering codepoint, by
+    // coverage bit tests; results are cached per chain. nullptr when none does
+    std::shared_ptr<font> resolve_fallback(uint32_t codepoint) const;
     std::shared_ptr<font> get_fallback_for_codepoint(uint32_t codepoint) const;
     bool has_glyph_in_fallbacks(uint32_t codepoint) const;
     void set_default_fallback(std::shared_ptr<font> fallback);
@@ -83,33 +152,104 @@ public:
     // dynamic glyph paging
     bool has_glyph(uint32_t codepoint) const;
     bool request_glyph(uint32_t codepoint); // loads and packs glyph on demand
-    bool ensure_glyph(uint32_t codepoint); // ensures glyph is available, loads if needed
+    bool ensure_glyph(uint32_t codepoint); // ensures glyph is available, loads if needed (blocking)
+
+    // background rasterization: queue work on the shared thread pool and pack
+    // the finished bitmaps with pack_ready_glyphs, from any thread
+    glyph_status ensure_glyph_async(uint32_t codepoint);
+    void prefetch(const std::vector<uint32_t>& codepoints);
+    size_t pack_ready_glyphs(); // returns glyphs packed
+    bool has_pending_glyphs() const;
+    void set_async_glyphs(bool enabled) { _async_glyphs = enabled; } // off: ensure_glyph_async blocks
+
+    // subpixel positioning for coverage fonts: glyphs get up to `phases`
+    // horizontal variants (outline shifted by phase / phases px), rasterized
+    // lazily and picked from the fractional pen position. hinting becomes
+    // vertical only and advances fractional. 1 (default) is off; set before load()
+    static constexpr int MAX_SUBPIXEL_POSITIONS = 4;
+    void set_subpixel_positions(int phases);
+    int subpixel_positions() const { return is_distance_field() ? 1 : _subpixel_positions; }
+    static uint32_t glyph_key(uint32_t codepoint, int phase) { return codepoint | (static_cast<uint32_t>(phase) << 24); }
+    // the variant when packed; otherwise queues it (or rasterizes it when async
+    // glyphs are off) and returns nullptr, callers draw the whole-pixel glyph
+    const glyph_info* subpixel_glyph(uint32_t codepoint, int phase);
+
+    // glyphs rasterized by load(); the rest are paged in on first use.
+    // defaults to printable ascii, set before load()
+    void set_preload(std::vector<uint32_t> codepoints);
+    void add_preload_text(std::string_view utf8); // e.g. ui strings known at startup
+    const std::vector<uint32_t>& preload() const { return _preload; }
 
     // opentype features
     void set_opentype_features(const opentype_features& features);
     const opentype_features& get_opentype_features() const { return _ot_features; }
 
-    // static: load all fonts from resources/fonts
+    // static: load all fonts (.ttf/.otf, by file name) from a folder; blocks
+    // until every load finished and returns the fonts that loaded
     static std::vector<std::shared_ptr<font>> load_all_from_folder(const std::string& folder, float size, bool sdf = false, bool mcsdf = false, resources::texture_dict* tex_dict = nullptr);
+    // same, but each font loads (face, coverage, metrics, preload set) on the
+    // shared pool and is returned right away with a future for its load();
+    // don't touch a font before its future is ready. called from a pool
+    // worker, the fonts load inline and come back ready
+    static std::vector<font_load> load_all_from_folder_async(const std::string& folder, float size, bool sdf = false, bool mcsdf = false, resources::texture_dict* tex_dict = nullptr);
 
-    resources::tex get_atlas_tex() const { return _atlas_tex; }
+    resources::tex get_atlas_tex(int page = 0) const;
     int get_glyph_page(uint32_t codepoint) const; // get which page a glyph is on
+    int page_count() const { return static_cast<int>(_atlas->pages().size()); }
+
+    // atlas the glyphs are packed on: private to the font unless set before
+    // load(), e.g. to glyph_atlas::shared(). fonts on one atlas batch their
+    // text into one command and share its budget; they skip the disk cache
+    void set_atlas(std::shared_ptr<glyph_atlas> atlas);
+    const std::shared_ptr<glyph_atlas>& atlas() const { return _atlas; }
+
+    // disk cache of the atlas (see atlas_cache); load() restores it when the
+    // key matches and writes it after a cold load. call again to persist glyphs
+    // added since, e.g. on shutdown
+    bool save_atlas_cache() const;
+
+    // atlas uploads: only rectangles packed since the last flush are sent.
+    // flush_atlas also ends the font's frame, see use_glyph
+    bool atlas_dirty() const;
+    size_t flush_atlas();
+
+    // atlas budget: once the pages hold `bytes`, new glyphs take the space of
+    // the least recently drawn ones instead of adding a page; only glyphs not
+    // drawn since the last flush are evicted. 0 (default) lets the atlas grow.
+    // set on the atlas, so shared atlases have one budget for all their fonts
+    void set_atlas_budget(size_t bytes) { _atlas->set_budget(bytes); }
+    size_t atlas_budget() const { return _atlas->budget(); }
+    size_t atlas_bytes() const { return _atlas->bytes(); }
+    size_t evicted_glyphs() const { return _atlas->evicted_count(); }
+    // the glyph under key (glyph_key) for drawing, stamped with the current
+    // frame. the pointer is only safe while no other thread packs glyphs into
+    // this font; recording threads go through a glyph_reader
+    const glyph_info* use_glyph(uint32_t key);
+    // geometry recorded during frame f samples valid atlas space while
+    // atlas_valid_since(f): no glyph drawn in or after f has been evicted
+    uint32_t frame() const { return _atlas->frame(); }
+    bool atlas_valid_since(uint32_t frame) const { return _atlas->valid_since(frame); }
+    bool atlas_valid_since(uint32_t frame, int page) const { return _atlas->valid_since(frame, page); }
 
 #ifdef _WIN32
-    ID3D11ShaderResourceView* get_atlas_srv() const { return _atlas_srv.Get(); }
-    void update_atlas_texture(ID3D11Device* device = nullptr);
+    ID3D11ShaderResourceView* get_atlas_srv(int page = 0) const;
 #endif
 
 protected:
-    resources::tex _atlas_tex;
+    friend class glyph_reader;
+    // thread safety: glyph lookups take _glyph_mutex shared, packing and
+    // eviction take it exclusive and then the atlas mutex. structural changes
+    // to _glyphs happen under both, so eviction may read other fonts' tables
+    // holding only the atlas mutex. last_used is stamped by readers through
+    // atomic_ref
     std::unordered_map<uint32_t, glyph_info> _glyphs;
+    mutable std::shared_mutex _glyph_mutex;
     std::string _path;
     float _size;
-    std::vector<unsigned char> _atlas_bitmap;
     int _atlas_width = 0, _atlas_height = 0;
     font_metrics _metrics;
-    // for memory font
-    std::vector<unsigned char> _font_data;
+    // for memory font: one shared copy per buffer, see face_cache::share_memory
+    std::shared_ptr<font_file> _memory_file;
     bool _from_memory = false;
     // kerning
     bool _has_kerning = false;
@@ -125,23 +265,100 @@ protected:
     // default fallback
     std::shared_ptr<font> _default_fallback;
     // paging
-    std::vector<uint32_t> _pending_glyphs;
-    std::vector<std::vector<unsigned char>> _atlas_pages; // multiple atlas pages
-    std::vector<int> _atlas_page_widths;
-    std::vector<int> _atlas_page_heights;
-    int _current_page = 0;
-    int _current_x = 0;
-    int _current_y = 0;
-    int _current_row_height = 0;
-    // cache: codepoint -> font to speed up repeated fallback lookups
-    mutable std::unordered_map<uint32_t, std::weak_ptr<font>> _fallback_cache;
-    FT_Library _ft_library = nullptr;
+    struct glyph_jobs {
+        std::mutex mutex;
+        std::vector<glyph_bitmap> done;
+        std::vector<uint32_t> missing;
+        std::atomic<bool> cancelled{false};
+    };
+    std::shared_ptr<glyph_jobs> _jobs = std::make_shared<glyph_jobs>();
+    mutable std::mutex _queue_mutex; // _pending and _missing, taken after _glyph_mutex
+    std::unordered_set<uint32_t> _pending;  // queued on the pool
+    std::unordered_set<uint32_t> _missing;  // known absent from this face
+    bool _async_glyphs = true;
+    int _subpixel_positions = 1;
+    std::vector<uint32_t> _preload;
+    // r8 coverage pages, plus rgba pages for color glyphs and msdf fonts
+    std::shared_ptr<glyph_atlas> _atlas = std::make_shared<glyph_atlas>();
+    bool _shared_atlas = false;
+    bool _loading = false; // in load(), guarded by the atlas mutex: not evicted by other fonts
+    // cache: codepoint -> chain position (index into _fallbacks, _fallbacks.size()
+    // for the default, -1 for none); cleared when the chain changes
+    mutable std::unordered_map<uint32_t, int> _fallback_cache;
+    mutable std::shared_mutex _fallback_mutex;
+    codepoint_set _coverage;
+    // layout caches: ascii in flat tables, everything else hashed. misses
+    // fill them under _layout_mutex; the flat tables never reallocate after
+    // load, so their entries are read and written through atomic_ref
+    static constexpr int16_t UNKNOWN_METRIC = INT16_MIN;
+    std::mutex _layout_mutex;
+    std::vector<float> _ascii_advances; // negative until loaded
+    std::unordered_map<uint32_t, float> _advances;
+    std::vector<int16_t> _ascii_kerning; // 128 x 128, left major
+    enum class table_state : uint8_t { partial, full, empty };
+    table_state _ascii_kerning_state = table_state::partial;
+    std::unordered_map<uint64_t, int> _kerning;
+    void clear_layout_caches();
+    float load_advance(uint32_t codepoint);
+    int load_kerning(uint32_t left, uint32_t right);
+    // face shared with every other size of the same file; _ft_face is valid
+    // after _face_size->activate()
+    std::shared_ptr<shared_face> _face;
+    std::shared_ptr<face_size> _face_size;
     FT_Face _ft_face = nullptr;
-#ifdef _WIN32
-    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> _atlas_srv;
-#endif
+
+    void detach_atlas(); // gives this font's space back to the atlas
+    const glyph_info* find_glyph(uint32_t key) const; // caller holds _glyph_mutex
+    struct raster_options {
+        bool sdf = false;
+        bool msdf = false;
+        bool colored = false;
+        int subpixel = 1;
+    };
+    raster_options raster_mode() const { return {_sdf, _mcsdf, _colored, subpixel_positions()}; }
+    void check_mcsdf();
+    bool open_face();
+    bool load_face(resources::texture_dict* tex_dict);
+    void build_coverage();
+    size_t preload_glyphs(); // returns glyphs packed
+    void close_face();
+    // thread safe: only touches the face under its lock and the output
+    static bool rasterize(const face_size& size, uint32_t codepoint, const raster_options& options, glyph_bitmap& out, int phase = 0);
+    bool pack_bitmap(const glyph_bitmap& bitmap, bool allow_new_page); // caller holds _glyph_mutex exclusive
+    int make_room(texture_format format, int w, int h, atlas_rect& out); // page packed on, -1 if none
+    void evict_glyph(const glyph_info& glyph, bool release);
+    atlas_rect glyph_rect(const glyph_info& glyph) const;
+    void queue_glyph(uint32_t key); // glyph_key(codepoint, phase), caller holds _queue_mutex
+    atlas_cache_key atlas_key() const;
+    bool restore_atlas_cache();
 };
 
 using font_ptr = std::shared_ptr<font>;
 
+// read access to the glyph tables of the fonts one thread is drawing with:
+// each font's table is locked shared on first use and stays locked until
+// unlock(), so recording threads pay for the lock once per font and text
+// call, not per glyph. a miss must unlock() before ensure_glyph and the other
+// calls that pack, which lock the table exclusive. not shared between threads
+class glyph_reader {
+public:
+    glyph_reader() = default;
+    glyph_reader(const glyph_reader&) = delete;
+    glyph_reader& operator=(const glyph_reader&) = delete;
+
+    // the glyph under key, stamped like font::use_glyph; nullptr when not
+    // packed. valid until unlock() or use() of a font not locked yet
+    const glyph_info* use(font& f, uint32_t key);
+    void unlock() { _held.clear(); }
+
+private:
+    std::vector<std::pair<const font*, std::shared_lock<std::shared_mutex>>> _held;
+};
+
+// a font loading in the background, see load_all_from_folder_async
+struct font_load {
+    font_ptr handle;
+    std::shared_future<bool> ready; // load() result
+};
+
 } // namespace resources 
\ No newline at end of file
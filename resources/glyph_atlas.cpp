@@ -0,0 +1,273 @@
+#include "glyph_atlas.h"
+#include "resource_counters.h"
+#include "../utils/logger.h"
+#include "../utils/profiler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace resources {
+
+atlas_page::atlas_page(int width, int height, texture_format format)
+    : _pixels(static_cast<size_t>(width) * height * bytes_per_texel(format), 0), _format(format),
+      _bpp(static_cast<int>(bytes_per_texel(format))), _width(width), _height(height) {}
+
+bool atlas_page::pack(int w, int h, atlas_rect& out) {
+    if (w >= _width || h >= _height) return false;
+
+    // best fit among freed rectangles; the rest of the one taken is split
+    // into the strip to its right and the strip below
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(_free.size()); ++i) {
+        const auto& f = _free[i];
+        if (f.w < w + 1 || f.h < h + 1) continue;
+        if (best < 0 || f.w * f.h < _free[best].w * _free[best].h) best = i;
+    }
+    if (best >= 0) {
+        const atlas_rect f = _free[best];
+        _free[best] = _free.back();
+        _free.pop_back();
+        out = {f.x, f.y, w, h};
+        if (f.w - w - 1 >= 2) _free.push_back({f.x + w + 1, f.y, f.w - w - 1, f.h});
+        if (f.h - h - 1 >= 2) _free.push_back({f.x, f.y + h + 1, w + 1, f.h - h - 1});
+        return true;
+    }
+
+    // start a new shelf when the glyph doesn't fit on the current one
+    if (_cursor_x + w >= _width) {
+        _shelves.push_back({_cursor_y, _row_height});
+        _cursor_x = 0;
+        _cursor_y += _row_height;
+        _row_height = 0;
+    }
+    if (_cursor_y + h >= _height) return false;
+
+    out = {_cursor_x, _cursor_y, w, h};
+    _cursor_x += w + 1;
+    _row_height = std::max(_row_height, h + 1);
+    return true;
+}
+
+void atlas_page::write(const atlas_rect& rect, const unsigned char* src, int src_pitch) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    ++_generation;
+    for (int j = 0; j < rect.h; ++j) {
+        std::memcpy(row(rect.y + j) + rect.x * _bpp, src + j * src_pitch, rect.w * _bpp);
+    }
+    mark_dirty(rect);
+}
+
+void atlas_page::release(const atlas_rect& rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    ++_generation;
+    // the gutter goes with the glyph, except at the page edge
+    atlas_rect r = {rect.x, rect.y, std::min(rect.w + 1, _width - rect.x), std::min(rect.h + 1, _height - rect.y)};
+    for (int j = 0; j < r.h; ++j) {
+        std::memset(row(r.y + j) + r.x * _bpp, 0, static_cast<size_t>(r.w) * _bpp);
+    }
+    // the texture still has the old ink, which would bleed into the gutter of
+    // the next glyph packed here
+    mark_dirty(r);
+    _free.push_back(r);
+}
+
+void atlas_page::reclaim(std::vector<atlas_rect> live) {
+    if (!_shelves_known) return;
+    std::sort(live.begin(), live.end(), [](const atlas_rect& a, const atlas_rect& b) { return a.x < b.x; });
+
+    // every glyph lies within one shelf: the gaps between the glyphs left on
+    // a shelf become free rectangles of the full shelf height
+    _free.clear();
+    const int open = static_cast<int>(_shelves.size());
+    int last_nonempty = -1;
+    int open_end = 0;
+    for (int s = 0; s <= open; ++s) {
+        const int y = s < open ? _shelves[s].y : _cursor_y;
+        const int h = s < open ? _shelves[s].h : _row_height;
+        int x = 0;
+        for (const auto& r : live) {
+            if (r.y < y || r.y >= y + h) continue;
+            if (r.x > x) _free.push_back({x, y, r.x - x, h});
+            x = std::max(x, r.x + r.w + 1);
+        }
+        if (x > 0) last_nonempty = s;
+        if (s < open && x < _width) _free.push_back({x, y, _width - x, h});
+        if (s == open) open_end = x;
+    }
+
+    // shelves left empty at the bottom go back to the cursor
+    if (last_nonempty == open) {
+        _cursor_x = open_end;
+    } else {
+        _cursor_y = last_nonempty >= 0 ? _shelves[last_nonempty].y + _shelves[last_nonempty].h : 0;
+        _cursor_x = _row_height = 0;
+        _shelves.resize(last_nonempty + 1);
+        std::erase_if(_free, [&](const atlas_rect& f) { return f.y >= _cursor_y; });
+    }
+    std::erase_if(_free, [](const atlas_rect& f) { return f.w < 2 || f.h < 2; });
+}
+
+void atlas_page::reset() {
+    std::fill(_pixels.begin(), _pixels.end(), 0);
+    _cursor_x = _cursor_y = _row_height = 0;
+    _shelves.clear();
+    _shelves_known = true;
+    _free.clear();
+    _dirty.clear();
+    mark_dirty({0, 0, _width, _height});
+}
+
+void atlas_page::restore(const unsigned char* pixels, const shelf_state& shelf) {
+    std::memcpy(_pixels.data(), pixels, _pixels.size());
+    _cursor_x = shelf.x;
+    _cursor_y = shelf.y;
+    _row_height = shelf.row_height;
+    _shelves.clear();
+    _shelves_known = false;
+    _free.clear();
+    _dirty.clear();
+    mark_dirty({0, 0, _width, _height});
+}
+
+size_t atlas_page::used_area() const {
+    // closed shelves span the page width; freed rectangles lie within them
+    size_t area = static_cast<size_t>(_cursor_y) * _width + static_cast<size_t>(_cursor_x) * _row_height;
+    for (const auto& f : _free) area -= std::min(area, static_cast<size_t>(f.w) * f.h);
+    return area;
+}
+
+void atlas_page::mark_dirty(const atlas_rect& rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    ++_generation;
+
+    // glyphs are packed left to right along a shelf, so consecutive writes
+    // usually extend the previous rectangle instead of adding a new one
+    if (!_dirty.empty()) {
+        auto& last = _dirty.back();
+        if (rect.y == last.y && rect.x >= last.x && rect.x <= last.x + last.w + 1) {
+            last.w = std::max(last.x + last.w, rect.x + rect.w) - last.x;
+            last.h = std::max(last.h, rect.h);
+            return;
+        }
+    }
+    _dirty.push_back(rect);
+}
+
+void atlas_page::attach(texture_dict* dict) {
+    if (!dict || _texture) return;
+    _texture = dict->create_texture(_width, _height, _format);
+    if (!_texture) {
+        utils::log_error("atlas_page: failed to create %dx%d atlas texture", _width, _height);
+    }
+}
+
+size_t atlas_page::flush(texture_dict* dict) {
+    FV_PROFILE_SCOPE("atlas_page::flush");
+    if (_dirty.empty() || !dict) return 0;
+    attach(dict);
+    if (!_texture) return 0;
+
+    size_t bytes = 0;
+    const uint32_t pitch = static_cast<uint32_t>(_width * _bpp);
+    for (const auto& r : _dirty) {
+        texture_region region;
+        region.x = static_cast<uint32_t>(r.x);
+        region.y = static_cast<uint32_t>(r.y);
+        region.width = static_cast<uint32_t>(r.w);
+        region.height = static_cast<uint32_t>(r.h);
+        if (dict->update_texture_region(_texture, region, row(r.y) + r.x * _bpp, pitch)) {
+            bytes += static_cast<size_t>(r.w) * r.h * _bpp;
+        }
+    }
+    _dirty.clear();
+    resource_counters::shared().atlas_upload_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    return bytes;
+}
+
+glyph_atlas::glyph_atlas(int page_width, int page_height) : _page_width(page_width), _page_height(page_height) {}
+
+std::shared_ptr<glyph_atlas> glyph_atlas::shared() {
+    static const std::shared_ptr<glyph_atlas> atlas = std::make_shared<glyph_atlas>();
+    return atlas;
+}
+
+int glyph_atlas::add_page(texture_format format) {
+    _pages.emplace_back(_page_width, _page_height, format);
+    _pages.back().attach(_dict);
+    return static_cast<int>(_pages.size()) - 1;
+}
+
+void glyph_atlas::clear() {
+    _pages.clear();
+    _current_r8 = _current_rgba = -1;
+}
+
+void glyph_atlas::attach(texture_dict* dict) {
+    if (!dict || _dict) return;
+    _dict = dict;
+    for (auto& page : _pages) page.attach(dict);
+}
+
+bool glyph_atlas::dirty() const {
+    for (const auto& page : _pages) {
+        if (page.dirty()) return true;
+    }
+    return false;
+}
+
+size_t glyph_atlas::flush() {
+    // everything drawn so far is submitted with this upload
+    ++_frame;
+    if (!_dict) return 0;
+    size_t bytes = 0;
+    for (auto& page : _pages) {
+        bytes += page.flush(_dict);
+    }
+    return bytes;
+}
+
+size_t glyph_atlas::bytes() const {
+    size_t bytes = 0;
+    for (const auto& page : _pages) bytes += page.pixels().size();
+    return bytes;
+}
+
+bool glyph_atlas::valid_since(uint32_t frame, int page) const {
+    if (page < 0) return valid_since(frame);
+    const auto& slot = _page_evicted[std::min(page, EVICTION_SLOTS - 1)];
+    return frame > _reset_frame.load(std::memory_order_acquire) && frame > slot.load(std::memory_order_acquire);
+}
+
+void glyph_atlas::note_evicted(uint32_t stamp, int page) {
+    // under the mutex, the only writer
+    if (stamp > _evicted_frame.load(std::memory_order_relaxed)) _evicted_frame.store(stamp, std::memory_order_release);
+    auto& slot = _page_evicted[std::min(page, EVICTION_SLOTS - 1)];
+    if (stamp > slot.load(std::memory_order_relaxed)) slot.store(stamp, std::memory_order_release);
+    _evicted_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void glyph_atlas::invalidate() {
+    const uint32_t frame = _frame++;
+    _reset_frame.store(frame, std::memory_order_release);
+    _evicted_frame.store(frame, std::memory_order_release);
+}
+
+void glyph_atlas::pin_page(int page) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (page >= static_cast<int>(_pins.size())) _pins.resize(page + 1, 0);
+    ++_pins[page];
+}
+
+void glyph_atlas::unpin_page(int page) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (page < static_cast<int>(_pins.size()) && _pins[page] > 0) --_pins[page];
+}
+
+void glyph_atlas::add_font(font* f) {
+    if (std::find(_fonts.begin(), _fonts.end(), f) == _fonts.end()) _fonts.push_back(f);
+}
+
+void glyph_atlas::remove_font(font* f) {
+    std::erase(_fonts, f);
+}
+
+} // namespace resources
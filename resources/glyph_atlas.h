@@ -0,0 +1,168 @@
+#pragma once
+#include "texture.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+namespace resources {
+
+struct atlas_rect {
+    int x = 0, y = 0;
+    int w = 0, h = 0;
+};
+
+// one page of a glyph atlas: cpu pixels, a shelf packer with a list of freed
+// rectangles, and the list of rectangles written since the last upload to the
+// backing texture
+class atlas_page {
+public:
+    atlas_page(int width, int height, texture_format format = texture_format::rgba8);
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+    texture_format format() const { return _format; }
+    int bytes_per_pixel() const { return _bpp; }
+    const std::vector<unsigned char>& pixels() const { return _pixels; }
+
+    // reserve space for a w x h glyph (1px gutter); freed rectangles are tried
+    // before the shelves. false when the page is full
+    bool pack(int w, int h, atlas_rect& out);
+    // give back a packed rectangle (evicted glyph): its pixels and gutter are
+    // cleared and it becomes available to pack
+    void release(const atlas_rect& rect);
+    // rebuild the free list from the rectangles of the glyphs still on the
+    // page, undoing the fragmentation of many releases; no-op on restored
+    // pages, whose shelf layout isn't known
+    void reclaim(std::vector<atlas_rect> live);
+    // forget every glyph: cleared pixels, empty packer, the whole page dirty
+    void reset();
+    size_t free_rect_count() const { return _free.size(); }
+    // texels taken by the packer: shelves so far, gutters and shelf slack
+    // included, less freed rectangles
+    size_t used_area() const;
+    // copy rows in the page format into an already packed rectangle and mark it dirty
+    void write(const atlas_rect& rect, const unsigned char* src, int src_pitch);
+    unsigned char* row(int y) { return _pixels.data() + static_cast<size_t>(y) * _width * _bpp; }
+
+    // shelf packer position, saved with cached atlases so packing can continue
+    struct shelf_state {
+        int x = 0, y = 0, row_height = 0;
+    };
+    shelf_state shelf() const { return {_cursor_x, _cursor_y, _row_height}; }
+    // replace pixels and packer state (disk cache restore); the whole page
+    // becomes dirty. freed rectangles are not saved
+    void restore(const unsigned char* pixels, const shelf_state& shelf);
+
+    // dirty tracking
+    void mark_dirty(const atlas_rect& rect);
+    bool dirty() const { return !_dirty.empty(); }
+    const std::vector<atlas_rect>& dirty_rects() const { return _dirty; }
+    // bumped whenever pixels change, so copies (e.g. frame captures) know
+    // when they are out of date without comparing pixels
+    uint64_t generation() const { return _generation; }
+
+    // backing texture; created through the dict on attach
+    void attach(texture_dict* dict);
+    const tex& texture() const { return _texture; }
+    // upload dirty rectangles only, returns bytes sent
+    size_t flush(texture_dict* dict);
+
+private:
+    std::vector<unsigned char> _pixels;
+    std::vector<atlas_rect> _dirty;
+    std::vector<atlas_rect> _free; // released space, gutter included
+    struct shelf_band {
+        int y, h;
+    };
+    std::vector<shelf_band> _shelves; // closed shelves, the open one is at _cursor_y
+    bool _shelves_known = true;
+    tex _texture;
+    texture_format _format = texture_format::rgba8;
+    int _bpp = 4;
+    int _width = 0, _height = 0;
+    int _cursor_x = 0, _cursor_y = 0;
+    int _row_height = 0;
+    uint64_t _generation = 0;
+};
+
+class font;
+
+// the pages glyphs are packed on. every font owns a private atlas unless it
+// is given a shared one (font::set_atlas), e.g. glyph_atlas::shared() for the
+// whole process: text switching between fonts of one atlas stays on one page
+// and draws as one command. frames and the eviction budget are per atlas
+class glyph_atlas {
+public:
+    static constexpr int PAGE_SIZE = 1024;
+    explicit glyph_atlas(int page_width = PAGE_SIZE, int page_height = PAGE_SIZE);
+
+    // process-wide atlas, created on first use
+    static std::shared_ptr<glyph_atlas> shared();
+
+    int page_width() const { return _page_width; }
+    int page_height() const { return _page_height; }
+    std::vector<atlas_page>& pages() { return _pages; }
+    const std::vector<atlas_page>& pages() const { return _pages; }
+    int add_page(texture_format format); // index of the new page, textured once a dict is attached
+    // page packing continues on for a format, -1 before the first
+    int& current_page(texture_format format) { return format == texture_format::r8 ? _current_r8 : _current_rgba; }
+    void clear(); // drops every page
+
+    // pages get their textures through the first dict attached
+    void attach(texture_dict* dict);
+    texture_dict* dict() const { return _dict; }
+    bool dirty() const;
+    // upload dirty rectangles of every page; ends the atlas frame
+    size_t flush();
+    size_t bytes() const;
+
+    // eviction (see font::set_atlas_budget): glyphs are stamped with the
+    // frame they were drawn in; evicted_frame is the newest stamp evicted.
+    // read without the mutex by recording threads
+    uint32_t frame() const { return _frame.load(std::memory_order_relaxed); }
+    bool valid_since(uint32_t frame) const { return frame > _evicted_frame.load(std::memory_order_acquire); }
+    // the same for the glyphs of one page: evictions from other pages don't
+    // count. pages past the last slot share it; -1 is any page
+    bool valid_since(uint32_t frame, int page) const;
+    void note_evicted(uint32_t stamp, int page);
+    void invalidate(); // everything recorded so far is stale
+    size_t evicted_count() const { return _evicted_count.load(std::memory_order_relaxed); }
+    void set_budget(size_t bytes) { _budget = bytes; }
+    size_t budget() const { return _budget; }
+
+    // pages static text is drawn from (see frame_builder): eviction passes
+    // over glyphs on a pinned page, so geometry sampling them stays valid.
+    // counted, one unpin per pin. pinned() is read under the mutex
+    void pin_page(int page);
+    void unpin_page(int page);
+    bool pinned(int page) const { return page < static_cast<int>(_pins.size()) && _pins[page] > 0; }
+
+    // fonts with glyphs on the pages; eviction picks among all of them
+    void add_font(font* f);
+    void remove_font(font* f);
+    const std::vector<font*>& fonts() const { return _fonts; }
+
+    // serializes packing when fonts sharing the atlas load on several threads
+    std::mutex& mutex() { return _mutex; }
+
+private:
+    std::vector<atlas_page> _pages;
+    std::vector<font*> _fonts;
+    std::mutex _mutex;
+    texture_dict* _dict = nullptr;
+    int _page_width, _page_height;
+    int _current_r8 = -1, _current_rgba = -1;
+    std::atomic<uint32_t> _frame{1};
+    std::atomic<uint32_t> _evicted_frame{0};
+    std::atomic<uint32_t> _reset_frame{0};
+    static constexpr int EVICTION_SLOTS = 16;
+    std::array<std::atomic<uint32_t>, EVICTION_SLOTS> _page_evicted{};
+    std::vector<int> _pins;
+    std::atomic<size_t> _evicted_count{0};
+    size_t _budget = 0;
+};
+
+} // namespace resources
@@ -0,0 +1,24 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace resources {
+
+// process-wide running totals of resource work, bumped from any thread with
+// relaxed adds and never reset. renderers take the difference between two
+// frames for core::render_stats
+struct resource_counters {
+    std::atomic<uint64_t> glyph_hits{0};           // lookups finding a packed glyph (use_glyph, glyph_reader)
+    std::atomic<uint64_t> glyph_misses{0};         // lookups that didn't
+    std::atomic<uint64_t> glyph_rasterizations{0}; // bitmaps made by freetype, on any thread
+    std::atomic<uint64_t> texture_upload_bytes{0}; // texels sent to textures, atlas pages included
+    std::atomic<uint64_t> atlas_upload_bytes{0};   // the part sent by atlas page flushes
+    std::atomic<uint64_t> textures_created{0};
+
+    static resource_counters& shared() {
+        static resource_counters counters;
+        return counters;
+    }
+};
+
+} // namespace resources
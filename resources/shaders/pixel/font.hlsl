@@ -0,0 +1,10 @@
+#include "../include/types.hlsli"
+
+// glyph coverage atlas (R8): alpha comes from the single channel, rgb from the vertex
+float4 main(VS_OUTPUT IN) : SV_TARGET
+{
+    float coverage = texture0.Sample(curtex, IN.texcoord0).r;
+    float4 col = IN.color0;
+    col.a *= coverage;
+    return col;
+}
@@ -0,0 +1,18 @@
+#include "../include/types.hlsli"
+
+float median(float r, float g, float b)
+{
+    return max(min(r, g), min(max(r, g), b));
+}
+
+// multi-channel distance field atlas (RGBA): the median of rgb is the distance,
+// 0.5 on the outline; corners stay sharp where a single channel would round them
+float4 main(VS_OUTPUT IN) : SV_TARGET
+{
+    float3 field = texture0.Sample(curtex, IN.texcoord0).rgb;
+    float dist = median(field.r, field.g, field.b);
+    float width = max(fwidth(dist), 1e-4);
+    float4 col = IN.color0;
+    col.a *= smoothstep(0.5 - width, 0.5 + width, dist);
+    return col;
+}
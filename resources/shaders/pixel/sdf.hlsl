@@ -0,0 +1,12 @@
+#include "../include/types.hlsli"
+
+// signed distance field atlas (R8): 0.5 is the outline, antialiased over one
+// screen pixel so the same glyph stays sharp at any scale
+float4 main(VS_OUTPUT IN) : SV_TARGET
+{
+    float dist = texture0.Sample(curtex, IN.texcoord0).r;
+    float width = max(fwidth(dist), 1e-4);
+    float4 col = IN.color0;
+    col.a *= smoothstep(0.5 - width, 0.5 + width, dist);
+    return col;
+}
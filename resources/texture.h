@@ -9,15 +9,33 @@
 
 namespace resources {
 
+enum class texture_format : uint8_t {
+    rgba8,  // 4 bytes per texel
+    r8      // single channel, e.g. glyph coverage
+};
+
+inline uint32_t bytes_per_texel(texture_format format) {
+    return format == texture_format::r8 ? 1u : 4u;
+}
+
+// sub-rectangle of a texture in texels
+struct texture_region {
+    uint32_t x = 0, y = 0;
+    uint32_t width = 0, height = 0;
+};
+
 class texture {
 public:
     virtual ~texture() = default;
     virtual uint32_t width() const = 0;
     virtual uint32_t height() const = 0;
+    virtual texture_format format() const = 0;
     virtual void bind(uint32_t slot = 0) = 0;
     virtual void unbind() = 0;
 
     virtual bool set_data(const uint8_t* data, uint32_t width, uint32_t height) = 0;
+    // copy texels for a sub-rectangle only; pitch is the source row size in bytes
+    virtual bool update_region(const texture_region& region, const uint8_t* data, uint32_t pitch) = 0;
     virtual bool apply_changes() = 0;
     virtual bool get_size(uint32_t& width, uint32_t& height) const = 0;
     virtual void clear_data() = 0;
@@ -34,14 +52,17 @@ class texture_dict {
 public:
     virtual ~texture_dict() = default;
 
-    virtual tex create_texture(uint32_t width, uint32_t height) = 0;
+    virtual tex create_texture(uint32_t width, uint32_t height, texture_format format = texture_format::rgba8) = 0;
 #ifdef _WIN32
     virtual tex create_texture_from_d3d11(ID3D11Texture2D* d3d_texture, ID3D11ShaderResourceView* srv = nullptr) = 0;
 #endif
     virtual void destroy_texture(tex tex) = 0;
     virtual bool set_texture_data(tex tex, const uint8_t* data, uint32_t width, uint32_t height) = 0;
+    virtual bool update_texture_region(tex tex, const texture_region& region, const uint8_t* data, uint32_t pitch) = 0;
     virtual bool get_texture_size(tex tex, uint32_t& width, uint32_t& height) = 0;
     virtual void clear_textures() = 0;
+    // texel storage of every texture alive in the dict
+    virtual size_t memory_bytes() const = 0;
     virtual void pre_reset() = 0;
     virtual void post_reset() = 0;
 };
@@ -0,0 +1,28 @@
+#pragma once
+#include "../core/draw_buffer.h"
+#include <cstdint>
+
+// geometry for tests that build draw buffers by hand
+
+// an axis aligned quad, uvs 0..1 across it, indices for two triangles
+inline void add_quad(core::draw_buffer& buf, float x0, float y0, float x1, float y1, uint32_t col) {
+    const uint32_t base = static_cast<uint32_t>(buf.vertices.size());
+    buf.vertices.emplace_back(x0, y0, 0.0f, col, 0.0f, 0.0f);
+    buf.vertices.emplace_back(x1, y0, 0.0f, col, 1.0f, 0.0f);
+    buf.vertices.emplace_back(x1, y1, 0.0f, col, 1.0f, 1.0f);
+    buf.vertices.emplace_back(x0, y1, 0.0f, col, 0.0f, 1.0f);
+    for (uint32_t i : {0u, 1u, 2u, 0u, 2u, 3u}) buf.indices.push_back(base + i);
+}
+
+inline core::draw_command& add_command(core::draw_buffer& buf, core::geometry_type type, uint32_t elem_count) {
+    auto& cmd = buf.cmds.emplace_back();
+    cmd.type = type;
+    cmd.elem_count = elem_count;
+    return cmd;
+}
+
+// a quad with its own color_only command
+inline void add_color_quad(core::draw_buffer& buf, float x0, float y0, float x1, float y1, uint32_t col) {
+    add_quad(buf, x0, y0, x1, y1, col);
+    add_command(buf, core::geometry_type::color_only, 6);
+}
@@ -0,0 +1,93 @@
+#include "../resources/atlas_cache.h"
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+resources::atlas_cache_key test_key() {
+    resources::atlas_cache_key key;
+    key.font_hash = 0x1234abcdull;
+    key.size = 24.f;
+    key.flags = resources::atlas_cache::flag_sdf;
+    return key;
+}
+
+void write_sample(const resources::atlas_cache_key& key) {
+    std::vector<resources::atlas_page> pages;
+    pages.emplace_back(64, 64, resources::texture_format::r8);
+    std::vector<unsigned char> glyph(8 * 8, 180);
+    resources::atlas_rect rect;
+    assert(pages[0].pack(8, 8, rect));
+    pages[0].write(rect, glyph.data(), 8);
+
+    std::unordered_map<uint32_t, resources::glyph_info> glyphs;
+    resources::glyph_info info = {};
+    info.codepoint = 'A';
+    info.width = info.height = 8;
+    info.advance = 9;
+    info.u1 = info.v1 = 8.f / 64.f;
+    glyphs['A'] = info;
+    // subpixel variant: same codepoint, its own key and phase
+    info.phase = 2;
+    info.advance = 8.75f;
+    glyphs[resources::font::glyph_key('A', 2)] = info;
+
+    resources::font_metrics metrics;
+    metrics.ascender = 18.f;
+    metrics.line_height = 28.f;
+    assert(resources::atlas_cache::write(key, metrics, pages, glyphs));
+}
+
+void test_round_trip() {
+    auto key = test_key();
+    write_sample(key);
+
+    resources::atlas_cache::reader reader;
+    assert(reader.open(key));
+    assert(reader.pages().size() == 1);
+    const auto& page = reader.pages()[0];
+    assert(page.width == 64 && page.format == resources::texture_format::r8);
+    assert(page.pixels[0] == 180 && page.pixels[8] == 0);
+    assert(page.shelf.x == 9); // packing continues after the restored glyph
+    assert(reader.glyphs().size() == 2);
+    for (const auto& glyph : reader.glyphs()) {
+        assert(glyph.codepoint == 'A');
+        assert(glyph.phase == 0 ? glyph.advance == 9.f : glyph.phase == 2 && glyph.advance == 8.75f);
+    }
+    assert(reader.metrics().line_height == 28.f);
+
+    // a different size or flag set is a different entry
+    auto other = key;
+    other.size = 25.f;
+    resources::atlas_cache::reader miss;
+    assert(!miss.open(other));
+}
+
+void test_corruption() {
+    auto key = test_key();
+    write_sample(key);
+    const auto path = resources::atlas_cache::path_for(key);
+
+    // flip a pixel byte: the checksum rejects the file
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(-1, std::ios::end);
+        f.put('\x7f');
+    }
+    resources::atlas_cache::reader reader;
+    assert(!reader.open(key));
+
+    // truncated file
+    std::filesystem::resize_file(path, 16);
+    assert(!reader.open(key));
+    std::filesystem::remove(path);
+}
+
+int main() {
+    resources::atlas_cache::set_directory((std::filesystem::temp_directory_path() / "frameview_atlas_test").string());
+    test_round_trip();
+    test_corruption();
+    std::cout << "Atlas cache tests completed." << std::endl;
+    return 0;
+}
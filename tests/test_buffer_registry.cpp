@@ -0,0 +1,102 @@
+#include "../core/buffer_registry.h"
+#include "../utils/slot_map.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct fake_buffer {
+    int value = 0;
+};
+
+void test_slot_map() {
+    utils::slot_map<std::string> map;
+    auto a = map.insert("a");
+    auto b = map.insert("b");
+    assert(map.size() == 2 && *map.get(a) == "a" && *map.get(b) == "b");
+    assert(!map.get(utils::slot_map<std::string>::null));
+
+    // the slot is reused, the old handle is stale
+    assert(map.erase(a) && !map.erase(a));
+    auto c = map.insert("c");
+    assert(static_cast<uint32_t>(c) == static_cast<uint32_t>(a) && c != a);
+    assert(!map.get(a) && *map.get(c) == "c" && *map.get(b) == "b");
+
+    int live = 0;
+    map.for_each([&](auto, std::string&) { ++live; });
+    assert(live == 2);
+    map.clear();
+    assert(map.empty() && !map.contains(b) && !map.contains(c));
+}
+
+std::vector<int> draw_order(const core::buffer_registry<fake_buffer>& reg) {
+    std::vector<int> order;
+    reg.for_each([&](core::buffer_id, const fake_buffer& buf) { order.push_back(buf.value); });
+    return order;
+}
+
+void test_registry() {
+    core::buffer_registry<fake_buffer> reg;
+    auto a = reg.add(5);
+    auto b = reg.add(1);
+    auto c = reg.add(5); // same priority as a: registration order
+    auto b1 = reg.add(2, b);
+    auto b0 = reg.add(0, b);
+    reg.get(a)->value = 1;
+    reg.get(b)->value = 2;
+    reg.get(c)->value = 3;
+    reg.get(b1)->value = 21;
+    reg.get(b0)->value = 20;
+    assert((draw_order(reg) == std::vector<int>{2, 20, 21, 1, 3}));
+
+    // reprioritizing moves a buffer among its siblings only
+    reg.set_priority(a, 0);
+    reg.set_priority(b0, 9);
+    assert((draw_order(reg) == std::vector<int>{1, 2, 21, 20, 3}));
+
+    // removing a parent removes its children; other handles stay valid
+    fake_buffer* kept = reg.get(c);
+    assert(reg.remove(b) && reg.size() == 2);
+    assert(!reg.get(b) && !reg.get(b0) && !reg.get(b1) && reg.get(c) == kept);
+    assert(!reg.remove(b) && !reg.set_priority(b1, 3));
+    assert(reg.add(0, b) == core::invalid_buffer);
+
+    // reset swaps in an empty buffer under the same handle
+    assert(reg.reset(c) && reg.get(c)->value == 0);
+    assert((draw_order(reg) == std::vector<int>{1, 0}));
+}
+
+void test_churn() {
+    // transient buffers coming and going under a long-lived parent
+    core::buffer_registry<fake_buffer> reg;
+    auto root = reg.add(0);
+    std::vector<core::buffer_id> stale;
+    for (int frame = 0; frame < 1000; ++frame) {
+        auto tip = reg.add(static_cast<size_t>(frame % 7), root);
+        reg.get(tip)->value = frame;
+        if (frame % 3) {
+            reg.remove(tip);
+            stale.push_back(tip);
+        }
+    }
+    assert(reg.size() == 1 + 334);
+    for (auto id : stale) assert(!reg.contains(id));
+    size_t visited = 0;
+    size_t last_priority = 0;
+    reg.for_each([&](core::buffer_id id, const fake_buffer& buf) {
+        if (id == root) return;
+        const size_t priority = static_cast<size_t>(buf.value % 7);
+        assert(priority >= last_priority);
+        last_priority = priority;
+        ++visited;
+    });
+    assert(visited == 334);
+}
+
+int main() {
+    test_slot_map();
+    test_registry();
+    test_churn();
+    std::cout << "Buffer registry tests completed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "../resources/codepoint_set.h"
+#include <cassert>
+#include <iostream>
+
+void test_insert_contains() {
+    resources::codepoint_set set;
+    assert(set.empty() && !set.contains('A'));
+    for (uint32_t c = 32; c < 127; ++c) set.insert(c);
+    set.insert(0x4E00);
+    set.insert(0x1F600);
+    set.insert('A'); // duplicate
+    assert(set.size() == 97);
+    assert(set.contains(' ') && set.contains('~') && !set.contains(127) && !set.contains(31));
+    assert(set.contains(0x4E00) && !set.contains(0x4E01));
+    assert(set.contains(0x1F600) && !set.contains(0x10FFFF));
+    // one block for ascii, one each for the two others
+    assert(set.block_count() == 3);
+}
+
+void test_bounds() {
+    resources::codepoint_set set;
+    set.insert(0x110000); // out of unicode range, ignored
+    assert(set.empty());
+    set.insert(0x10FFFF);
+    assert(set.contains(0x10FFFF) && !set.contains(0xFFFFFFFF));
+    set.clear();
+    assert(set.empty() && !set.contains(0x10FFFF));
+}
+
+int main() {
+    test_insert_contains();
+    test_bounds();
+    std::cout << "Codepoint set tests completed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "../resources/distance_field.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// filled 8x8 square inside a 16x16 bitmap
+std::vector<unsigned char> make_square() {
+    std::vector<unsigned char> bmp(16 * 16, 0);
+    for (int y = 4; y < 12; ++y)
+        for (int x = 4; x < 12; ++x)
+            bmp[y * 16 + x] = 255;
+    return bmp;
+}
+
+void test_sign() {
+    const int spread = 4;
+    const int ext = resources::sdf_extent(16, spread);
+    assert(ext == 24);
+    auto bmp = make_square();
+    std::vector<unsigned char> sdf(ext * ext);
+    resources::make_sdf(bmp.data(), 16, 16, 16, sdf.data(), spread);
+
+    auto at = [&](int x, int y) { return sdf[(y + spread) * ext + (x + spread)]; };
+    assert(at(8, 8) > 128);   // center is inside
+    assert(at(0, 0) < 128);   // corner is outside
+    assert(sdf[0] == 0);      // padding beyond the spread clamps to 0
+}
+
+void test_monotonic() {
+    const int spread = 4;
+    const int ext = resources::sdf_extent(16, spread);
+    auto bmp = make_square();
+    std::vector<unsigned char> sdf(ext * ext);
+    resources::make_sdf(bmp.data(), 16, 16, 16, sdf.data(), spread);
+
+    // walking from the center out along a row never increases the distance value
+    const int row = (8 + spread) * ext;
+    for (int x = 8 + spread; x + 1 < ext; ++x) {
+        assert(sdf[row + x + 1] <= sdf[row + x]);
+    }
+    // the edge sits around the midpoint of the range
+    int edge_in = sdf[row + 11 + spread], edge_out = sdf[row + 12 + spread];
+    assert(edge_in > 128 && edge_out < 128);
+    assert(std::abs((edge_in + edge_out) / 2 - 128) <= 2);
+}
+
+// 10x10 px square outline at the origin, counter-clockwise like a postscript font
+resources::msdf_bitmap make_square_msdf(int spread) {
+    FT_Vector points[4] = {{0, 0}, {640, 0}, {640, 640}, {0, 640}};
+    char tags[4] = {FT_CURVE_TAG_ON, FT_CURVE_TAG_ON, FT_CURVE_TAG_ON, FT_CURVE_TAG_ON};
+    short contours[1] = {3};
+    FT_Outline outline = {};
+    outline.n_points = 4;
+    outline.n_contours = 1;
+    outline.points = points;
+    outline.tags = tags;
+    outline.contours = contours;
+    resources::msdf_bitmap bmp;
+    bool ok = resources::make_msdf(outline, spread, bmp);
+    assert(ok);
+    return bmp;
+}
+
+int median_at(const resources::msdf_bitmap& bmp, int x, int y) {
+    const unsigned char* t = &bmp.rgba[(y * bmp.width + x) * 4];
+    return std::max(std::min(t[0], t[1]), std::min(std::max(t[0], t[1]), t[2]));
+}
+
+void test_msdf_square() {
+    const int spread = 4;
+    auto bmp = make_square_msdf(spread);
+    assert(bmp.width == 18 && bmp.height == 18);
+    assert(bmp.left == -spread && bmp.top == 10 + spread);
+
+    assert(median_at(bmp, 9, 9) > 128);   // center
+    assert(median_at(bmp, 1, 1) < 128);   // outside the corner
+    assert(median_at(bmp, 9, 1) < 128);   // above the top edge
+    // the corner texel just inside stays inside: a plain sdf rounds it away at low thresholds
+    assert(median_at(bmp, spread, spread) > 128);
+    // alpha carries the true distance with the same sign
+    assert(bmp.rgba[(9 * bmp.width + 9) * 4 + 3] > 128);
+    assert(bmp.rgba[(1 * bmp.width + 1) * 4 + 3] < 128);
+}
+
+void test_msdf_orientation() {
+    // the same square wound the other way (truetype) gives the same field
+    FT_Vector points[4] = {{0, 0}, {0, 640}, {640, 640}, {640, 0}};
+    char tags[4] = {FT_CURVE_TAG_ON, FT_CURVE_TAG_ON, FT_CURVE_TAG_ON, FT_CURVE_TAG_ON};
+    short contours[1] = {3};
+    FT_Outline outline = {};
+    outline.n_points = 4;
+    outline.n_contours = 1;
+    outline.points = points;
+    outline.tags = tags;
+    outline.contours = contours;
+    resources::msdf_bitmap cw;
+    assert(resources::make_msdf(outline, 4, cw));
+    auto ccw = make_square_msdf(4);
+    assert(cw.rgba.size() == ccw.rgba.size());
+    for (int y = 0; y < cw.height; ++y)
+        for (int x = 0; x < cw.width; ++x)
+            assert(std::abs(median_at(cw, x, y) - median_at(ccw, x, y)) <= 1);
+
+    // empty outlines produce nothing
+    FT_Outline empty = {};
+    resources::msdf_bitmap none;
+    assert(!resources::make_msdf(empty, 4, none));
+    assert(none.width == 0 && none.rgba.empty());
+}
+
+void test_partial_coverage() {
+    // half covered texel lands on the outline
+    unsigned char half = 128;
+    std::vector<unsigned char> sdf(resources::sdf_extent(1, 2) * resources::sdf_extent(1, 2));
+    resources::make_sdf(&half, 1, 1, 1, sdf.data(), 2);
+    int center = sdf[2 * 5 + 2];
+    assert(std::abs(center - 128) <= 2);
+}
+
+int main() {
+    test_sign();
+    test_monotonic();
+    test_partial_coverage();
+    test_msdf_square();
+    test_msdf_orientation();
+    std::cout << "Distance field tests completed." << std::endl;
+    return 0;
+}
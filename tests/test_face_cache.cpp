@@ -0,0 +1,105 @@
+#include "../resources/face_cache.h"
+#include "../resources/font.h"
+#include "../utils/thread_pool.h"
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+void test_share_memory() {
+    auto& cache = resources::face_cache::instance();
+    std::vector<unsigned char> blob(4096, 7);
+
+    // the same buffer is copied once, however many fonts are built from it
+    auto a = cache.share_memory(blob.data(), blob.size());
+    auto b = cache.share_memory(blob.data(), blob.size());
+    assert(a && a == b);
+    assert(!a->mapped());
+    assert(a->data() != blob.data());
+
+    // reused address with different contents is a different file
+    blob[0] = 1;
+    auto c = cache.share_memory(blob.data(), blob.size());
+    assert(c && c != a);
+    assert(c->data()[0] == 1);
+}
+
+void test_shared_face(const char* path) {
+    auto& cache = resources::face_cache::instance();
+    auto face = cache.open(path);
+    if (!face) {
+        std::cout << "skipping shared face test, no font at " << path << std::endl;
+        return;
+    }
+    assert(face->file()->mapped());
+    assert(cache.open(path) == face);
+
+    // two sizes on one face keep their own metrics
+    {
+        resources::face_size small(face, 16.f);
+        resources::face_size large(face, 48.f);
+        assert(small.valid() && large.valid());
+        long small_height = small.activate()->size->metrics.height;
+        long large_height = large.activate()->size->metrics.height;
+        assert(large_height > small_height);
+    }
+
+    // fonts of different sizes from one file share one mapping and face
+    size_t files = cache.file_count();
+    auto f16 = std::make_shared<resources::font>(path, 16.f);
+    auto f32 = std::make_shared<resources::font>(path, 32.f);
+#ifdef _WIN32
+    assert(f16->load(nullptr, nullptr) && f32->load(nullptr, nullptr));
+#else
+    assert(f16->load(nullptr) && f32->load(nullptr));
+#endif
+    assert(cache.file_count() == files);
+    assert(f32->glyphs().at('A').height > f16->glyphs().at('A').height);
+
+    // the face goes away with its last user; glyph jobs still queued on the
+    // pool hold it until they finish
+    f16.reset();
+    f32.reset();
+    utils::thread_pool::shared().wait_idle();
+    std::weak_ptr<resources::shared_face> weak = face;
+    face.reset();
+    assert(weak.expired());
+}
+
+void test_memory_font(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cout << "skipping memory font test, no font at " << path << std::endl;
+        return;
+    }
+    std::vector<unsigned char> blob{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    // a font built from a buffer rasterizes only its preload set up front
+    resources::font f(blob.data(), blob.size(), 20.f);
+    f.set_preload({'A', 'b', '1'});
+    f.set_async_glyphs(false);
+#ifdef _WIN32
+    assert(f.load(nullptr, nullptr));
+#else
+    assert(f.load(nullptr));
+#endif
+    assert(f.glyphs().size() == 3);
+    for (uint32_t c : {'A', 'b', '1'}) assert(f.has_glyph(c) && f.get_glyph_page(c) == 0);
+    assert(!f.has_glyph('Z') && f.get_glyph_page('Z') == -1);
+
+    // anything else is paged in on first use, next to the preloaded glyphs
+    auto atlas = f.atlas();
+    assert(f.covers('Z') && f.ensure_glyph('Z'));
+    assert(f.glyphs().size() == 4 && f.get_glyph_page('Z') == 0);
+    assert(f.atlas() == atlas && f.page_count() == 1);
+}
+
+int main(int argc, char** argv) {
+    test_share_memory();
+    const char* path = argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf";
+    test_shared_face(path);
+    test_memory_font(path);
+    std::cout << "Face cache tests completed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "../resources/atlas_cache.h"
+#include "../resources/font.h"
+#include "../utils/thread_pool.h"
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// a folder of copies of one face under font extensions, a broken one and a
+// file that isn't a font
+fs::path make_folder(const char* path) {
+    const fs::path dir = fs::temp_directory_path() / "fv_test_font_folder";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    for (const char* name : {"a.ttf", "b.otf", "c.TTF"}) fs::copy_file(path, dir / name);
+    std::ofstream(dir / "d_broken.ttf") << "not a font";
+    std::ofstream(dir / "readme.txt") << "skipped";
+    return dir;
+}
+
+void same_font(const resources::font& a, const resources::font& b) {
+    assert(a.path() == b.path());
+    assert(a.metrics().ascender == b.metrics().ascender && a.metrics().line_height == b.metrics().line_height);
+    assert(a.covers('A') && b.covers('A'));
+}
+
+void test_folder(const char* path) {
+    if (!fs::exists(path)) {
+        std::cout << "skipping folder test, no font at " << path << std::endl;
+        return;
+    }
+    const fs::path dir = make_folder(path);
+
+    // every font file gets a handle at once, in file name order; the broken
+    // one reports its failure through its future
+    auto loads = resources::font::load_all_from_folder_async(dir.string(), 16.0f);
+    assert(loads.size() == 4);
+    std::vector<resources::font_ptr> loaded;
+    for (auto& load : loads) {
+        const bool ok = load.ready.get();
+        assert(ok == (fs::path(load.handle->path()).filename() != "d_broken.ttf"));
+        if (ok) loaded.push_back(load.handle);
+    }
+    assert(loaded.size() == 3);
+    assert(fs::path(loaded[0]->path()).filename() == "a.ttf" && fs::path(loaded[2]->path()).filename() == "c.TTF");
+    for (const auto& f : loaded) assert(f->metrics().line_height > 0.0f && f->ensure_glyph('A'));
+
+    // the blocking version returns the same fonts, failures left out
+    auto serial = resources::font::load_all_from_folder(dir.string(), 16.0f);
+    assert(serial.size() == loaded.size());
+    for (size_t i = 0; i < serial.size(); ++i) same_font(*serial[i], *loaded[i]);
+
+    // on a pool worker the loads run inline: every future is ready on return
+    auto nested = utils::thread_pool::shared().async([&] {
+        auto inner = resources::font::load_all_from_folder_async(dir.string(), 16.0f);
+        for (auto& load : inner) assert(load.ready.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        return inner;
+    }).get();
+    assert(nested.size() == 4 && !nested.back().ready.get());
+
+    fs::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+    resources::atlas_cache::set_enabled(false);
+    test_folder(argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf");
+    std::cout << "Font folder tests completed." << std::endl;
+    return 0;
+}
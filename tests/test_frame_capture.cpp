@@ -0,0 +1,131 @@
+#include "../core/frame_capture.h"
+#include "../resources/atlas_cache.h"
+#include "../resources/cpu_texture.h"
+#include "../resources/font.h"
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// geometry and commands set directly, as draw_buffer's methods would
+core::draw_buffer make_buffer(resources::tex texture, std::shared_ptr<resources::font> font) {
+    core::draw_buffer buf;
+    for (int i = 0; i < 8; ++i) buf.vertices.emplace_back(float(i), float(i * 2), 0.0f, 0xff00ff00u + i, 0.5f, 0.25f);
+    buf.indices = {0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7};
+
+    core::draw_command color;
+    color.elem_count = 3;
+    color.type = core::geometry_type::color_only;
+    color.shader_hint = "color_only";
+    color.clip_rect = core::rect(1, 2, 3, 4);
+    buf.cmds.push_back(color);
+
+    core::draw_command textured;
+    textured.elem_count = 3;
+    textured.type = core::geometry_type::textured;
+    textured.native_texture = true;
+    textured.texture = texture;
+    textured.shader_hint = "generic";
+    textured.callback = [](const core::draw_command*) {};
+    buf.cmds.push_back(textured);
+
+    core::draw_command glyphs;
+    glyphs.elem_count = 6;
+    glyphs.type = core::geometry_type::font_atlas;
+    glyphs.font_texture = true;
+    glyphs.font = font;
+    glyphs.texture = font ? font->get_atlas_tex(0) : nullptr;
+    glyphs.shader_hint = "font";
+    buf.cmds.push_back(glyphs);
+    return buf;
+}
+
+void test_window_and_sharing(core::frame_capture& capture, resources::tex texture, std::shared_ptr<resources::font> font) {
+    const auto buf = make_buffer(texture, font);
+    for (int i = 0; i < 3; ++i) {
+        capture.begin_frame();
+        capture.record(buf);
+        capture.end_frame();
+    }
+    assert(capture.frame_count() == 2);
+    auto frames = capture.frames();
+    assert(frames[0].number == 1 && frames[1].number == 2);
+    // unchanged textures are copied once and shared
+    assert(frames[0].textures.size() == frames[1].textures.size());
+    assert(frames[0].textures[0] == frames[1].textures[0]);
+
+    // an upload makes the next frame take a new copy
+    const uint8_t red[4] = {255, 0, 0, 255};
+    assert(texture->update_region({1, 1, 1, 1}, red, 4));
+    capture.begin_frame();
+    capture.record(buf);
+    capture.end_frame();
+    frames = capture.frames();
+    assert(frames[1].textures[0] != frames[0].textures[0]);
+    const auto& pixels = frames[1].textures[0]->pixels;
+    assert(pixels[(1 * 4 + 1) * 4] == 255 && frames[0].textures[0]->pixels[(1 * 4 + 1) * 4] == 0);
+
+    const auto& cmds = frames[1].buffers[0].commands;
+    assert(cmds.size() == 3);
+    assert(cmds[0].texture == -1 && cmds[0].clip_rect[3] == 4.0f && std::strcmp(cmds[0].shader_hint, "color_only") == 0);
+    assert((cmds[1].flags & core::frame_capture::command::has_callback) && (cmds[1].flags & core::frame_capture::command::native_texture));
+    if (font) {
+        // the atlas page comes from the font's cpu pixels
+        const auto& page = frames[1].textures[cmds[2].texture];
+        assert(page->format == resources::texture_format::r8 && page->pixels == font->atlas()->pages()[0].pixels());
+    }
+}
+
+void test_file(const core::frame_capture& capture, bool with_font) {
+    const auto path = (std::filesystem::temp_directory_path() / "frameview_capture_test.fvcap").string();
+    assert(capture.save(path));
+
+    core::frame_capture::reader reader;
+    assert(reader.open(path));
+    const auto frames = capture.frames();
+    assert(reader.frames().size() == frames.size());
+    // one copy per distinct texture version: two of the cpu texture, one page
+    assert(reader.textures().size() == (with_font ? 3u : 2u));
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const auto& view = reader.frames()[f];
+        assert(view.number == frames[f].number && view.buffers.size() == 1);
+        const auto& buf = view.buffers[0];
+        const auto& src = frames[f].buffers[0];
+        assert(buf.vertex_count == src.vertices.size() && buf.index_count == src.indices.size());
+        assert(std::memcmp(buf.vertices, src.vertices.data(), src.vertices.size() * sizeof(core::vertex)) == 0);
+        assert(std::memcmp(buf.indices, src.indices.data(), src.indices.size() * sizeof(uint32_t)) == 0);
+        assert(buf.command_count == 3 && buf.commands[1].texture >= 0);
+        const auto& texture = reader.textures()[buf.commands[1].texture];
+        assert(texture.width == 4 && texture.pixels);
+        assert(std::memcmp(texture.pixels, frames[f].textures[src.commands[1].texture]->pixels.data(), 64) == 0);
+    }
+
+    // any flipped byte is caught by the checksum
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('\x5a');
+    }
+    core::frame_capture::reader corrupt;
+    assert(!corrupt.open(path));
+    std::filesystem::remove(path);
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf";
+    resources::atlas_cache::set_enabled(false);
+    resources::cpu_texture_dict dict;
+    auto texture = dict.create_texture(4, 4);
+    auto font = std::make_shared<resources::font>(path, 16.0f);
+    if (!font->load(&dict)) {
+        std::cout << "no font at " << path << ", capturing without text" << std::endl;
+        font.reset();
+    }
+
+    core::frame_capture capture(2);
+    test_window_and_sharing(capture, texture, font);
+    test_file(capture, font != nullptr);
+    std::cout << "Frame capture tests completed." << std::endl;
+    return 0;
+}
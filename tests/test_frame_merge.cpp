@@ -0,0 +1,278 @@
+#include "../backend/software/software_renderer.h"
+#include "../core/buffer_registry.h"
+#include "../core/frame_merge.h"
+#include "../resources/atlas_cache.h"
+#include "../resources/cpu_texture.h"
+#include "../resources/font.h"
+#include "../utils/thread_pool.h"
+#include "draw_helpers.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <vector>
+
+using backend::software::software_renderer;
+
+void test_rebase() {
+    core::draw_buffer a, b, c, out;
+    add_color_quad(a, 0, 0, 1, 1, 0xff0000ffu);
+    add_color_quad(b, 1, 1, 2, 2, 0xff00ff00u);
+    add_color_quad(b, 2, 2, 3, 3, 0xffff0000u);
+    add_color_quad(c, 3, 3, 4, 4, 0xffffffffu);
+    const core::draw_buffer* buffers[] = {&a, nullptr, &b, &c};
+    assert(core::merge_buffers(buffers, out));
+    assert(out.vertices.size() == 16 && out.indices.size() == 24 && out.cmds.size() == 4);
+    // b's indices now point past a's vertices, c's past both
+    assert(out.indices[6] == 4 && out.indices[12 + 5] == 8 + 3 && out.indices[18] == 12);
+    assert(out.vertices[12].col_u32 == 0xffffffffu && out.vertices[4].pos[0] == 1.0f);
+
+    // the output is reused: nothing of the previous frame is left
+    const core::draw_buffer* one[] = {&c};
+    assert(core::merge_buffers(one, out));
+    assert(out.vertices.size() == 4 && out.indices[0] == 0 && out.cmds.size() == 1);
+    assert(core::merge_buffers({}, out) && out.vertices.empty() && out.cmds.empty());
+}
+
+void test_parallel() {
+    // many small buffers and a few large ones, merged on a pool and serially
+    std::vector<core::draw_buffer> sources(300);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const int quads = i % 50 == 0 ? 4000 : 3;
+        for (int q = 0; q < quads; ++q) {
+            add_color_quad(sources[i], float(q % 64), float(i), float(q % 64 + 1), float(i + 1), 0xff000000u | uint32_t(i));
+        }
+    }
+    std::vector<const core::draw_buffer*> buffers;
+    for (const auto& s : sources) buffers.push_back(&s);
+
+    utils::thread_pool pool(3);
+    core::draw_buffer merged;
+    assert(core::merge_buffers(buffers, merged, &pool));
+
+    size_t vertex_base = 0, index_base = 0;
+    for (const auto& s : sources) {
+        for (size_t v = 0; v < s.vertices.size(); ++v) {
+            assert(merged.vertices[vertex_base + v].col_u32 == s.vertices[v].col_u32);
+        }
+        for (size_t i = 0; i < s.indices.size(); ++i) {
+            assert(merged.indices[index_base + i] == s.indices[i] + vertex_base);
+        }
+        vertex_base += s.vertices.size();
+        index_base += s.indices.size();
+    }
+    assert(merged.vertices.size() == vertex_base && merged.indices.size() == index_base);
+
+    // from a pool worker it stays on that thread instead of waiting on its own pool
+    auto nested = pool.async([&]() {
+        core::draw_buffer out;
+        return core::merge_buffers(buffers, out, &pool) && out.indices == merged.indices;
+    });
+    assert(nested.get());
+}
+
+void test_draw() {
+    // a merged frame draws the same pixels in fewer draw calls
+    core::buffer_registry<core::draw_buffer> reg;
+    auto back = reg.add(0);
+    auto popup = reg.add(1);
+    auto label = reg.add(0, popup);
+    add_color_quad(*reg.get(popup), 2, 2, 10, 10, 0xff00ff00u);
+    add_color_quad(*reg.get(back), 0, 0, 16, 16, 0xff0000ffu);
+    add_color_quad(*reg.get(label), 4, 4, 8, 8, 0xffff0000u);
+
+    std::vector<const core::draw_buffer*> buffers;
+    reg.for_each([&](core::buffer_id, const core::draw_buffer& buf) { buffers.push_back(&buf); });
+
+    software_renderer separate;
+    separate.initialize(16, 16);
+    separate.begin_frame();
+    for (auto* buf : buffers) separate.draw_buffer(buf);
+    separate.end_frame();
+
+    core::draw_buffer frame;
+    assert(core::merge_buffers(buffers, frame));
+    software_renderer merged;
+    merged.initialize(16, 16);
+    merged.begin_frame();
+    merged.draw_buffer(&frame);
+    merged.end_frame();
+
+    assert(merged.pixels() == separate.pixels());
+    assert(merged.pixels()[6 * 16 + 6] == 0xffff0000u); // the label is on top
+    assert(separate.stats().draw_calls == 3 && separate.stats().buffers == 3);
+    assert(merged.stats().draw_calls == 1 && merged.stats().merged_commands == 2 && merged.stats().buffers == 1);
+}
+
+// counts what the builder asks of the backend, keeping copies like a gpu one would
+class recording_renderer : public software_renderer {
+public:
+    void draw_buffer(const core::draw_buffer* buf) override {
+        ++dynamic_draws;
+        software_renderer::draw_buffer(buf);
+    }
+    void draw_retained(uint64_t key, const core::draw_buffer* buf) override {
+        if (kept.insert(key).second) ++uploads;
+        software_renderer::draw_buffer(buf);
+        ++_stats.stats().retained_buffers;
+    }
+    void release_retained(uint64_t key) override {
+        assert(kept.erase(key) == 1);
+        ++releases;
+    }
+
+    std::set<uint64_t> kept;
+    int dynamic_draws = 0, uploads = 0, releases = 0;
+};
+
+void test_builder() {
+    // a frozen background and legend around two dynamic buffers
+    core::buffer_registry<core::draw_buffer> reg;
+    auto back = reg.add(0);
+    auto series = reg.add(1);
+    auto cursor = reg.add(2);
+    auto legend = reg.add(3);
+    add_color_quad(*reg.get(back), 0, 0, 16, 16, 0xff202020u);
+    add_color_quad(*reg.get(series), 2, 2, 12, 12, 0xff00ff00u);
+    add_color_quad(*reg.get(cursor), 6, 0, 7, 16, 0xffffffffu);
+    add_color_quad(*reg.get(legend), 10, 10, 16, 16, 0xff0000ffu);
+    reg.get(back)->freeze();
+    reg.get(legend)->freeze();
+
+    recording_renderer r;
+    r.initialize(16, 16);
+    core::frame_builder builder;
+    auto frame = [&] {
+        r.begin_frame();
+        reg.for_each([&](core::buffer_id id, const core::draw_buffer& buf) { builder.add(id, buf); });
+        builder.draw(r);
+        r.end_frame();
+    };
+
+    software_renderer separate;
+    separate.initialize(16, 16);
+    separate.begin_frame();
+    reg.for_each([&](core::buffer_id, const core::draw_buffer& buf) { separate.draw_buffer(&buf); });
+    separate.end_frame();
+
+    // the dynamic pair is merged between the two frozen buffers, in draw order
+    frame();
+    assert(r.pixels() == separate.pixels());
+    assert(r.uploads == 2 && r.dynamic_draws == 1 && builder.retained() == 2);
+    assert(r.stats().buffers == 3 && r.stats().retained_buffers == 2);
+    assert(r.stats().draw_calls == 3 && r.stats().merged_commands == 1);
+
+    // frozen buffers are drawn again without another upload
+    for (int i = 0; i < 3; ++i) frame();
+    assert(r.uploads == 2 && r.dynamic_draws == 4 && r.releases == 0);
+    assert(r.pixels() == separate.pixels());
+
+    // a new version, or contents replaced behind the buffer's back, uploads again
+    reg.get(legend)->invalidate();
+    frame();
+    assert(r.uploads == 3 && r.releases == 1);
+    builder.invalidate(back);
+    frame();
+    assert(r.uploads == 4 && r.releases == 2);
+    auto& moved = *reg.get(legend);
+    moved.vertices.clear();
+    moved.indices.clear();
+    moved.cmds.clear();
+    add_color_quad(moved, 0, 0, 4, 4, 0xffff0000u);
+    moved.invalidate();
+    frame();
+    assert(r.uploads == 5 && r.releases == 3 && r.pixels()[1 * 16 + 1] == 0xffff0000u);
+
+    // a thawed buffer joins the dynamic run; a removed one is released
+    reg.get(back)->thaw();
+    frame();
+    assert(r.releases == 4 && builder.retained() == 1 && r.stats().buffers == 2);
+    reg.remove(legend);
+    frame();
+    assert(r.releases == 5 && builder.retained() == 0 && r.kept.empty());
+    assert(r.uploads == 5 && r.stats().buffers == 1 && r.stats().retained_buffers == 0);
+}
+
+void test_frozen_text(const char* path) {
+    // a one page budget on small pages: a few frames of other text fill it
+    resources::cpu_texture_dict dict;
+    auto atlas = std::make_shared<resources::glyph_atlas>(64, 64);
+    auto font = std::make_shared<resources::font>(path, 24.0f);
+    font->set_atlas(atlas);
+    font->set_preload({});
+    font->set_atlas_budget(64 * 64);
+    if (!font->load(&dict)) {
+        std::cout << "no font at " << path << ", skipping frozen text" << std::endl;
+        return;
+    }
+
+    // a frozen label drawing 'A' over the whole target, recorded once
+    core::buffer_registry<core::draw_buffer> reg;
+    auto label = reg.add(0);
+    assert(font->ensure_glyph('A'));
+    const resources::glyph_info glyph = *font->use_glyph('A');
+    auto& buf = *reg.get(label);
+    const uint32_t white = 0xffffffffu;
+    buf.vertices.emplace_back(0.0f, 0.0f, 0.0f, white, glyph.u0, glyph.v0);
+    buf.vertices.emplace_back(16.0f, 0.0f, 0.0f, white, glyph.u1, glyph.v0);
+    buf.vertices.emplace_back(16.0f, 16.0f, 0.0f, white, glyph.u1, glyph.v1);
+    buf.vertices.emplace_back(0.0f, 16.0f, 0.0f, white, glyph.u0, glyph.v1);
+    for (uint32_t i : {0u, 1u, 2u, 0u, 2u, 3u}) buf.indices.push_back(i);
+    auto& cmd = buf.cmds.emplace_back();
+    cmd.type = core::geometry_type::font_atlas;
+    cmd.elem_count = 6;
+    cmd.font = font;
+    cmd.font_texture = true;
+    cmd.texture = font->get_atlas_tex(glyph.page);
+    cmd.font_frame = font->frame();
+    cmd.atlas_page = glyph.page;
+    buf.freeze();
+
+    recording_renderer r;
+    r.initialize(16, 16);
+    core::frame_builder builder;
+    // each frame draws eight other glyphs, digits and letters but 'A'
+    uint32_t next = '0';
+    auto frame = [&] {
+        r.begin_frame();
+        for (int i = 0; i < 8; ++i) {
+            assert(font->ensure_glyph(next) && font->use_glyph(next));
+            next = next == 'z' ? '0' : next == '@' ? 'B' : next + 1;
+        }
+        reg.for_each([&](core::buffer_id id, const core::draw_buffer& b) { builder.add(id, b); });
+        builder.draw(r);
+        r.end_frame();
+    };
+
+    frame();
+    const auto reference = r.pixels();
+    assert(std::any_of(reference.begin(), reference.end(), [](uint32_t px) { return px != 0xff000000u; }));
+
+    // the other letters are evicted from the pages around the label's, which
+    // is pinned while the builder keeps the copy: the label still draws
+    for (int i = 0; i < 12; ++i) frame();
+    assert(atlas->evicted_count() > 0 && !atlas->valid_since(cmd.font_frame));
+    assert(atlas->pinned(cmd.atlas_page) && font->atlas_valid_since(cmd.font_frame, cmd.atlas_page));
+    assert(r.uploads == 1 && r.pixels() == reference);
+
+    // released, the page is fair game again and the label's glyph goes first.
+    // nothing draws text now, so the frames end here
+    const uint32_t recorded = cmd.font_frame;
+    reg.remove(label);
+    for (int i = 0; i < 12; ++i) {
+        frame();
+        font->flush_atlas();
+    }
+    assert(!atlas->pinned(glyph.page) && !font->atlas_valid_since(recorded, glyph.page));
+}
+
+int main(int argc, char** argv) {
+    resources::atlas_cache::set_enabled(false);
+    test_rebase();
+    test_parallel();
+    test_draw();
+    test_builder();
+    test_frozen_text(argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf");
+    std::cout << "Frame merge tests completed." << std::endl;
+    return 0;
+}
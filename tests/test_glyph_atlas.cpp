@@ -0,0 +1,270 @@
+#include "../core/draw_buffer.h"
+#include "../resources/atlas_cache.h"
+#include "../resources/cpu_texture.h"
+#include "../resources/font.h"
+#include "../resources/glyph_atlas.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+void test_dirty_upload() {
+    resources::cpu_texture_dict dict;
+    resources::atlas_page page(64, 64);
+    page.attach(&dict);
+    auto tex = std::dynamic_pointer_cast<resources::cpu_texture>(page.texture());
+    assert(tex);
+
+    // nothing packed yet: flushing uploads nothing
+    assert(!page.dirty());
+    assert(page.flush(&dict) == 0);
+    assert(tex->upload_count() == 0);
+
+    // two glyphs on the same shelf coalesce into one upload
+    std::vector<unsigned char> glyph(4 * 4 * page.bytes_per_pixel(), 200);
+    resources::atlas_rect a, b;
+    assert(page.pack(4, 4, a));
+    assert(page.pack(4, 4, b));
+    page.write(a, glyph.data(), 4 * page.bytes_per_pixel());
+    page.write(b, glyph.data(), 4 * page.bytes_per_pixel());
+    assert(page.dirty_rects().size() == 1);
+
+    size_t bytes = page.flush(&dict);
+    assert(tex->upload_count() == 1);
+    assert(bytes == tex->uploaded_bytes());
+    assert(bytes < static_cast<size_t>(64 * 64 * page.bytes_per_pixel()));
+    assert(tex->data()[(b.y * 64 + b.x) * 4] == 200);
+
+    // clean page: second flush is free
+    tex->reset_upload_stats();
+    assert(page.flush(&dict) == 0);
+    assert(tex->upload_count() == 0);
+}
+
+void test_r8_page() {
+    resources::cpu_texture_dict dict;
+    resources::atlas_page page(64, 64, resources::texture_format::r8);
+    page.attach(&dict);
+    assert(page.texture()->format() == resources::texture_format::r8);
+    assert(page.pixels().size() == 64 * 64);
+
+    // coverage pages upload one byte per texel
+    std::vector<unsigned char> glyph(5 * 3, 255);
+    resources::atlas_rect r;
+    assert(page.pack(5, 3, r));
+    page.write(r, glyph.data(), 5);
+    assert(page.flush(&dict) == 5 * 3);
+}
+
+void test_page_full() {
+    resources::atlas_page page(16, 16);
+    resources::atlas_rect r;
+    // 2x2 shelves of 7px glyphs plus gutters fill the page
+    for (int i = 0; i < 4; ++i) assert(page.pack(7, 7, r));
+    assert(!page.pack(7, 7, r));
+}
+
+void test_release_reuse() {
+    resources::atlas_page page(16, 16, resources::texture_format::r8);
+    std::vector<unsigned char> glyph(7 * 7, 255);
+    resources::atlas_rect r[4];
+    for (auto& rect : r) {
+        assert(page.pack(7, 7, rect));
+        page.write(rect, glyph.data(), 7);
+    }
+    resources::atlas_rect extra;
+    assert(!page.pack(7, 7, extra));
+
+    // a released rectangle is cleared and packed again; smaller glyphs split it
+    page.release(r[1]);
+    assert(page.pixels()[r[1].y * 16 + r[1].x] == 0);
+    assert(page.pixels()[r[0].y * 16 + r[0].x] == 255);
+    assert(page.pack(3, 3, extra));
+    assert(extra.x == r[1].x && extra.y == r[1].y);
+    // best fit: the 4x4 strip below before the 4x8 one to the right
+    resources::atlas_rect below;
+    assert(page.pack(3, 3, below));
+    assert(below.x == r[1].x && below.y == r[1].y + 4);
+    assert(!page.pack(7, 7, extra));
+
+    // reset empties the page
+    page.reset();
+    assert(page.free_rect_count() == 0);
+    assert(page.pixels()[r[0].y * 16 + r[0].x] == 0);
+    for (int i = 0; i < 4; ++i) assert(page.pack(7, 7, extra));
+}
+
+void test_reclaim() {
+    resources::atlas_page page(16, 16, resources::texture_format::r8);
+    resources::atlas_rect a, b, c, d;
+    assert(page.pack(3, 3, a) && page.pack(3, 3, b) && page.pack(3, 3, c));
+    assert(page.pack(10, 5, d)); // second shelf
+    assert(d.y == 4);
+
+    // b gone: its gap is free at the first shelf's height, the second shelf
+    // is empty and goes back to the cursor
+    page.reclaim({a, c});
+    assert(page.free_rect_count() == 2);
+    resources::atlas_rect r;
+    assert(page.pack(3, 3, r) && r.x == b.x && r.y == b.y);
+    assert(page.pack(10, 5, r) && r.y == 4);
+
+    // nothing left: packing starts over
+    page.reclaim({});
+    assert(page.free_rect_count() == 0);
+    assert(page.pack(15, 3, r) && r.x == 0 && r.y == 0);
+}
+
+// a pair of fonts at one size, on a shared atlas when one is given; glyphs
+// are packed as soon as they are asked for
+struct font_pair {
+    std::shared_ptr<resources::font> base, other;
+};
+
+bool load_pair(const char* base_path, const char* other_path, std::shared_ptr<resources::glyph_atlas> atlas,
+               resources::texture_dict* dict, float size, font_pair& out) {
+    out.base = std::make_shared<resources::font>(base_path, size);
+    out.other = std::make_shared<resources::font>(other_path, size);
+    for (auto* f : {out.base.get(), out.other.get()}) {
+        if (atlas) f->set_atlas(atlas);
+        f->set_preload({});
+        f->set_async_glyphs(false);
+        if (!f->load(dict)) return false;
+    }
+    return true;
+}
+
+std::string utf8(uint32_t c) {
+    std::string out;
+    if (c < 0x80) {
+        out += static_cast<char>(c);
+    } else if (c < 0x800) {
+        out += static_cast<char>(0xC0 | (c >> 6));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        out += static_cast<char>(0xE0 | (c >> 12));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (c >> 18));
+        out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return out;
+}
+
+void test_shared_text(const char* base_path, const char* other_path) {
+    // text falling back to the other font for one glyph: three runs on
+    // private atlases, one command when both fonts pack onto the same page
+    for (bool shared : {false, true}) {
+        resources::cpu_texture_dict dict;
+        font_pair fonts;
+        if (!load_pair(base_path, other_path, shared ? std::make_shared<resources::glyph_atlas>() : nullptr, &dict, 24.0f, fonts)) {
+            std::cout << "skipping shared atlas text, no fonts at " << base_path << " and " << other_path << std::endl;
+            return;
+        }
+        uint32_t only_other = 0;
+        for (uint32_t c = 0x21; c < 0x30000 && !only_other; ++c) {
+            if (fonts.other->covers(c) && !fonts.base->covers(c)) only_other = c;
+        }
+        if (!only_other) {
+            std::cout << "skipping shared atlas text, " << other_path << " adds no glyphs" << std::endl;
+            return;
+        }
+        fonts.base->add_fallback(fonts.other);
+
+        core::draw_buffer buf;
+        buf.push_font(fonts.base);
+        buf.text("a" + utf8(only_other) + "b", {0.0f, 0.0f}, 0xffffffffu);
+        size_t runs = 0;
+        for (const auto& cmd : buf.cmds) runs += cmd.type == core::geometry_type::font_atlas;
+        assert(runs == (shared ? 1u : 3u));
+        assert(buf.indices.size() == 3 * 6);
+    }
+}
+
+void test_shared_eviction(const char* base_path, const char* other_path) {
+    // one small page for both fonts: the second font's new glyphs take the
+    // space of the first font's, drawn a frame earlier
+    resources::cpu_texture_dict dict;
+    auto atlas = std::make_shared<resources::glyph_atlas>(64, 64);
+    atlas->set_budget(64 * 64);
+    font_pair fonts;
+    if (!load_pair(base_path, other_path, atlas, &dict, 24.0f, fonts)) {
+        std::cout << "skipping shared atlas eviction, no fonts" << std::endl;
+        return;
+    }
+    const std::string first = "abcdefgh";
+    for (char c : first) assert(fonts.base->ensure_glyph(c) && fonts.base->use_glyph(c));
+    fonts.base->flush_atlas();
+    assert(atlas->pages().size() == 1 && atlas->evicted_count() == 0);
+
+    std::string second;
+    for (char c = 'A'; c <= 'Z' && atlas->evicted_count() == 0; ++c) {
+        assert(fonts.other->ensure_glyph(c) && fonts.other->use_glyph(c));
+        second += c;
+    }
+    assert(atlas->pages().size() == 1 && atlas->evicted_count() > 0);
+    size_t gone = 0;
+    for (char c : first) gone += fonts.base->get_glyph_page(c) < 0;
+    assert(gone == atlas->evicted_count());
+    for (char c : second) assert(fonts.other->get_glyph_page(c) == 0);
+}
+
+void test_shared_destroy(const char* base_path, const char* other_path) {
+    // a font going away gives back its own rectangles; the other font's
+    // glyphs keep their place and pixels
+    resources::cpu_texture_dict dict;
+    auto atlas = std::make_shared<resources::glyph_atlas>();
+    font_pair fonts;
+    if (!load_pair(base_path, other_path, atlas, &dict, 24.0f, fonts)) {
+        std::cout << "skipping shared atlas destroy, no fonts" << std::endl;
+        return;
+    }
+    for (char c : std::string("abc")) assert(fonts.base->ensure_glyph(c));
+    for (char c : std::string("xyzw")) assert(fonts.other->ensure_glyph(c));
+    auto& page = atlas->pages()[0];
+    assert(atlas->fonts().size() == 2 && page.free_rect_count() == 0);
+
+    const resources::glyph_info kept = *fonts.base->use_glyph('a');
+    auto ink = [&](const resources::glyph_info& g) {
+        std::vector<unsigned char> px;
+        const int x = static_cast<int>(g.u0 * page.width() + 0.5f);
+        const int y = static_cast<int>(g.v0 * page.height() + 0.5f);
+        for (int j = 0; j < g.height; ++j) {
+            const unsigned char* row = page.pixels().data() + static_cast<size_t>(y + j) * page.width() * page.bytes_per_pixel();
+            px.insert(px.end(), row + x * page.bytes_per_pixel(), row + (x + g.width) * page.bytes_per_pixel());
+        }
+        return px;
+    };
+    const auto before = ink(kept);
+    const resources::glyph_info dropped = *fonts.other->use_glyph('x');
+    assert(!ink(dropped).empty());
+
+    fonts.other.reset();
+    assert(atlas->fonts().size() == 1 && page.free_rect_count() == 4);
+    const auto cleared = ink(dropped);
+    assert(std::all_of(cleared.begin(), cleared.end(), [](unsigned char v) { return v == 0; }));
+    for (char c : std::string("abc")) assert(fonts.base->get_glyph_page(c) == 0);
+    const resources::glyph_info now = *fonts.base->use_glyph('a');
+    assert(now.u0 == kept.u0 && now.v0 == kept.v0 && ink(now) == before);
+}
+
+int main(int argc, char** argv) {
+    resources::atlas_cache::set_enabled(false);
+    test_dirty_upload();
+    test_r8_page();
+    test_page_full();
+    test_release_reuse();
+    test_reclaim();
+    const char* base = argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf";
+    const char* other = argc > 2 ? argv[2] : "resources/fonts/NotoSansSC-VariableFont_wght.ttf";
+    test_shared_text(base, other);
+    test_shared_eviction(base, other);
+    test_shared_destroy(base, other);
+    std::cout << "Glyph atlas tests completed." << std::endl;
+    return 0;
+}
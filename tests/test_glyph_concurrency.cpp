@@ -0,0 +1,135 @@
+#include "../resources/atlas_cache.h"
+#include "../resources/font.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// latin-1 and latin extended-a: more than one budgeted page at this size
+std::vector<uint32_t> test_codepoints(const resources::font& font) {
+    std::vector<uint32_t> codepoints;
+    for (uint32_t c = 0x21; c < 0x180; ++c) {
+        if (font.covers(c)) codepoints.push_back(c);
+    }
+    return codepoints;
+}
+
+// what draw_buffer::text does per glyph, on several threads at once. each pass
+// is one run tagged with the frame it started in, like a text command: while
+// the atlas is valid since that frame, every glyph the run drew is still where
+// it was sampled from; otherwise the renderer skips the run
+void record(resources::font& font, const std::vector<uint32_t>& codepoints, int seed, std::atomic<size_t>& drawn) {
+    struct drawn_glyph {
+        uint32_t codepoint;
+        int page;
+        float u0, v0;
+    };
+    std::vector<drawn_glyph> run;
+    resources::glyph_reader reader;
+    float x = 0.0f;
+    for (int pass = 0; pass < 20; ++pass) {
+        font.pack_ready_glyphs();
+        const uint32_t run_frame = font.frame();
+        run.clear();
+        uint32_t prev = 0;
+        for (size_t i = 0; i < codepoints.size(); ++i) {
+            const uint32_t c = codepoints[(i * 7 + seed * 13 + pass) % codepoints.size()];
+            const resources::glyph_info* glyph = reader.use(font, c);
+            if (!glyph) {
+                reader.unlock();
+                if (font.ensure_glyph_async(c) == resources::glyph_status::ready) glyph = reader.use(font, c);
+            }
+            if (glyph) {
+                assert(glyph->codepoint == c && glyph->page >= 0 && glyph->page < font.page_count());
+                run.push_back({c, glyph->page, glyph->u0, glyph->v0});
+                ++drawn;
+            }
+            if (prev) x += font.get_kerning(prev, c);
+            x += font.advance(c);
+            assert(!font.resolve_fallback(0x4E00)); // no chain: a cached miss
+            prev = c;
+        }
+        reader.unlock();
+
+        // the table stays locked from the lookups to the check, so nothing is
+        // evicted in between
+        bool in_place = true;
+        for (const auto& g : run) {
+            const resources::glyph_info* now = reader.use(font, g.codepoint);
+            in_place = in_place && now && now->page == g.page && now->u0 == g.u0 && now->v0 == g.v0;
+        }
+        assert(in_place || !font.atlas_valid_since(run_frame));
+        reader.unlock();
+    }
+    assert(x > 0.0f);
+}
+
+void test_concurrent_recording(const char* path) {
+    resources::font font(path, 160.0f);
+    font.set_atlas_budget(static_cast<size_t>(resources::glyph_atlas::PAGE_SIZE) * resources::glyph_atlas::PAGE_SIZE);
+    if (!font.load()) return;
+    const auto codepoints = test_codepoints(font);
+
+    // a render thread ends frames meanwhile, so old glyphs become evictable
+    std::atomic<bool> done{false};
+    std::thread flusher([&] {
+        while (!done) {
+            font.flush_atlas();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::atomic<size_t> drawn{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] { record(font, codepoints, t, drawn); });
+    }
+    for (auto& thread : threads) thread.join();
+    done = true;
+    flusher.join();
+    assert(drawn > 0);
+
+    // the table is consistent: no two glyphs on the same texels. the one page
+    // budget is soft, a page is added while every resident glyph was drawn in
+    // the current frame, which recording threads overlapping a flush cause;
+    // the set fits two pages unbudgeted, so growth stays small
+    while (font.has_pending_glyphs()) {
+        font.pack_ready_glyphs();
+        std::this_thread::yield();
+    }
+    assert(font.page_count() >= 1 && font.page_count() <= 4);
+    std::vector<const resources::glyph_info*> glyphs;
+    for (const auto& [key, glyph] : font.glyphs()) glyphs.push_back(&glyph);
+    for (size_t i = 0; i < glyphs.size(); ++i) {
+        for (size_t j = i + 1; j < glyphs.size(); ++j) {
+            const auto& a = *glyphs[i];
+            const auto& b = *glyphs[j];
+            const bool apart = a.page != b.page || a.u1 <= b.u0 || b.u1 <= a.u0 || a.v1 <= b.v0 || b.v1 <= a.v0;
+            assert(apart || a.width == 0 || b.width == 0);
+        }
+    }
+
+    // layout caches filled concurrently agree with a fresh font
+    resources::font fresh(path, 160.0f);
+    assert(fresh.load());
+    for (uint32_t c : codepoints) {
+        assert(font.advance(c) == fresh.advance(c));
+        assert(font.get_kerning('A', c) == fresh.get_kerning('A', c));
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf";
+    resources::atlas_cache::set_enabled(false);
+    {
+        resources::font probe(path, 16.0f);
+        if (!probe.load()) {
+            std::cout << "skipping glyph concurrency tests, no font at " << path << std::endl;
+            return 0;
+        }
+    }
+    test_concurrent_recording(path);
+    std::cout << "Glyph concurrency tests completed." << std::endl;
+    return 0;
+}
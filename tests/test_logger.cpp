@@ -1,6 +1,13 @@
 #include "../utils/logger.h"
 #include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 void test_logger() {
     // These should print to stdout; visually inspect output
@@ -14,8 +21,125 @@ void test_logger() {
     utils::log_debug("Debug: %c", 'A');
 }
 
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+size_t count(const std::string& text, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) ++n;
+    return n;
+}
+
+// adds up the numbers logged between prefix and suffix, e.g. repeat counts
+size_t sum_counts(const std::string& text, const std::string& prefix, const std::string& suffix) {
+    size_t total = 0;
+    for (size_t pos = text.find(prefix); pos != std::string::npos; pos = text.find(prefix, pos + 1)) {
+        const size_t begin = pos + prefix.size();
+        const size_t end = text.find_first_not_of("0123456789", begin);
+        if (end != begin && end != std::string::npos && text.compare(end, suffix.size(), suffix) == 0) {
+            total += std::stoul(text.substr(begin, end - begin));
+        }
+    }
+    return total;
+}
+
+void test_file_dedup_and_limit() {
+    const std::string path = "test_logger.log";
+    std::remove(path.c_str());
+    assert(utils::set_log_file(path, 0));
+
+    // one site, one message: written once plus the repeat count
+    for (int i = 0; i < 50; ++i) utils::log_warn("glyph U+%04X missing", 0x4E00);
+    // one site, different messages: the rate limit keeps 20 of them
+    for (int i = 0; i < 100; ++i) utils::log_info("limited %d", i);
+    utils::flush_log();
+
+    // windows are wall clock seconds and a loop may straddle one boundary:
+    // then the site starts over once, but nothing goes unaccounted for
+    const std::string log = read_file(path);
+    const size_t missing = count(log, "glyph U+4E00 missing");
+    const size_t repeated = sum_counts(log, "(previous message repeated ", " times)");
+    assert(missing >= 1 && missing <= 2 && repeated > 0);
+    assert(missing + repeated == 50);
+    const size_t limited = count(log, "] [INFO] limited ");
+    const size_t suppressed = sum_counts(log, "] [WARN] ", " more messages like \"limited %d\" suppressed");
+    assert(limited >= 20 && limited <= 40 && suppressed > 0);
+    assert(limited + suppressed == 100);
+    assert(log.find("\033[") == std::string::npos); // no colors in files
+    utils::set_log_file("");
+    std::remove(path.c_str());
+}
+
+void test_threads() {
+    const std::string path = "test_logger_threads.log";
+    std::remove(path.c_str());
+    assert(utils::set_log_file(path, 0));
+    utils::set_log_rate_limit(0);
+
+    // several producers, nothing lost or torn as long as the queue keeps up
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 100; ++i) {
+                utils::log_info("thread %d message %d", t, i);
+                if (i % 25 == 24) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    utils::flush_log();
+    const std::string log = read_file(path);
+    const size_t lines = count(log, "] [INFO] thread ");
+    assert(lines + utils::dropped_log_messages() >= 400 && lines <= 400);
+    assert(log.find("thread 3 message 99\n") != std::string::npos || utils::dropped_log_messages() > 0);
+    utils::set_log_file("");
+    utils::set_log_rate_limit(20);
+    std::remove(path.c_str());
+}
+
+void test_rotation() {
+    const std::string path = "test_logger_rotate.log";
+    for (const char* suffix : {"", ".1", ".2", ".3"}) std::remove((path + suffix).c_str());
+    assert(utils::set_log_file(path, 256, 2));
+    utils::set_log_rate_limit(0);
+    for (int i = 0; i < 40; ++i) utils::log_info("rotation line %02d", i);
+    utils::flush_log();
+    utils::set_log_file("");
+    utils::set_log_rate_limit(20);
+
+    // the newest lines are in the file itself, older ones in .1 and .2 only
+    assert(std::filesystem::exists(path) && std::filesystem::exists(path + ".1") && std::filesystem::exists(path + ".2"));
+    assert(!std::filesystem::exists(path + ".3"));
+    assert(std::filesystem::file_size(path + ".1") >= 256);
+    assert(read_file(path).find("rotation line 39") != std::string::npos || read_file(path).empty());
+    assert(read_file(path + ".1").find("rotation line 00") == std::string::npos);
+    for (const char* suffix : {"", ".1", ".2"}) std::remove((path + suffix).c_str());
+}
+
+void test_sync() {
+    // synchronous mode writes before returning
+    const std::string path = "test_logger_sync.log";
+    std::remove(path.c_str());
+    assert(utils::set_log_file(path, 0));
+    utils::set_log_async(false);
+    utils::log_error("written at once");
+    utils::set_log_async(true);
+    assert(read_file(path).find("written at once") != std::string::npos);
+    utils::set_log_file("");
+    std::remove(path.c_str());
+}
+
 int main() {
     test_logger();
+    test_file_dedup_and_limit();
+    test_threads();
+    test_rotation();
+    test_sync();
+    utils::flush_log();
     std::cout << "Logger tests completed. (Check output above)" << std::endl;
     return 0;
-} 
\ No newline at end of file
+}
@@ -0,0 +1,128 @@
+#include "../core/draw_manager.h"
+#include "../core/frame_merge.h"
+#include "../utils/mpsc_queue.h"
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+void test_fifo() {
+    utils::mpsc_queue<std::unique_ptr<int>> queue;
+    assert(queue.empty() && !queue.pop());
+    for (int i = 0; i < 5; ++i) queue.push(std::make_unique<int>(i));
+    for (int i = 0; i < 5; ++i) {
+        auto v = queue.pop();
+        assert(v && **v == i);
+    }
+    assert(queue.empty());
+
+    // whatever is left is destroyed with the queue
+    auto shared = std::make_shared<int>(1);
+    {
+        utils::mpsc_queue<std::shared_ptr<int>> q;
+        q.push(shared);
+        q.push(shared);
+        assert(shared.use_count() == 3);
+    }
+    assert(shared.use_count() == 1);
+}
+
+void test_producers() {
+    // every item arrives once, each producer's in the order it pushed them,
+    // while the consumer drains concurrently
+    constexpr int PRODUCERS = 4;
+    constexpr int ITEMS = 20000;
+    utils::mpsc_queue<std::pair<int, int>> queue;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS; ++i) queue.push({p, i});
+        });
+    }
+    std::vector<int> next(PRODUCERS, 0);
+    int received = 0;
+    while (received < PRODUCERS * ITEMS) {
+        auto item = queue.pop();
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        assert(item->second == next[item->first]);
+        ++next[item->first];
+        ++received;
+    }
+    for (auto& t : threads) t.join();
+    assert(queue.empty());
+}
+
+void add_triangle(core::draw_buffer& buf, float x, uint32_t col) {
+    const uint32_t base = static_cast<uint32_t>(buf.vertices.size());
+    buf.vertices.emplace_back(x, 0.0f, 0.0f, col, 0.0f, 0.0f);
+    buf.vertices.emplace_back(x + 1, 0.0f, 0.0f, col, 1.0f, 0.0f);
+    buf.vertices.emplace_back(x + 1, 1.0f, 0.0f, col, 1.0f, 1.0f);
+    for (uint32_t i : {0u, 1u, 2u}) buf.indices.push_back(base + i);
+    auto& cmd = buf.cmds.emplace_back();
+    cmd.elem_count = 3;
+}
+
+void test_packets() {
+    // the draw manager's model: producers record into buffers they own and
+    // submit immutable packets; the render thread keeps the latest per buffer
+    core::buffer_registry<core::frame_packet> buffers;
+    std::vector<core::buffer_id> ids;
+    for (size_t p = 0; p < 3; ++p) ids.push_back(buffers.add(p));
+    struct submission {
+        core::buffer_id buffer;
+        core::frame_packet packet;
+    };
+    utils::mpsc_queue<submission> queue;
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < ids.size(); ++p) {
+        producers.emplace_back([&, p] {
+            for (int frame = 0; frame < 100; ++frame) {
+                core::draw_buffer buf;
+                for (int q = 0; q <= frame % 4; ++q) add_triangle(buf, float(q), 0xff000000u | uint32_t(p));
+                queue.push({ids[p], std::make_shared<const core::draw_buffer>(std::move(buf))});
+            }
+        });
+    }
+
+    core::draw_buffer frame;
+    auto drain = [&] {
+        while (auto s = queue.pop()) {
+            if (auto* slot = buffers.get(s->buffer)) *slot = std::move(s->packet);
+        }
+        std::vector<const core::draw_buffer*> sources;
+        buffers.for_each([&](core::buffer_id, const core::frame_packet& packet) {
+            if (packet) sources.push_back(packet.get());
+        });
+        assert(core::merge_buffers(sources, frame));
+        // packets are whole: every buffer contributes complete triangles
+        assert(frame.indices.size() == frame.vertices.size() && frame.indices.size() % 3 == 0);
+    };
+    // frames drawn while the producers are still submitting
+    for (int i = 0; i < 50; ++i) {
+        drain();
+        std::this_thread::yield();
+    }
+    for (auto& t : producers) t.join();
+    drain();
+    // the last packet of each producer had 99 % 4 + 1 = 4 triangles
+    assert(frame.cmds.size() == 3 * 4 && frame.vertices.size() == 3 * 4 * 3);
+
+    // packets for a removed buffer are dropped, the handle being stale
+    buffers.remove(ids[1]);
+    queue.push({ids[1], std::make_shared<const core::draw_buffer>()});
+    drain();
+    assert(frame.cmds.size() == 2 * 4);
+}
+
+int main() {
+    test_fifo();
+    test_producers();
+    test_packets();
+    std::cout << "MPSC queue tests completed." << std::endl;
+    return 0;
+}
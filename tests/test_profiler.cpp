@@ -0,0 +1,129 @@
+#include "../utils/profiler.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using utils::profiler;
+
+void spin(int us) {
+    const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+const profiler::scope_stats* find(const std::vector<profiler::scope_stats>& scopes, const char* name) {
+    for (const auto& s : scopes) {
+        if (std::strcmp(s.name, name) == 0) return &s;
+    }
+    return nullptr;
+}
+
+void test_disabled() {
+    auto& p = profiler::shared();
+    p.clear();
+    {
+        FV_PROFILE_SCOPE("ignored");
+    }
+    // end_frame does nothing while profiling is off
+    p.end_frame();
+    assert(p.frame_count() == 0);
+}
+
+void test_nesting() {
+    auto& p = profiler::shared();
+    p.clear();
+    p.set_enabled(true);
+    {
+        FV_PROFILE_SCOPE("outer");
+        spin(2000);
+        for (int i = 0; i < 3; ++i) {
+            FV_PROFILE_SCOPE("inner");
+            spin(1000);
+        }
+    }
+    p.end_frame();
+
+    const auto f = p.get_frame();
+    assert(f.events.size() == 4);
+    assert(std::strcmp(f.events[0].name, "outer") == 0 && f.events[0].depth == 0);
+    assert(f.events[1].depth == 1 && f.events[1].start_ns >= f.events[0].start_ns);
+
+    const auto scopes = p.frame_scopes();
+    const auto* outer = find(scopes, "outer");
+    const auto* inner = find(scopes, "inner");
+    assert(outer && inner && outer == &scopes[0]);
+    assert(outer->calls == 1 && inner->calls == 3);
+    assert(inner->total_ns >= 3000000 && inner->self_ns == inner->total_ns);
+    assert(outer->self_ns + inner->total_ns == outer->total_ns);
+    assert(outer->self_ns >= 2000000);
+}
+
+void test_threads_and_window() {
+    auto& p = profiler::shared();
+    p.clear();
+    p.set_frame_window(3);
+    std::thread worker([] {
+        profiler::shared().set_thread_name("worker \"a\"");
+        FV_PROFILE_SCOPE("worker");
+        spin(100);
+    });
+    worker.join();
+    p.end_frame();
+    assert(find(p.frame_scopes(), "worker"));
+    const uint64_t first = p.get_frame().number;
+
+    for (int i = 0; i < 5; ++i) {
+        FV_PROFILE_SCOPE("frame");
+        p.end_frame();
+    }
+    // only the last three frames are kept
+    assert(p.frame_count() == 3 && p.get_frame(2).number == first + 3 && p.get_frame().number == first + 5);
+    assert(p.get_frame(3).events.empty() && p.get_frame(0).end_ns >= p.get_frame(1).end_ns);
+    assert(p.dropped_events() == 0);
+}
+
+void test_chrome_trace() {
+    auto& p = profiler::shared();
+    p.clear();
+    p.set_frame_window(8);
+    std::thread worker([] {
+        profiler::shared().set_thread_name("trace worker");
+        FV_PROFILE_SCOPE("work");
+    });
+    worker.join();
+    {
+        FV_PROFILE_SCOPE("draw_buffer::text");
+    }
+    p.end_frame();
+
+    const char* path = "test_profiler_trace.json";
+    assert(p.export_chrome_trace(path));
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string json = ss.str();
+    assert(json.find("\"traceEvents\":[") != std::string::npos);
+    assert(json.find("\"name\":\"draw_buffer::text\",\"cat\":\"frameview\",\"ph\":\"X\"") != std::string::npos);
+    assert(json.find("\"name\":\"work\"") != std::string::npos);
+    assert(json.find("\"args\":{\"name\":\"trace worker\"}") != std::string::npos);
+    assert(json.find("worker \\\"a\\\"") != std::string::npos);
+    assert(json.find("\"name\":\"frame ") != std::string::npos);
+    assert(json.substr(json.size() - 4) == "\n]}\n");
+    std::remove(path);
+}
+
+int main() {
+    test_disabled();
+    test_nesting();
+    test_threads_and_window();
+    test_chrome_trace();
+    profiler::shared().set_enabled(false);
+    std::cout << "Profiler tests completed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "../backend/software/software_renderer.h"
+#include "../core/render_stats.h"
+#include "../resources/atlas_cache.h"
+#include "../resources/cpu_texture.h"
+#include "../resources/font.h"
+#include "../resources/glyph_atlas.h"
+#include "../resources/resource_counters.h"
+#include "draw_helpers.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+using backend::software::software_renderer;
+using upload = core::render_stats::upload;
+
+void test_recorder() {
+    auto& counters = resources::resource_counters::shared();
+    resources::cpu_texture_dict dict;
+    auto a = dict.create_texture(4, 4);
+    auto b = dict.create_texture(8, 8, resources::texture_format::r8);
+
+    core::render_stats_recorder recorder;
+    recorder.begin_frame();
+    counters.glyph_hits.fetch_add(3);
+    counters.glyph_misses.fetch_add(1);
+    counters.texture_upload_bytes.fetch_add(100);
+    counters.atlas_upload_bytes.fetch_add(40);
+    recorder.use_texture(a.get());
+    recorder.use_texture(b.get());
+    recorder.use_texture(a.get());
+    recorder.end_frame(&dict);
+
+    const auto& s = recorder.stats();
+    assert(s.frame == 0 && s.glyph_hits == 3 && s.glyph_misses == 1 && s.glyph_rasterizations == 0);
+    // atlas bytes are reported apart from other textures
+    assert(s.uploaded_bytes(upload::glyph_atlas) == 40 && s.uploaded_bytes(upload::textures) == 60);
+    assert(s.total_uploaded_bytes() == 100);
+    assert(s.textures == 2 && s.texture_bytes == 4 * 4 * 4 + 8 * 8);
+    assert(s.resident_texture_bytes == dict.memory_bytes() && s.resident_texture_bytes == 128);
+
+    // counters are per frame
+    recorder.begin_frame();
+    recorder.end_frame();
+    assert(recorder.stats().frame == 1 && recorder.stats().glyph_hits == 0 && recorder.stats().textures == 0);
+    assert(recorder.stats().total_uploaded_bytes() == 0);
+}
+
+void test_json() {
+    core::render_stats s;
+    s.frame = 7;
+    s.draw_calls = 3;
+    s.uploaded_bytes(upload::vertices) = 2048;
+    s.atlas_bytes = 100;
+    s.atlas_used_bytes = 25;
+    const std::string json = s.to_json();
+    assert(json.front() == '{' && json.back() == '}' && json.find('\n') == std::string::npos);
+    assert(json.find("\"frame\":7,") != std::string::npos && json.find("\"draw_calls\":3,") != std::string::npos);
+    assert(json.find("\"uploaded\":{\"vertices\":2048,\"indices\":0,") != std::string::npos);
+    assert(json.find("\"atlas_occupancy\":0.2500") != std::string::npos);
+}
+
+void test_used_area() {
+    resources::atlas_page page(64, 64, resources::texture_format::r8);
+    assert(page.used_area() == 0);
+    resources::atlas_rect a, b;
+    assert(page.pack(10, 10, a) && page.pack(4, 6, b));
+    // the open shelf is as tall as its tallest glyph, gutters included
+    assert(page.used_area() == (11 + 5) * 11);
+    page.release(a);
+    assert(page.used_area() == 5 * 11);
+}
+
+void test_merging() {
+    software_renderer r;
+    r.initialize(16, 16);
+    core::draw_buffer buf;
+    add_quad(buf, 0, 0, 4, 4, 0xff0000ffu);
+    add_quad(buf, 4, 4, 8, 8, 0xff00ff00u);
+    for (int i = 0; i < 2; ++i) add_command(buf, core::geometry_type::color_only, 6);
+    r.begin_frame();
+    r.draw_buffer(&buf);
+    r.end_frame();
+    // same shader, contiguous indices: one draw call
+    const auto& s = r.stats();
+    assert(s.buffers == 1 && s.commands == 2 && s.merged_commands == 1 && s.draw_calls == 1);
+    assert(s.vertices == 8 && s.indices == 12 && s.triangles == 4 && s.pixels == 32);
+    // the software backend reads the buffers in place
+    assert(s.uploaded_bytes(upload::vertices) == 0 && s.buffer_allocations == 0);
+}
+
+void test_glyphs(const char* path) {
+    resources::cpu_texture_dict dict;
+    auto font = std::make_shared<resources::font>(path, 16.0f);
+    font->set_preload({});
+    if (!font->load(&dict)) {
+        std::cout << "no font at " << path << ", skipping glyph stats" << std::endl;
+        return;
+    }
+    software_renderer r;
+    r.initialize(32, 32);
+
+    // first frame: the glyph is rasterized, packed and uploaded
+    r.begin_frame();
+    assert(!font->use_glyph('A'));
+    assert(font->ensure_glyph('A') && font->use_glyph('A'));
+    core::draw_buffer buf;
+    add_quad(buf, 0, 0, 16, 16, 0xffffffffu);
+    auto& cmd = add_command(buf, core::geometry_type::font_atlas, 6);
+    cmd.font = font;
+    cmd.font_texture = true;
+    cmd.texture = font->get_atlas_tex(0);
+    cmd.font_frame = font->frame();
+    r.draw_buffer(&buf);
+    r.end_frame();
+    const auto& s = r.stats();
+    assert(s.glyph_misses == 1 && s.glyph_hits == 1 && s.glyph_rasterizations == 1);
+    assert(s.uploaded_bytes(upload::glyph_atlas) > 0 && s.uploaded_bytes(upload::textures) == 0);
+    assert(s.atlas_pages == 1 && s.atlas_used_bytes > 0 && s.atlas_occupancy() > 0.0f && s.atlas_occupancy() < 1.0f);
+    assert(s.textures == 1 && s.texture_allocations == 0);
+
+    // second frame: cached, nothing to send
+    r.begin_frame();
+    assert(font->use_glyph('A'));
+    cmd.font_frame = font->frame();
+    r.draw_buffer(&buf);
+    r.end_frame();
+    assert(r.stats().glyph_hits == 1 && r.stats().glyph_misses == 0 && r.stats().glyph_rasterizations == 0);
+    assert(r.stats().total_uploaded_bytes() == 0);
+}
+
+int main(int argc, char** argv) {
+    resources::atlas_cache::set_enabled(false);
+    test_recorder();
+    test_json();
+    test_used_area();
+    test_merging();
+    test_glyphs(argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf");
+    std::cout << "Render stats tests completed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "../backend/software/software_renderer.h"
+#include "../core/frame_capture.h"
+#include "../resources/cpu_texture.h"
+#include "draw_helpers.h"
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using backend::software::software_renderer;
+
+constexpr uint32_t RED = 0xff0000ffu;
+constexpr uint32_t BLACK = 0xff000000u;
+
+uint32_t pixel(const software_renderer& r, int x, int y) {
+    return r.pixels()[static_cast<size_t>(y) * r.width() + x];
+}
+
+void test_fill_and_stats() {
+    software_renderer r;
+    r.initialize(16, 16);
+    core::draw_buffer buf;
+    add_quad(buf, 2, 2, 12, 12, RED);
+    add_command(buf, core::geometry_type::color_only, 6);
+
+    r.begin_frame();
+    r.draw_buffer(&buf);
+    r.end_frame();
+    // the diagonal is shared: 100 pixels exactly, none twice
+    assert(r.stats().pixels == 100 && r.stats().triangles == 2);
+    assert(r.stats().commands == 1 && r.stats().buffers == 1 && r.stats().state_changes == 1);
+    assert(pixel(r, 2, 2) == RED && pixel(r, 11, 11) == RED);
+    assert(pixel(r, 1, 1) == BLACK && pixel(r, 12, 12) == BLACK);
+
+    // a new frame starts cleared with fresh counters
+    r.begin_frame();
+    assert(r.stats().pixels == 0 && pixel(r, 5, 5) == BLACK);
+}
+
+void test_shared_edges() {
+    // a fan around the center: blending half white twice would show
+    software_renderer r;
+    r.initialize(64, 64);
+    core::draw_buffer buf;
+    const uint32_t col = 0x80ffffffu;
+    buf.vertices.emplace_back(31.7f, 32.3f, 0.0f, col, 0.0f, 0.0f);
+    const int segments = 9;
+    for (int i = 0; i <= segments; ++i) {
+        const float a = 6.2831853f * i / segments;
+        buf.vertices.emplace_back(31.7f + 25.0f * std::cos(a), 32.3f + 25.0f * std::sin(a), 0.0f, col, 0.0f, 0.0f);
+    }
+    for (uint32_t i = 1; i <= segments; ++i) {
+        buf.indices.push_back(0);
+        buf.indices.push_back(i);
+        buf.indices.push_back(i + 1);
+    }
+    add_command(buf, core::geometry_type::color_only, segments * 3);
+    r.begin_frame();
+    r.draw_buffer(&buf);
+    const uint32_t once = pixel(r, 32, 32);
+    assert(once != BLACK);
+    size_t drawn = 0;
+    for (uint32_t p : r.pixels()) {
+        assert(p == BLACK || p == once);
+        drawn += p == once;
+    }
+    assert(drawn == r.stats().pixels);
+}
+
+void test_shaders() {
+    software_renderer r;
+    r.initialize(8, 8);
+    resources::cpu_texture_dict dict;
+    auto green = dict.create_texture(1, 1);
+    const uint8_t green_texel[4] = {0, 255, 0, 255};
+    green->set_data(green_texel, 1, 1);
+    auto coverage = dict.create_texture(1, 1, resources::texture_format::r8);
+    const uint8_t none = 0;
+    coverage->set_data(&none, 1, 1);
+
+    core::draw_buffer buf;
+    add_quad(buf, 0, 0, 4, 8, 0xffffffffu);
+    add_quad(buf, 4, 0, 8, 8, 0xffffffffu);
+    add_quad(buf, 0, 0, 8, 8, 0xffffffffu);
+    auto& textured = add_command(buf, core::geometry_type::textured, 6);
+    textured.native_texture = true;
+    textured.texture = green;
+    add_command(buf, core::geometry_type::color_only, 6);
+    // zero coverage: the glyph quad leaves everything as it was
+    auto& glyphs = add_command(buf, core::geometry_type::font_atlas, 6);
+    glyphs.font_texture = true;
+    glyphs.texture = coverage;
+
+    r.begin_frame();
+    r.draw_buffer(&buf);
+    assert(pixel(r, 1, 4) == 0xff00ff00u && pixel(r, 6, 4) == 0xffffffffu);
+    // texture and generic, color_only, then the page and the font shader
+    assert(r.stats().commands == 3 && r.stats().state_changes == 5);
+    assert(r.stats().draw_calls == 3 && r.stats().merged_commands == 0 && r.stats().textures == 2);
+    assert(r.stats().pixels == 128);
+
+    // indices past the end are refused, not read
+    buf.cmds.back().elem_count = 60;
+    r.begin_frame();
+    r.draw_buffer(&buf);
+    assert(r.stats().commands == 2);
+}
+
+void test_capture() {
+    software_renderer r;
+    r.initialize(16, 16);
+    auto capture = std::make_shared<core::frame_capture>(4);
+    r.set_capture(capture);
+    core::draw_buffer buf;
+    add_quad(buf, 0, 0, 4, 4, RED);
+    add_command(buf, core::geometry_type::color_only, 6);
+    for (int i = 0; i < 2; ++i) {
+        r.begin_frame();
+        r.draw_buffer(&buf);
+        r.end_frame();
+    }
+    const auto frames = capture->frames();
+    assert(frames.size() == 2 && frames[1].buffers.size() == 1);
+    assert(frames[1].buffers[0].vertices.size() == 4 && frames[1].buffers[0].commands[0].elem_count == 6);
+}
+
+int main() {
+    test_fill_and_stats();
+    test_shared_edges();
+    test_shaders();
+    test_capture();
+    std::cout << "Software renderer tests completed." << std::endl;
+    return 0;
+}
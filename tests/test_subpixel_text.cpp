@@ -0,0 +1,134 @@
+#include "../core/draw_buffer.h"
+#include "../resources/atlas_cache.h"
+#include "../resources/cpu_texture.h"
+#include "../resources/font.h"
+#include "../resources/glyph_atlas.h"
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using resources::font;
+
+constexpr int phases = 4;
+
+std::shared_ptr<font> load_font(const char* path, bool async, resources::texture_dict* dict) {
+    auto f = std::make_shared<font>(path, 24.0f);
+    f->set_subpixel_positions(phases);
+    f->set_preload({});
+    f->set_async_glyphs(async);
+    if (!f->load(dict)) return nullptr;
+    return f;
+}
+
+// the variant a quad samples, found by its top left uv
+const resources::glyph_info* drawn_variant(font& f, uint32_t codepoint, const core::vertex& top_left) {
+    for (int phase = 0; phase < phases; ++phase) {
+        const auto* g = f.use_glyph(font::glyph_key(codepoint, phase));
+        if (g && g->u0 == top_left.uv[0] && g->v0 == top_left.uv[1]) return g;
+    }
+    return nullptr;
+}
+
+std::vector<unsigned char> ink(font& f, const resources::glyph_info& g) {
+    const auto& page = f.atlas()->pages()[g.page];
+    std::vector<unsigned char> px;
+    const int x = static_cast<int>(g.u0 * page.width() + 0.5f);
+    const int y = static_cast<int>(g.v0 * page.height() + 0.5f);
+    for (int j = 0; j < g.height; ++j) {
+        const unsigned char* row = page.pixels().data() + static_cast<size_t>(y + j) * page.width() * page.bytes_per_pixel();
+        px.insert(px.end(), row + x * page.bytes_per_pixel(), row + (x + g.width) * page.bytes_per_pixel());
+    }
+    return px;
+}
+
+void test_phase_variant(const std::shared_ptr<font>& font_ptr) {
+    // a quarter pixel right of the grid: the phase 1 variant at the same
+    // whole pixel, rendered from a shifted outline
+    font& f = *font_ptr;
+    core::draw_buffer whole, quarter;
+    whole.push_font(font_ptr);
+    quarter.push_font(font_ptr);
+    whole.text("l", {10.0f, 0.0f}, 0xffffffffu);
+    quarter.text("l", {10.25f, 0.0f}, 0xffffffffu);
+    assert(whole.vertices.size() == 4 && quarter.vertices.size() == 4);
+
+    const auto* base = f.use_glyph(font::glyph_key('l', 0));
+    const auto* shifted = f.use_glyph(font::glyph_key('l', 1));
+    assert(base && shifted && shifted->phase == 1);
+    assert(drawn_variant(f, 'l', whole.vertices[0]) == base);
+    assert(drawn_variant(f, 'l', quarter.vertices[0]) == shifted);
+    assert(shifted->u0 != base->u0 || shifted->v0 != base->v0);
+    assert(ink(f, *shifted) != ink(f, *base));
+    assert(whole.vertices[0].pos[0] == 10.0f + base->bearingX);
+    assert(quarter.vertices[0].pos[0] == 10.0f + shifted->bearingX);
+}
+
+void test_no_drift(const std::shared_ptr<font>& font_ptr) {
+    // fractional advances add up: every glyph of a long run lands within
+    // half a phase of its exact position
+    font& f = *font_ptr;
+    const int count = 200;
+    const float start = 10.0f;
+    core::draw_buffer buf;
+    buf.push_font(font_ptr);
+    buf.text(std::string(count, 'l'), {start, 0.0f}, 0xffffffffu);
+    assert(buf.vertices.size() == count * 4u);
+
+    const double step = double(f.use_glyph('l')->advance) + f.get_kerning('l', 'l');
+    for (int i = 0; i < count; ++i) {
+        const auto* g = drawn_variant(f, 'l', buf.vertices[i * 4]);
+        assert(g);
+        const double placed = buf.vertices[i * 4].pos[0] - g->bearingX + double(g->phase) / phases;
+        assert(std::abs(placed - (start + i * step)) <= 0.5 / phases + 1e-3);
+    }
+}
+
+void test_pending_variant(const char* path) {
+    // with async glyphs the variant rasterizes on a worker; meanwhile the
+    // whole-pixel glyph is drawn at the rounded pen
+    resources::cpu_texture_dict dict;
+    auto f = load_font(path, true, &dict);
+    assert(f);
+    assert(f->ensure_glyph('l'));
+    const auto base = *f->use_glyph('l');
+    const uint32_t key = font::glyph_key('l', 3);
+
+    core::draw_buffer pending;
+    pending.push_font(f);
+    pending.text("l", {10.75f, 0.0f}, 0xffffffffu);
+    assert(pending.vertices.size() == 4);
+    assert(pending.vertices[0].uv[0] == base.u0 && pending.vertices[0].uv[1] == base.v0);
+    assert(pending.vertices[0].pos[0] == 11.0f + base.bearingX);
+
+    for (int i = 0; i < 500 && !f->use_glyph(key); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        f->pack_ready_glyphs();
+    }
+    const auto* variant = f->use_glyph(key);
+    assert(variant);
+    core::draw_buffer ready;
+    ready.push_font(f);
+    ready.text("l", {10.75f, 0.0f}, 0xffffffffu);
+    assert(ready.vertices[0].uv[0] == variant->u0 && ready.vertices[0].pos[0] == 10.0f + variant->bearingX);
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf";
+    resources::atlas_cache::set_enabled(false);
+    resources::cpu_texture_dict dict;
+    auto f = load_font(path, false, &dict);
+    if (!f) {
+        std::cout << "skipping subpixel text tests, no font at " << path << std::endl;
+        return 0;
+    }
+    test_phase_variant(f);
+    test_no_drift(f);
+    test_pending_variant(path);
+    std::cout << "Subpixel text tests completed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "../core/text_layout.h"
+#include "../resources/atlas_cache.h"
+#include "../resources/font.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+void test_wrap(resources::font& font) {
+    const std::string text = "The quick brown fox jumps over the lazy dog. Well-known state-of-the-art.";
+    const float max_width = font.advance('M') * 10.0f;
+    auto lines = core::wrap_text(font, text, max_width);
+    assert(lines.size() > 1);
+    size_t covered = 0;
+    for (const auto& line : lines) {
+        assert(line.width <= max_width);
+        assert(line.begin >= covered && line.end >= line.begin);
+        // lines never start or end with a space
+        if (line.end > line.begin) {
+            assert(text[line.begin] != ' ' && text[line.end - 1] != ' ');
+        }
+        covered = line.end;
+    }
+    assert(covered == text.size());
+
+    // no limit: one line as wide as the advances add up to
+    auto single = core::wrap_text(font, "abc", 0.0f);
+    assert(single.size() == 1);
+    float width = float(font.advance('a') + font.advance('b') + font.advance('c'));
+    width += float(font.get_kerning('a', 'b') + font.get_kerning('b', 'c'));
+    assert(single[0].width == width);
+}
+
+void test_breaks(resources::font& font) {
+    // hard breaks, including an empty paragraph and crlf
+    auto lines = core::wrap_text(font, "one\n\ntwo\r\nthree  ", 0.0f);
+    assert(lines.size() == 4);
+    assert(lines[1].begin == lines[1].end && lines[1].width == 0.0f);
+    assert(lines[3].end == lines[3].begin + 5); // trailing spaces dropped
+
+    // a word wider than the box is split between characters
+    const float narrow = font.advance('x') * 3.5f;
+    auto split = core::wrap_text(font, "xxxxxxxxxx", narrow);
+    assert(split.size() == 4);
+    for (const auto& line : split) assert(line.width <= narrow);
+
+    auto extent = core::measure_text(font, "hello\nworld");
+    assert(extent.lines == 2);
+    assert(extent.height == 2 * font.metrics().line_height);
+    assert(core::measure_text(font, "").lines == 0);
+}
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf";
+    resources::atlas_cache::set_enabled(false);
+    resources::font font(path, 16.0f);
+    if (!font.load()) {
+        std::cout << "skipping text layout tests, no font at " << path << std::endl;
+        return 0;
+    }
+    test_wrap(font);
+    test_breaks(font);
+    std::cout << "Text layout tests completed." << std::endl;
+    return 0;
+}
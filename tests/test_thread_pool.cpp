@@ -0,0 +1,66 @@
+#include "../utils/thread_pool.h"
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+void test_submit() {
+    utils::thread_pool pool(4);
+    assert(pool.size() == 4);
+    std::atomic<int> count{0};
+    for (int i = 0; i < 1000; ++i) {
+        pool.submit([&count]() { count++; });
+    }
+    pool.wait_idle();
+    assert(count == 1000);
+}
+
+void test_async() {
+    utils::thread_pool pool(2);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 16; ++i) {
+        results.push_back(pool.async([i]() { return i * i; }));
+    }
+    for (int i = 0; i < 16; ++i) {
+        assert(results[i].get() == i * i);
+    }
+
+    // exceptions reach the caller through the future
+    auto failing = pool.async([]() -> int { throw std::runtime_error("boom"); });
+    bool thrown = false;
+    try {
+        failing.get();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void test_drain_on_destroy() {
+    std::atomic<int> count{0};
+    {
+        utils::thread_pool pool(1);
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&count]() { count++; });
+        }
+    }
+    assert(count == 100);
+}
+
+void test_in_worker() {
+    utils::thread_pool pool(2);
+    utils::thread_pool other(1);
+    assert(!pool.in_worker());
+    assert(pool.async([&pool]() { return pool.in_worker(); }).get());
+    assert(!pool.async([&other]() { return other.in_worker(); }).get());
+}
+
+int main() {
+    test_submit();
+    test_async();
+    test_drain_on_destroy();
+    test_in_worker();
+    std::cout << "Thread pool tests completed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "../utils/utf8.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+
+void test_lengths() {
+    const std::string text = "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"; // A é € 😀
+    auto cps = utils::decode_utf8(text);
+    assert(cps.size() == 4);
+    assert(cps[0] == 'A');
+    assert(cps[1] == 0xE9);
+    assert(cps[2] == 0x20AC);
+    assert(cps[3] == 0x1F600);
+
+    uint32_t cp = 0;
+    const char* four = text.c_str() + 6;
+    assert(utils::decode_utf8(four, four + 4, cp) == 4 && cp == 0x1F600);
+}
+
+void test_invalid() {
+    // stray continuation byte and a truncated sequence are skipped
+    auto cps = utils::decode_utf8(std::string("\x80" "a" "\xE2\x82"));
+    assert(cps.size() == 1 && cps[0] == 'a');
+
+    uint32_t cp = 0;
+    const char bad[] = "\xC3\x41";
+    assert(utils::decode_utf8(bad, bad + 2, cp) == 0);
+}
+
+int main() {
+    test_lengths();
+    test_invalid();
+    std::cout << "UTF-8 tests completed." << std::endl;
+    return 0;
+}
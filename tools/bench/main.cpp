@@ -0,0 +1,348 @@
+// frameview_bench: microbenchmarks for draw_buffer primitives, text, glyph
+// rasterization, the atlas packer and frame merging. reports ns/op,
+// vertices/s and heap allocations/op, optionally as json for tracking
+// regressions
+//
+//   frameview_bench [--font path] [--cjk-font path] [--filter substr]
+//                   [--min-time ms] [--json path|-]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#include "../../core/draw_buffer.h"
+#include "../../core/frame_merge.h"
+#include "../../resources/atlas_cache.h"
+#include "../../resources/cpu_texture.h"
+#include "../../resources/font.h"
+#include "../../resources/glyph_atlas.h"
+#include "../../utils/logger.h"
+#include "../../utils/utf8.h"
+
+// every heap allocation in the process is counted, so allocs/op includes the
+// temporaries a primitive builds, not only the buffer's own growth
+namespace {
+std::atomic<size_t> g_allocations{0};
+
+void* counted_alloc(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* counted_alloc(size_t size, std::align_val_t align) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t alignment = static_cast<size_t>(align);
+#ifdef _MSC_VER
+    if (void* p = _aligned_malloc(size ? size : 1, alignment)) return p;
+#else
+    // aligned_alloc takes whole multiples of the alignment
+    const size_t rounded = std::max<size_t>(alignment, (size + alignment - 1) / alignment * alignment);
+    if (void* p = std::aligned_alloc(alignment, rounded)) return p;
+#endif
+    throw std::bad_alloc();
+}
+
+void counted_free(void* p) noexcept { std::free(p); }
+
+void counted_free(void* p, std::align_val_t) noexcept {
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+} // namespace
+
+// every new goes through malloc (or its aligned form) and every delete,
+// sized or not, through the matching free
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void* operator new(size_t size, std::align_val_t align) { return counted_alloc(size, align); }
+void* operator new[](size_t size, std::align_val_t align) { return counted_alloc(size, align); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, size_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::align_val_t align) noexcept { counted_free(p, align); }
+void operator delete[](void* p, std::align_val_t align) noexcept { counted_free(p, align); }
+void operator delete(void* p, size_t, std::align_val_t align) noexcept { counted_free(p, align); }
+void operator delete[](void* p, size_t, std::align_val_t align) noexcept { counted_free(p, align); }
+
+namespace {
+
+struct options {
+    std::string font = "resources/fonts/NotoSans-VariableFont_wdth,wght.ttf";
+    std::string cjk_font = "resources/fonts/NotoSansSC-VariableFont_wght.ttf";
+    std::string filter;
+    std::string json; // "-" for stdout
+    double min_time_ms = 200.0;
+};
+
+struct result {
+    std::string name;
+    uint64_t ops = 0;
+    double ns_per_op = 0.0;
+    double vertices_per_s = 0.0;
+    double allocs_per_op = 0.0;
+};
+
+// a case runs batches of ops until min_time of measured time has passed.
+// setup runs before every batch, untimed; body runs one op and returns the
+// vertices it produced
+struct bench_case {
+    std::string name;
+    uint64_t batch = 1;
+    std::function<void()> setup;
+    std::function<size_t(uint64_t)> body;
+};
+
+result run(const bench_case& bc, double min_time_ms) {
+    using clock = std::chrono::steady_clock;
+    result r;
+    r.name = bc.name;
+    double elapsed_ns = 0.0;
+    size_t vertices = 0, allocations = 0;
+    // one untimed batch first: caches, lazily built tables, buffer capacity
+    if (bc.setup) bc.setup();
+    for (uint64_t i = 0; i < bc.batch; ++i) bc.body(i);
+    while (elapsed_ns < min_time_ms * 1e6) {
+        if (bc.setup) bc.setup();
+        const size_t allocs_before = g_allocations.load(std::memory_order_relaxed);
+        const auto start = clock::now();
+        for (uint64_t i = 0; i < bc.batch; ++i) vertices += bc.body(r.ops + i);
+        const auto end = clock::now();
+        allocations += g_allocations.load(std::memory_order_relaxed) - allocs_before;
+        elapsed_ns += std::chrono::duration<double, std::nano>(end - start).count();
+        r.ops += bc.batch;
+    }
+    r.ns_per_op = elapsed_ns / r.ops;
+    r.vertices_per_s = vertices / (elapsed_ns * 1e-9);
+    r.allocs_per_op = static_cast<double>(allocations) / r.ops;
+    return r;
+}
+
+// pages get cpu textures, as a headless app would have
+resources::cpu_texture_dict g_textures;
+
+std::shared_ptr<resources::font> load_font(const std::string& path, float size, std::vector<uint32_t> preload = {}) {
+    auto font = std::make_shared<resources::font>(path.c_str(), size);
+    font->set_async_glyphs(false); // glyphs are ready when text() returns, no timing noise from workers
+    if (!preload.empty()) font->set_preload(std::move(preload));
+    if (!font->load(&g_textures)) return nullptr;
+    return font;
+}
+
+// geometry cases append to one buffer, cleared (keeping capacity) per batch
+void add_geometry_cases(std::vector<bench_case>& cases, core::draw_buffer& buf) {
+    const auto clear = [&buf] { buf.clear_all(); };
+    const core::color col(0.2f, 0.4f, 0.8f, 1.0f);
+    cases.push_back({"prim_rect_filled", 1024, clear, [&buf, col](uint64_t i) {
+        const size_t before = buf.vertices.size();
+        const float x = static_cast<float>(i % 64) * 10.0f;
+        buf.prim_rect_filled({x, 10.0f}, {x + 80.0f, 40.0f}, col);
+        return buf.vertices.size() - before;
+    }});
+    cases.push_back({"prim_rect_filled_rounded", 256, clear, [&buf, col](uint64_t i) {
+        const size_t before = buf.vertices.size();
+        const float x = static_cast<float>(i % 64) * 10.0f;
+        buf.prim_rect_filled({x, 10.0f}, {x + 80.0f, 40.0f}, col, 0.25f);
+        return buf.vertices.size() - before;
+    }});
+    cases.push_back({"circle_filled", 1024, clear, [&buf](uint64_t i) {
+        const size_t before = buf.vertices.size();
+        buf.circle_filled({100.0f + (i % 64), 100.0f}, 40.0f, 0xffffffffu, 0xff0000ffu);
+        return buf.vertices.size() - before;
+    }});
+
+    auto points = std::make_shared<std::vector<core::position>>(100000);
+    for (size_t i = 0; i < points->size(); ++i) {
+        (*points)[i] = {static_cast<float>(i % 1920), 540.0f + 200.0f * std::sin(i * 0.01f)};
+    }
+    cases.push_back({"poly_line_100k", 1, clear, [&buf, points](uint64_t) {
+        const size_t before = buf.vertices.size();
+        buf.poly_line(*points, 0xffffffffu, 1.5f);
+        return buf.vertices.size() - before;
+    }});
+}
+
+void add_text_case(std::vector<bench_case>& cases, core::draw_buffer& buf, const std::string& name,
+                   std::shared_ptr<resources::font> font, std::string str) {
+    cases.push_back({name, 256, [&buf, font] {
+        buf.clear_all();
+        buf.push_font(font);
+    }, [&buf, str = std::move(str)](uint64_t i) {
+        const size_t before = buf.vertices.size();
+        buf.text(str, {10.0f, 10.0f + (i % 32) * 20.0f}, 0xffffffffu);
+        return buf.vertices.size() - before;
+    }});
+}
+
+// glyphs a face covers from first on, up to count
+std::vector<uint32_t> covered(const resources::font& font, uint32_t first, size_t count) {
+    std::vector<uint32_t> out;
+    for (uint32_t c = first; out.size() < count && c < 0x30000; ++c) {
+        if (font.covers(c)) out.push_back(c);
+    }
+    return out;
+}
+
+void add_glyph_cases(std::vector<bench_case>& cases, const std::string& path) {
+    // cold: every op rasterizes and packs a glyph not seen before; a fresh
+    // font per batch, loaded outside the timing
+    auto probe = load_font(path, 32.0f, {' '});
+    if (!probe) return;
+    const auto glyphs = std::make_shared<std::vector<uint32_t>>(covered(*probe, 0x21, 256));
+    const auto cold = std::make_shared<std::shared_ptr<resources::font>>();
+    cases.push_back({"ensure_glyph_cold", glyphs->size(), [path, cold] { *cold = load_font(path, 32.0f, {' '}); },
+                     [glyphs, cold](uint64_t i) {
+                         (*cold)->ensure_glyph((*glyphs)[i % glyphs->size()]);
+                         return size_t(0);
+                     }});
+    cases.push_back({"ensure_glyph_warm", 4096, nullptr, [glyphs, probe](uint64_t i) {
+                         probe->ensure_glyph((*glyphs)[i % glyphs->size()]);
+                         return size_t(0);
+                     }});
+}
+
+void add_packer_case(std::vector<bench_case>& cases) {
+    // glyph-like sizes; the page is reset (untimed) before it can fill up
+    auto sizes = std::make_shared<std::vector<std::pair<int, int>>>();
+    uint32_t seed = 12345;
+    for (int i = 0; i < 1024; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        sizes->emplace_back(6 + (seed >> 8) % 36, 10 + (seed >> 16) % 30);
+    }
+    auto page = std::make_shared<resources::atlas_page>(resources::glyph_atlas::PAGE_SIZE, resources::glyph_atlas::PAGE_SIZE,
+                                                        resources::texture_format::r8);
+    cases.push_back({"atlas_pack", 512, [page] { page->reset(); }, [page, sizes](uint64_t i) {
+                         resources::atlas_rect rect;
+                         const auto& [w, h] = (*sizes)[i % sizes->size()];
+                         page->pack(w, h, rect);
+                         return size_t(0);
+                     }});
+}
+
+void add_merge_case(std::vector<bench_case>& cases) {
+    // a ui frame: many small widget buffers and a few large ones (lists,
+    // plots), merged into a retained frame buffer
+    auto sources = std::make_shared<std::vector<core::draw_buffer>>(512);
+    for (size_t i = 0; i < sources->size(); ++i) {
+        auto& buf = (*sources)[i];
+        const int rects = i % 128 == 0 ? 20000 : 16;
+        for (int r = 0; r < rects; ++r) {
+            const float x = static_cast<float>(r % 100) * 10.0f;
+            buf.prim_rect_filled({x, static_cast<float>(i)}, {x + 8.0f, i + 8.0f}, core::color(0.5f, 0.5f, 0.5f, 1.0f));
+        }
+    }
+    auto buffers = std::make_shared<std::vector<const core::draw_buffer*>>();
+    for (const auto& buf : *sources) buffers->push_back(&buf);
+    auto frame = std::make_shared<core::draw_buffer>();
+    cases.push_back({"merge_buffers", 4, nullptr, [sources, buffers, frame](uint64_t) {
+                         core::merge_buffers(*buffers, *frame);
+                         return frame->vertices.size();
+                     }});
+}
+
+void write_json(FILE* out, const std::vector<result>& results) {
+    std::fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.3f, \"vertices_per_s\": %.1f, \"allocs_per_op\": %.3f}%s\n",
+                     r.name.c_str(), static_cast<unsigned long long>(r.ops), r.ns_per_op, r.vertices_per_s, r.allocs_per_op,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+bool parse_options(int argc, char** argv, options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        if (arg == "--font") {
+            opts.font = argv[++i];
+        } else if (arg == "--cjk-font") {
+            opts.cjk_font = argv[++i];
+        } else if (arg == "--filter") {
+            opts.filter = argv[++i];
+        } else if (arg == "--min-time") {
+            opts.min_time_ms = std::max(1.0, std::atof(argv[++i]));
+        } else if (arg == "--json") {
+            opts.json = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    options opts;
+    if (!parse_options(argc, argv, opts)) {
+        std::fprintf(stderr, "usage: %s [--font path] [--cjk-font path] [--filter substr] [--min-time ms] [--json path|-]\n", argv[0]);
+        return 2;
+    }
+    resources::atlas_cache::set_enabled(false); // cold means cold
+    utils::set_debug_logging(false);
+
+    std::vector<bench_case> cases;
+    core::draw_buffer buf;
+    add_geometry_cases(cases, buf);
+
+    const std::string ascii = "The quick brown fox jumps over the lazy dog. 0123456789";
+    const std::string cjk = "\xE6\x96\x87\xE5\xAD\x97\xE6\xB8\xB2\xE6\x9F\x93\xE6\xB5\x8B\xE8\xAF\x95\xE4\xB8\xAD\xE6\x96\x87\xE5\xAD\x97\xE4\xBD\x93\xE7\xBC\x93\xE5\xAD\x98"; // 文字渲染测试中文字体缓存
+    const std::string mixed = "Frame \xE5\xB8\xA7 time \xE6\x97\xB6\xE9\x97\xB4 12ms \xE6\xAF\xAB\xE7\xA7\x92 draw \xE7\xBB\x98\xE5\x88\xB6"; // latin and han interleaved
+    auto latin = load_font(opts.font, 16.0f);
+    auto han = load_font(opts.cjk_font, 16.0f, utils::decode_utf8(cjk + mixed));
+    if (latin) {
+        add_text_case(cases, buf, "text_ascii", latin, ascii);
+    } else {
+        std::fprintf(stderr, "no font at %s, skipping latin text and glyph cases\n", opts.font.c_str());
+    }
+    if (han) {
+        add_text_case(cases, buf, "text_cjk", han, cjk);
+    } else {
+        std::fprintf(stderr, "no font at %s, skipping cjk and fallback text\n", opts.cjk_font.c_str());
+    }
+    if (latin && han) {
+        // a separate base font, so the ascii case keeps an empty chain
+        auto base = load_font(opts.font, 16.0f);
+        base->add_fallback(han);
+        add_text_case(cases, buf, "text_fallback", base, mixed);
+    }
+    if (latin) add_glyph_cases(cases, opts.font);
+    add_packer_case(cases);
+    add_merge_case(cases);
+
+    // json on stdout moves the table to stderr
+    FILE* table = opts.json == "-" ? stderr : stdout;
+    std::vector<result> results;
+    std::fprintf(table, "%-26s %12s %14s %14s %12s\n", "benchmark", "ops", "ns/op", "vertices/s", "allocs/op");
+    for (const auto& bc : cases) {
+        if (!opts.filter.empty() && bc.name.find(opts.filter) == std::string::npos) continue;
+        const result r = run(bc, opts.min_time_ms);
+        std::fprintf(table, "%-26s %12llu %14.1f %14.0f %12.2f\n", r.name.c_str(), static_cast<unsigned long long>(r.ops), r.ns_per_op,
+                    r.vertices_per_s, r.allocs_per_op);
+        results.push_back(r);
+    }
+
+    if (opts.json == "-") {
+        write_json(stdout, results);
+    } else if (!opts.json.empty()) {
+        FILE* out = std::fopen(opts.json.c_str(), "w");
+        if (!out) {
+            utils::log_error("bench: cannot write '%s'", opts.json.c_str());
+            return 1;
+        }
+        write_json(out, results);
+        std::fclose(out);
+    }
+    return 0;
+}
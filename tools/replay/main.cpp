@@ -0,0 +1,214 @@
+// frameview_replay: replays a frame capture (see core::frame_capture) through
+// the software renderer and reports per-frame cpu time and work
+//
+//   frameview_replay <capture> [--iterations N] [--size WxH] [--quiet] [--trace out.json] [--stats out.jsonl]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../../backend/software/software_renderer.h"
+#include "../../core/frame_capture.h"
+#include "../../resources/cpu_texture.h"
+#include "../../utils/logger.h"
+#include "../../utils/profiler.h"
+
+namespace {
+
+struct options {
+    std::string path;
+    int iterations = 10;
+    int width = 0, height = 0; // from the geometry when not given
+    bool quiet = false;        // totals only
+    std::string trace;         // chrome trace of the last iteration
+    std::string stats;         // render_stats of the last iteration, one json line per frame
+};
+
+bool parse_options(int argc, char** argv, options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            opts.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--size" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &opts.width, &opts.height) != 2 || opts.width <= 0 || opts.height <= 0) return false;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            opts.trace = argv[++i];
+        } else if (arg == "--stats" && i + 1 < argc) {
+            opts.stats = argv[++i];
+        } else if (arg == "--quiet") {
+            opts.quiet = true;
+        } else if (opts.path.empty() && arg[0] != '-') {
+            opts.path = arg;
+        } else {
+            return false;
+        }
+    }
+    return !opts.path.empty();
+}
+
+// the capture's textures as cpu textures; gpu-only ones were not captured and
+// sample as white
+std::vector<resources::tex> load_textures(const core::frame_capture::reader& reader, resources::cpu_texture_dict& dict) {
+    std::vector<resources::tex> textures;
+    std::vector<uint8_t> white;
+    for (const auto& view : reader.textures()) {
+        auto tex = dict.create_texture(view.width, view.height, view.format);
+        const uint8_t* pixels = view.pixels;
+        if (!pixels) {
+            white.assign(static_cast<size_t>(view.width) * view.height * resources::bytes_per_texel(view.format), 0xff);
+            pixels = white.data();
+        }
+        tex->set_data(pixels, view.width, view.height);
+        textures.push_back(std::move(tex));
+    }
+    return textures;
+}
+
+// rebuilds draw_buffers from the mapped records. callbacks cannot be restored;
+// the font's field type goes into the shader hint, as there is no font
+core::draw_buffer make_buffer(const core::frame_capture::reader::buffer_view& view, const std::vector<resources::tex>& textures) {
+    using command = core::frame_capture::command;
+    core::draw_buffer buf;
+    buf.vertices.assign(view.vertices, view.vertices + view.vertex_count);
+    buf.indices.assign(view.indices, view.indices + view.index_count);
+    buf.cmds.reserve(view.command_count);
+    for (uint32_t i = 0; i < view.command_count; ++i) {
+        const command& rec = view.commands[i];
+        core::draw_command& cmd = buf.cmds.emplace_back();
+        cmd.elem_count = rec.elem_count;
+        cmd.type = rec.type;
+        cmd.font_texture = rec.flags & command::font_texture;
+        cmd.native_texture = rec.flags & command::native_texture;
+        cmd.circle_scissor = rec.flags & command::circle_scissor;
+        cmd.blur_strength = rec.blur_strength;
+        cmd.pass_count = rec.pass_count;
+        cmd.clip_rect = core::rect(rec.clip_rect[0], rec.clip_rect[1], rec.clip_rect[2], rec.clip_rect[3]);
+        cmd.circle_outer_clip = core::rect(rec.circle_outer_clip[0], rec.circle_outer_clip[1], rec.circle_outer_clip[2], rec.circle_outer_clip[3]);
+        cmd.key_color = core::color(rec.key_color[0], rec.key_color[1], rec.key_color[2], rec.key_color[3]);
+        if (rec.texture >= 0) cmd.texture = textures[rec.texture];
+        if (rec.flags & command::msdf) {
+            cmd.shader_hint = "msdf";
+        } else if (rec.flags & command::sdf) {
+            cmd.shader_hint = "sdf";
+        } else {
+            cmd.shader_hint.assign(rec.shader_hint, std::find(rec.shader_hint, rec.shader_hint + sizeof(rec.shader_hint), '\0'));
+        }
+    }
+    return buf;
+}
+
+// smallest target holding every vertex, within reason
+void fit_size(const std::vector<std::vector<core::draw_buffer>>& frames, int& width, int& height) {
+    float max_x = 1.0f, max_y = 1.0f;
+    for (const auto& buffers : frames) {
+        for (const auto& buf : buffers) {
+            for (const auto& v : buf.vertices) {
+                if (std::isfinite(v.pos[0])) max_x = std::max(max_x, v.pos[0]);
+                if (std::isfinite(v.pos[1])) max_y = std::max(max_y, v.pos[1]);
+            }
+        }
+    }
+    width = static_cast<int>(std::min(std::ceil(max_x), 8192.0f));
+    height = static_cast<int>(std::min(std::ceil(max_y), 8192.0f));
+}
+
+double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p * (values.size() - 1) + 0.5)];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    options opts;
+    if (!parse_options(argc, argv, opts)) {
+        std::fprintf(stderr, "usage: %s <capture> [--iterations N] [--size WxH] [--quiet] [--trace out.json] [--stats out.jsonl]\n", argv[0]);
+        return 2;
+    }
+
+    core::frame_capture::reader reader;
+    if (!reader.open(opts.path)) {
+        utils::log_error("replay: cannot read capture '%s'", opts.path.c_str());
+        return 1;
+    }
+    resources::cpu_texture_dict dict;
+    const auto textures = load_textures(reader, dict);
+    std::vector<std::vector<core::draw_buffer>> frames;
+    for (const auto& view : reader.frames()) {
+        auto& buffers = frames.emplace_back();
+        for (const auto& buf : view.buffers) buffers.push_back(make_buffer(buf, textures));
+    }
+    if (frames.empty()) {
+        utils::log_error("replay: '%s' holds no frames", opts.path.c_str());
+        return 1;
+    }
+    if (!opts.width) fit_size(frames, opts.width, opts.height);
+
+    backend::software::software_renderer renderer;
+    renderer.initialize(opts.width, opts.height);
+    if (!opts.trace.empty()) {
+        utils::profiler::shared().set_frame_window(frames.size());
+        utils::profiler::shared().set_enabled(true);
+        utils::profiler::shared().set_thread_name("replay");
+    }
+
+    // the work per frame is the same every iteration; only the time varies
+    std::vector<core::render_stats> stats(frames.size());
+    std::vector<std::vector<double>> times(frames.size());
+    for (int it = 0; it < opts.iterations; ++it) {
+        for (size_t f = 0; f < frames.size(); ++f) {
+            const auto start = std::chrono::steady_clock::now();
+            renderer.begin_frame();
+            for (const auto& buf : frames[f]) {
+                if (!buf.vertices.empty() && !buf.indices.empty()) renderer.draw_buffer(&buf);
+            }
+            renderer.end_frame();
+            const auto end = std::chrono::steady_clock::now();
+            times[f].push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            stats[f] = renderer.stats();
+        }
+    }
+
+    if (!opts.trace.empty() && !utils::profiler::shared().export_chrome_trace(opts.trace)) return 1;
+    if (!opts.stats.empty()) {
+        std::ofstream out(opts.stats, std::ios::binary);
+        for (const auto& s : stats) out << s.to_json() << '\n';
+        if (!out) {
+            utils::log_error("replay: cannot write stats '%s'", opts.stats.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("%s: %zu frames, %zu textures, %dx%d, %d iterations\n", opts.path.c_str(), frames.size(),
+                textures.size(), opts.width, opts.height, opts.iterations);
+    if (!opts.quiet) {
+        std::printf("%8s %8s %8s %8s %8s %10s %12s %10s %10s %10s\n", "frame", "buffers", "commands", "calls", "changes",
+                    "triangles", "pixels", "min ms", "median ms", "max ms");
+    }
+    core::render_stats total;
+    std::vector<double> all;
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const auto& s = stats[f];
+        total.buffers += s.buffers;
+        total.commands += s.commands;
+        total.draw_calls += s.draw_calls;
+        total.state_changes += s.state_changes;
+        total.triangles += s.triangles;
+        total.pixels += s.pixels;
+        all.insert(all.end(), times[f].begin(), times[f].end());
+        if (opts.quiet) continue;
+        std::printf("%8llu %8u %8u %8u %8u %10llu %12llu %10.3f %10.3f %10.3f\n",
+                    static_cast<unsigned long long>(reader.frames()[f].number), s.buffers, s.commands, s.draw_calls, s.state_changes,
+                    static_cast<unsigned long long>(s.triangles), static_cast<unsigned long long>(s.pixels),
+                    percentile(times[f], 0.0), percentile(times[f], 0.5), percentile(times[f], 1.0));
+    }
+    const double n = static_cast<double>(frames.size());
+    std::printf("per frame: %.1f commands, %.1f draw calls, %.1f state changes, %.0f triangles, %.0f pixels\n",
+                total.commands / n, total.draw_calls / n, total.state_changes / n, total.triangles / n, total.pixels / n);
+    std::printf("cpu time: median %.3f ms, p95 %.3f ms, max %.3f ms\n", percentile(all, 0.5), percentile(all, 0.95),
+                percentile(all, 1.0));
+    return 0;
+}
@@ -1,18 +1,20 @@
 #include "logger.h"
-#include <iostream>
-#include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace utils {
 
 namespace detail {
-    inline std::mutex& log_mutex() {
-        static std::mutex mtx;
-        return mtx;
-    }
-
-    enum class log_level { info, warn, error, debug };
+    enum class log_level : uint8_t { info, warn, error, debug };
 
     constexpr const char* level_str(log_level level) {
         switch (level) {
@@ -35,37 +37,363 @@ namespace detail {
     }
     constexpr const char* reset_code() { return "\033[0m"; }
 
-    inline std::string timestamp() {
-        char buf[20];
-        std::time_t t = std::time(nullptr);
-        std::tm tm;
-#if defined(_WIN32)
-        localtime_s(&tm, &t);
+    inline std::atomic<bool>& debug_enabled_flag() {
+        // default based on compile-time flag; can be overridden at runtime via set_debug_logging
+#if defined(UTILS_DEBUG_LOGGING) && (UTILS_DEBUG_LOGGING==0)
+        static std::atomic<bool> enabled{false};
 #else
-        localtime_r(&t, &tm);
+        static std::atomic<bool> enabled{true};
 #endif
-        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
-        return buf;
+        return enabled;
     }
 
-    inline bool& debug_enabled_flag() {
-        // default based on compile-time flag; can be overridden at runtime via set_debug_logging
-#if defined(UTILS_DEBUG_LOGGING) && (UTILS_DEBUG_LOGGING==0)
-        static bool enabled = false;
+    uint64_t hash_message(log_level level, const char* text, size_t length) {
+        uint64_t h = 1469598103934665603ull ^ static_cast<uint64_t>(level); // fnv-1a
+        for (size_t i = 0; i < length; ++i) h = (h ^ static_cast<unsigned char>(text[i])) * 1099511628211ull;
+        return h | 1; // 0 means no message yet
+    }
+
+    // rate limit and dedup state of one call site. updated by every thread
+    // logging from the site with plain atomics: under contention a count can
+    // land in the neighbouring window, which is fine for limiting noise
+    struct log_site {
+        std::atomic<const char*> fmt{nullptr};
+        std::atomic<int64_t> window{0}; // second the count belongs to
+        std::atomic<uint32_t> in_window{0};
+        std::atomic<uint32_t> suppressed{0};
+        std::atomic<uint64_t> last_hash{0};
+        std::atomic<uint32_t> repeats{0};
+        std::atomic<log_level> last_level{log_level::info};
+    };
+
+    // one formatted message. slots cycle through the ring; sequence tells
+    // producers and the consumer whose turn a slot is (bounded mpmc queue
+    // after d. vyukov, with the single consumer being the sink thread)
+    struct log_record {
+        std::atomic<uint64_t> sequence{0};
+        std::time_t time = 0;
+        log_level level = log_level::info;
+        uint32_t length = 0;
+        char text[1024];
+    };
+
+    class async_logger {
+    public:
+        static constexpr size_t CAPACITY = 1024; // power of two
+        static constexpr size_t SITES = 1024;    // power of two; sites past it are not limited
+
+        // never destroyed: code running in static destructors may still log.
+        // the sink thread is stopped at exit, after which messages are written
+        // on the calling thread
+        static async_logger& shared() {
+            static async_logger* logger = [] {
+                auto* l = new async_logger();
+                std::atexit([] { shared().stop(); });
+                return l;
+            }();
+            return *logger;
+        }
+
+        void log(log_level level, const char* fmt, va_list args);
+        void flush();
+        void stop();
+        bool set_file(const std::string& path, size_t max_bytes, int keep);
+
+        std::atomic<uint32_t> rate_limit{20};
+        std::atomic<bool> dedup{true};
+        std::atomic<bool> async{true};
+        std::atomic<uint64_t> dropped{0};
+
+    private:
+        async_logger();
+        log_site* site(const char* fmt);
+        bool push(log_level level, std::time_t time, const char* text, size_t length);
+        void push_note(log_level level, std::time_t time, const char* fmt, ...);
+        void emit(log_level level, std::time_t time, const char* text, size_t length);
+        void note_repeats(log_site& s, std::time_t time);
+        void run();
+        void drain();
+        void sweep(std::time_t time, bool all);
+
+        std::unique_ptr<log_record[]> _ring{new log_record[CAPACITY]};
+        std::unique_ptr<log_site[]> _sites{new log_site[SITES]};
+        alignas(64) std::atomic<uint64_t> _enqueue{0};
+        alignas(64) uint64_t _dequeue = 0; // sink thread only
+        std::atomic<uint64_t> _done{0};    // records consumed, for flush
+
+        std::thread _thread;
+        std::mutex _wake_mutex;
+        std::condition_variable _wake;
+        std::atomic<bool> _sleeping{false};
+        std::atomic<bool> _running{false};
+        bool _stop = false;
+        std::condition_variable _flushed;
+
+        // output, taken by the sink and by synchronous writes only
+        std::mutex _write_mutex;
+        FILE* _file = nullptr;
+        std::string _file_path;
+        size_t _file_bytes = 0, _max_file_bytes = 0;
+        int _keep = 0;
+        std::time_t _stamp_time = -1;
+        char _stamp[20] = {};
+        uint64_t _dropped_reported = 0;
+    };
+
+    async_logger::async_logger() {
+        for (size_t i = 0; i < CAPACITY; ++i) _ring[i].sequence.store(i, std::memory_order_relaxed);
+        _running = true;
+        _thread = std::thread([this] { run(); });
+    }
+
+    log_site* async_logger::site(const char* fmt) {
+        size_t i = static_cast<size_t>((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(fmt)) >> 3) * 0x9E3779B97F4A7C15ull >> 54);
+        for (size_t probe = 0; probe < 16; ++probe, ++i) {
+            log_site& s = _sites[i & (SITES - 1)];
+            const char* key = s.fmt.load(std::memory_order_acquire);
+            if (key == fmt) return &s;
+            if (!key && s.fmt.compare_exchange_strong(key, fmt, std::memory_order_acq_rel)) return &s;
+            if (key == fmt) return &s;
+        }
+        return nullptr;
+    }
+
+    void async_logger::log(log_level level, const char* fmt, va_list args) {
+        const std::time_t now = std::time(nullptr);
+        log_site* s = site(fmt);
+
+        // over the limit: counted, not even formatted
+        uint32_t suppressed = 0;
+        if (s) {
+            int64_t window = s->window.load(std::memory_order_relaxed);
+            if (window != now && s->window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+                s->in_window.store(0, std::memory_order_relaxed);
+                suppressed = s->suppressed.exchange(0, std::memory_order_relaxed);
+            }
+            const uint32_t limit = rate_limit.load(std::memory_order_relaxed);
+            if (limit && s->in_window.load(std::memory_order_relaxed) >= limit) {
+                s->suppressed.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        char msg[sizeof(log_record::text)];
+        const int n = std::vsnprintf(msg, sizeof(msg), fmt, args);
+        if (n < 0) return;
+        const size_t length = std::min(static_cast<size_t>(n), sizeof(msg) - 1);
+
+        if (s) {
+            const uint64_t h = hash_message(level, msg, length);
+            if (s->last_hash.exchange(h, std::memory_order_relaxed) == h && dedup.load(std::memory_order_relaxed)) {
+                s->repeats.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            // only what gets written counts against the limit, not folded repeats
+            s->in_window.fetch_add(1, std::memory_order_relaxed);
+            note_repeats(*s, now);
+            s->last_level.store(level, std::memory_order_relaxed);
+            if (suppressed) push_note(log_level::warn, now, "%u more messages like \"%s\" suppressed", suppressed, fmt);
+        }
+        if (!push(level, now, msg, length)) dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void async_logger::note_repeats(log_site& s, std::time_t time) {
+        if (const uint32_t repeats = s.repeats.exchange(0, std::memory_order_relaxed)) {
+            push_note(s.last_level.load(std::memory_order_relaxed), time, "(previous message repeated %u times)", repeats);
+        }
+    }
+
+    void async_logger::push_note(log_level level, std::time_t time, const char* fmt, ...) {
+        char msg[256];
+        va_list args;
+        va_start(args, fmt);
+        const int n = std::vsnprintf(msg, sizeof(msg), fmt, args);
+        va_end(args);
+        if (n < 0) return;
+        if (!push(level, time, msg, std::min(static_cast<size_t>(n), sizeof(msg) - 1))) dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool async_logger::push(log_level level, std::time_t time, const char* text, size_t length) {
+        if (!async.load(std::memory_order_relaxed) || !_running.load(std::memory_order_acquire)) {
+            emit(level, time, text, length);
+            std::fflush(stdout);
+            std::lock_guard<std::mutex> lock(_write_mutex);
+            if (_file) std::fflush(_file);
+            return true;
+        }
+        uint64_t pos = _enqueue.load(std::memory_order_relaxed);
+        log_record* slot;
+        for (;;) {
+            slot = &_ring[pos & (CAPACITY - 1)];
+            const uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (seq < pos) {
+                return false; // full: the sink is a whole ring behind
+            } else {
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        slot->time = time;
+        slot->level = level;
+        slot->length = static_cast<uint32_t>(length);
+        std::memcpy(slot->text, text, length);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        if (_sleeping.load(std::memory_order_relaxed)) _wake.notify_one();
+        return true;
+    }
+
+    void async_logger::emit(log_level level, std::time_t time, const char* text, size_t length) {
+        std::lock_guard<std::mutex> lock(_write_mutex);
+        if (time != _stamp_time) {
+            std::tm tm;
+#if defined(_WIN32)
+            localtime_s(&tm, &time);
 #else
-        static bool enabled = true;
+            localtime_r(&time, &tm);
 #endif
-        return enabled;
+            std::strftime(_stamp, sizeof(_stamp), "%Y-%m-%d %H:%M:%S", &tm);
+            _stamp_time = time;
+        }
+        std::fprintf(stdout, "[%s] %s[%s]%s %.*s\n", _stamp, color_code(level), level_str(level), reset_code(),
+                     static_cast<int>(length), text);
+        if (!_file) return;
+        const int n = std::fprintf(_file, "[%s] [%s] %.*s\n", _stamp, level_str(level), static_cast<int>(length), text);
+        if (n > 0) _file_bytes += n;
+        if (_max_file_bytes && _file_bytes >= _max_file_bytes) {
+            // path -> path.1 -> ... -> path.<keep>, the oldest is overwritten
+            std::fclose(_file);
+            for (int i = _keep; i > 0; --i) {
+                const std::string from = i > 1 ? _file_path + "." + std::to_string(i - 1) : _file_path;
+                const std::string to = _file_path + "." + std::to_string(i);
+                std::remove(to.c_str());
+                std::rename(from.c_str(), to.c_str());
+            }
+            _file = std::fopen(_file_path.c_str(), "wb");
+            _file_bytes = 0;
+        }
+    }
+
+    void async_logger::drain() {
+        for (;;) {
+            log_record& slot = _ring[_dequeue & (CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != _dequeue + 1) break;
+            emit(slot.level, slot.time, slot.text, slot.length);
+            slot.sequence.store(_dequeue + CAPACITY, std::memory_order_release);
+            ++_dequeue;
+        }
+        const uint64_t lost = dropped.load(std::memory_order_relaxed);
+        if (lost != _dropped_reported) {
+            char msg[96];
+            const int n = std::snprintf(msg, sizeof(msg), "log queue full, %llu messages dropped",
+                                        static_cast<unsigned long long>(lost - _dropped_reported));
+            emit(log_level::warn, std::time(nullptr), msg, static_cast<size_t>(n));
+            _dropped_reported = lost;
+        }
+        std::fflush(stdout);
+        {
+            std::lock_guard<std::mutex> lock(_write_mutex);
+            if (_file) std::fflush(_file);
+        }
+        _done.store(_dequeue, std::memory_order_release);
+    }
+
+    // repeats of a site that went quiet would otherwise wait for its next message.
+    // all also reports suppression counts of the current second (flush, exit)
+    void async_logger::sweep(std::time_t time, bool all) {
+        for (size_t i = 0; i < SITES; ++i) {
+            log_site& s = _sites[i];
+            if (!s.fmt.load(std::memory_order_relaxed)) continue;
+            if (s.repeats.load(std::memory_order_relaxed)) {
+                note_repeats(s, time);
+                s.last_hash.store(0, std::memory_order_relaxed); // the next one is shown again
+            }
+            if (all || s.window.load(std::memory_order_relaxed) != time) {
+                if (const uint32_t suppressed = s.suppressed.exchange(0, std::memory_order_relaxed)) {
+                    push_note(log_level::warn, time, "%u more messages like \"%s\" suppressed", suppressed, s.fmt.load());
+                }
+            }
+        }
+    }
+
+    void async_logger::run() {
+        std::time_t swept = std::time(nullptr);
+        for (;;) {
+            drain();
+            const std::time_t now = std::time(nullptr);
+            if (now != swept) {
+                sweep(now, false);
+                swept = now;
+                drain();
+            }
+            std::unique_lock<std::mutex> lock(_wake_mutex);
+            // under the mutex, so a flush between its check and its wait hears it
+            _flushed.notify_all();
+            if (_stop) break;
+            // producers only notify while this is set; a wakeup lost between
+            // the check and the wait costs at most the timeout
+            _sleeping.store(true, std::memory_order_relaxed);
+            const uint64_t next = _dequeue;
+            _wake.wait_for(lock, std::chrono::milliseconds(50), [&] {
+                return _stop || _ring[next & (CAPACITY - 1)].sequence.load(std::memory_order_acquire) == next + 1;
+            });
+            _sleeping.store(false, std::memory_order_relaxed);
+        }
+        sweep(std::time(nullptr), true);
+        drain();
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _flushed.notify_all();
+    }
+
+    void async_logger::flush() {
+        if (!_running.load(std::memory_order_acquire)) return;
+        // pending repeat and suppression counts first, so they are part of what gets written
+        sweep(std::time(nullptr), true);
+        const uint64_t target = _enqueue.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        _wake.notify_one();
+        _flushed.wait(lock, [&] { return _done.load(std::memory_order_acquire) >= target || _stop; });
+    }
+
+    void async_logger::stop() {
+        {
+            std::lock_guard<std::mutex> lock(_wake_mutex);
+            if (_stop) return;
+            _stop = true;
+        }
+        _wake.notify_one();
+        if (_thread.joinable()) _thread.join();
+        // later messages (static destructors) are written synchronously;
+        // whatever other threads queued meanwhile goes out here
+        _running.store(false, std::memory_order_release);
+        drain();
+        std::lock_guard<std::mutex> lock(_write_mutex);
+        if (_file) {
+            std::fclose(_file);
+            _file = nullptr;
+        }
+    }
+
+    bool async_logger::set_file(const std::string& path, size_t max_bytes, int keep) {
+        flush();
+        std::lock_guard<std::mutex> lock(_write_mutex);
+        if (_file) std::fclose(_file);
+        _file = nullptr;
+        _file_path = path;
+        _max_file_bytes = max_bytes;
+        _keep = keep > 0 ? keep : 0;
+        _file_bytes = 0;
+        if (path.empty()) return true;
+        _file = std::fopen(path.c_str(), "ab");
+        if (!_file) return false;
+        std::fseek(_file, 0, SEEK_END);
+        _file_bytes = static_cast<size_t>(std::max(0L, std::ftell(_file)));
+        return true;
     }
 
     void vlog(log_level level, const char* fmt, va_list args) {
-        if (level == log_level::debug && !debug_enabled_flag()) return;
-        std::lock_guard<std::mutex> lock(log_mutex());
-        char msg[1024];
-        std::vsnprintf(msg, sizeof(msg), fmt, args);
-        std::cout << "[" << timestamp() << "] "
-                  << color_code(level) << "[" << level_str(level) << "]" << reset_code()
-                  << " " << msg << std::endl;
+        if (level == log_level::debug && !debug_enabled_flag().load(std::memory_order_relaxed)) return;
+        async_logger::shared().log(level, fmt, args);
     }
 }
 
@@ -98,12 +426,37 @@ void log_debug(const char* fmt, ...) {
 }
 
 void set_debug_logging(bool enabled) {
-    detail::debug_enabled_flag() = enabled;
+    detail::debug_enabled_flag().store(enabled, std::memory_order_relaxed);
 }
 
 bool is_debug_logging() {
-    return detail::debug_enabled_flag();
+    return detail::debug_enabled_flag().load(std::memory_order_relaxed);
+}
+
+bool set_log_file(const std::string& path, size_t max_bytes, int keep) {
+    return detail::async_logger::shared().set_file(path, max_bytes, keep);
 }
 
-} // namespace utils 
+void set_log_rate_limit(uint32_t per_second) {
+    detail::async_logger::shared().rate_limit.store(per_second, std::memory_order_relaxed);
+}
+
+void set_log_dedup(bool enabled) {
+    detail::async_logger::shared().dedup.store(enabled, std::memory_order_relaxed);
+}
+
+void set_log_async(bool enabled) {
+    auto& logger = detail::async_logger::shared();
+    if (!enabled) logger.flush(); // queued messages stay ahead of synchronous ones
+    logger.async.store(enabled, std::memory_order_relaxed);
+}
+
+void flush_log() {
+    detail::async_logger::shared().flush();
+}
+
+uint64_t dropped_log_messages() {
+    return detail::async_logger::shared().dropped.load(std::memory_order_relaxed);
+}
 
+} // namespace utils
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace utils {
 
 // printf-style logging: log_info("value: %d, %s", 42, "foo");
+// messages are formatted on the calling thread into a lock-free queue and
+// written by a background thread, so logging never waits on console or file
+// i/o. a full queue drops the message (counted, see dropped_log_messages)
 void log_info(const char* fmt, ...);
 void log_warn(const char* fmt, ...);
 void log_error(const char* fmt, ...);
@@ -14,4 +20,24 @@ void log_debug(const char* fmt, ...);
 void set_debug_logging(bool enabled);
 bool is_debug_logging();
 
-} // namespace utils 
\ No newline at end of file
+// copy of the console output in a file, rotated to path.1 .. path.<keep>
+// once it grows past max_bytes. an empty path closes it
+bool set_log_file(const std::string& path, size_t max_bytes = 8u << 20, int keep = 3);
+
+// call sites are told apart by their format string. a site logging more than
+// per_second messages a second has the rest counted and reported in one line;
+// 0 turns the limit off (default 20)
+void set_log_rate_limit(uint32_t per_second);
+// a site repeating its last message word for word logs it once, followed by
+// "repeated N times" (on its next different message, or within a second)
+void set_log_dedup(bool enabled);
+
+// false writes each message on the calling thread before returning, e.g.
+// while chasing a crash. on by default
+void set_log_async(bool enabled);
+// blocks until everything logged so far is written; not for frame threads
+void flush_log();
+// messages lost because the queue was full
+uint64_t dropped_log_messages();
+
+} // namespace utils
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace utils {
+
+// unbounded multi-producer, single-consumer queue (vyukov's node-based one).
+// push is one atomic exchange and never waits on the consumer or on other
+// producers; pop is for one thread at a time. a push whose exchange landed
+// but whose link is not stored yet is seen by the next pop after the link
+// is stored, so a drain can end just short of it
+template <typename T>
+class mpsc_queue {
+public:
+    mpsc_queue() : _head(new node), _tail(_head.load(std::memory_order_relaxed)) {}
+    ~mpsc_queue() {
+        while (pop()) {}
+        delete _tail;
+    }
+
+    mpsc_queue(const mpsc_queue&) = delete;
+    mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+    void push(T value) {
+        node* n = new node;
+        n->value.emplace(std::move(value));
+        node* prev = _head.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    // consumer only
+    std::optional<T> pop() {
+        node* next = _tail->next.load(std::memory_order_acquire);
+        if (!next) return std::nullopt;
+        std::optional<T> value = std::move(next->value);
+        next->value.reset(); // next is the new stub
+        delete _tail;
+        _tail = next;
+        return value;
+    }
+
+    // consumer only; a snapshot that producers may outdate right away
+    bool empty() const { return !_tail->next.load(std::memory_order_acquire); }
+
+private:
+    struct node {
+        std::atomic<node*> next{nullptr};
+        std::optional<T> value;
+    };
+
+    std::atomic<node*> _head; // last pushed, producers
+    node* _tail;              // stub before the oldest, consumer
+};
+
+} // namespace utils
@@ -0,0 +1,244 @@
+#include "profiler.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+#include <unordered_map>
+
+namespace utils {
+
+namespace detail {
+// written by its thread (head) and drained by end_frame (tail); single
+// producer, single consumer, so both sides only need acquire/release
+struct profile_thread {
+    static constexpr size_t CAPACITY = 8192; // events between two end_frame calls
+    std::unique_ptr<profiler::event[]> ring{new profiler::event[CAPACITY]};
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> alive{true}; // cleared on thread exit, the ring goes once drained
+    uint32_t index = 0;
+    uint32_t depth = 0; // owner only
+};
+} // namespace detail
+
+namespace {
+const auto g_epoch = std::chrono::steady_clock::now();
+
+struct thread_handle {
+    std::shared_ptr<detail::profile_thread> thread;
+    ~thread_handle() {
+        if (thread) thread->alive.store(false, std::memory_order_release);
+    }
+};
+thread_local thread_handle t_thread;
+
+void write_escaped(FILE* out, std::string_view text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', out);
+            std::fputc(c, out);
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            std::fputc(c, out);
+        }
+    }
+}
+} // namespace
+
+profiler& profiler::shared() {
+    static profiler instance;
+    return instance;
+}
+
+uint64_t profiler::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+detail::profile_thread& profiler::local_thread() {
+    if (!t_thread.thread) {
+        auto thread = std::make_shared<detail::profile_thread>();
+        profiler& p = shared();
+        std::lock_guard<std::mutex> lock(p._mutex);
+        thread->index = static_cast<uint32_t>(p._thread_names.size());
+        p._thread_names.emplace_back();
+        p._threads.push_back(thread);
+        t_thread.thread = std::move(thread);
+    }
+    return *t_thread.thread;
+}
+
+uint64_t profiler::begin_scope() {
+    ++local_thread().depth;
+    return now_ns();
+}
+
+void profiler::end_scope(const char* name, uint64_t start_ns) {
+    const uint64_t end = now_ns();
+    detail::profile_thread& t = local_thread();
+    const uint32_t depth = --t.depth;
+    const uint64_t head = t.head.load(std::memory_order_relaxed);
+    if (head - t.tail.load(std::memory_order_acquire) >= detail::profile_thread::CAPACITY) {
+        shared()._dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    t.ring[head % detail::profile_thread::CAPACITY] = {name, start_ns, end, t.index, depth};
+    t.head.store(head + 1, std::memory_order_release);
+}
+
+void profiler::set_enabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // the first frame starts now rather than when the process did
+    if (enabled && !this->enabled()) _frame_start = now_ns();
+    detail::profiling_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void profiler::set_frame_window(size_t frames) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _window = std::max<size_t>(frames, 1);
+    while (_frames.size() > _window) _frames.pop_front();
+}
+
+size_t profiler::frame_window() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _window;
+}
+
+void profiler::end_frame() {
+    if (!enabled()) return;
+    const uint64_t now = now_ns();
+    std::lock_guard<std::mutex> lock(_mutex);
+    // the oldest frame's vector is reused
+    frame next;
+    if (_frames.size() >= _window) {
+        next = std::move(_frames.front());
+        _frames.pop_front();
+        next.events.clear();
+    }
+    next.number = _frame_number++;
+    next.start_ns = _frame_start;
+    next.end_ns = now;
+    _frame_start = now;
+
+    for (const auto& thread : _threads) {
+        const uint64_t head = thread->head.load(std::memory_order_acquire);
+        for (uint64_t i = thread->tail.load(std::memory_order_relaxed); i < head; ++i) {
+            next.events.push_back(thread->ring[i % detail::profile_thread::CAPACITY]);
+        }
+        thread->tail.store(head, std::memory_order_release);
+    }
+    // threads that exited wrote their last events before clearing alive
+    std::erase_if(_threads, [](const auto& thread) {
+        return !thread->alive.load(std::memory_order_acquire) &&
+               thread->tail.load(std::memory_order_relaxed) == thread->head.load(std::memory_order_acquire);
+    });
+    std::sort(next.events.begin(), next.events.end(), [](const event& a, const event& b) {
+        return a.start_ns != b.start_ns ? a.start_ns < b.start_ns : a.depth < b.depth;
+    });
+    _frames.push_back(std::move(next));
+}
+
+size_t profiler::frame_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _frames.size();
+}
+
+profiler::frame profiler::get_frame(size_t back) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (back >= _frames.size()) return {};
+    return _frames[_frames.size() - 1 - back];
+}
+
+std::vector<profiler::scope_stats> profiler::frame_scopes(size_t back) const {
+    const frame f = get_frame(back);
+
+    // self time: each event's duration minus its direct children's, found
+    // with a stack of open scopes per thread (events are in start order)
+    std::vector<uint64_t> self(f.events.size());
+    std::unordered_map<uint32_t, std::vector<size_t>> open;
+    for (size_t i = 0; i < f.events.size(); ++i) {
+        const event& e = f.events[i];
+        self[i] = e.end_ns - e.start_ns;
+        auto& stack = open[e.thread];
+        while (!stack.empty() && (f.events[stack.back()].depth >= e.depth || f.events[stack.back()].end_ns <= e.start_ns)) {
+            stack.pop_back();
+        }
+        if (!stack.empty() && f.events[stack.back()].depth + 1 == e.depth) {
+            uint64_t& parent = self[stack.back()];
+            parent -= std::min(parent, self[i]);
+        }
+        stack.push_back(i);
+    }
+    // children come after their parent, so a parent's self is final only now
+    std::unordered_map<std::string_view, scope_stats> by_name;
+    for (size_t i = 0; i < f.events.size(); ++i) {
+        const event& e = f.events[i];
+        auto& stats = by_name[e.name];
+        const uint64_t duration = e.end_ns - e.start_ns;
+        stats.name = e.name;
+        ++stats.calls;
+        stats.total_ns += duration;
+        stats.self_ns += self[i];
+        stats.max_ns = std::max(stats.max_ns, duration);
+    }
+
+    std::vector<scope_stats> out;
+    out.reserve(by_name.size());
+    for (const auto& [name, stats] : by_name) out.push_back(stats);
+    std::sort(out.begin(), out.end(), [](const scope_stats& a, const scope_stats& b) { return a.total_ns > b.total_ns; });
+    return out;
+}
+
+bool profiler::export_chrome_trace(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) {
+        utils::log_error("profiler: cannot write trace '%s'", path.c_str());
+        return false;
+    }
+    // timestamps in microseconds; frames on tid 0, threads from 1
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"frames\"}}");
+    for (size_t i = 0; i < _thread_names.size(); ++i) {
+        std::fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"", i + 1);
+        if (_thread_names[i].empty()) {
+            std::fprintf(out, "thread %zu", i);
+        } else {
+            write_escaped(out, _thread_names[i]);
+        }
+        std::fprintf(out, "\"}}");
+    }
+    size_t events = 0;
+    for (const auto& f : _frames) {
+        std::fprintf(out, ",\n{\"name\":\"frame %llu\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":0}",
+                     static_cast<unsigned long long>(f.number), f.start_ns / 1e3, (f.end_ns - f.start_ns) / 1e3);
+        for (const auto& e : f.events) {
+            std::fprintf(out, ",\n{\"name\":\"");
+            write_escaped(out, e.name);
+            std::fprintf(out, "\",\"cat\":\"frameview\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                         e.start_ns / 1e3, (e.end_ns - e.start_ns) / 1e3, e.thread + 1);
+        }
+        events += f.events.size();
+    }
+    std::fprintf(out, "\n]}\n");
+    const bool ok = std::fclose(out) == 0;
+    if (ok) utils::log_info("profiler: wrote %zu events of %zu frames to %s", events, _frames.size(), path.c_str());
+    return ok;
+}
+
+void profiler::set_thread_name(const std::string& name) {
+    const uint32_t index = local_thread().index;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _thread_names[index] = name;
+}
+
+void profiler::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frames.clear();
+    for (const auto& thread : _threads) {
+        thread->tail.store(thread->head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+    _frame_start = now_ns();
+    _dropped.store(0, std::memory_order_relaxed);
+}
+
+} // namespace utils
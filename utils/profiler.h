@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// scoped cpu timers: FV_PROFILE_SCOPE("text") times the rest of the block.
+// compiled in unless UTILS_PROFILING is 0 (release builds, see CMakeLists.txt),
+// in which case the macros expand to nothing. compiled in, they cost one
+// relaxed load while profiling is off (the default, see profiler::set_enabled)
+#ifndef UTILS_PROFILING
+#define UTILS_PROFILING 1
+#endif
+
+#if UTILS_PROFILING
+#define FV_PROFILE_CONCAT_(a, b) a##b
+#define FV_PROFILE_CONCAT(a, b) FV_PROFILE_CONCAT_(a, b)
+// name must outlive the profiler: a string literal
+#define FV_PROFILE_SCOPE(name) ::utils::profile_scope FV_PROFILE_CONCAT(fv_profile_scope_, __LINE__)(name)
+#define FV_PROFILE_FUNCTION() FV_PROFILE_SCOPE(__func__)
+// ends the profiler's frame; renderers call it from end_frame
+#define FV_PROFILE_FRAME() ::utils::profiler::shared().end_frame()
+#else
+#define FV_PROFILE_SCOPE(name) ((void)0)
+#define FV_PROFILE_FUNCTION() ((void)0)
+#define FV_PROFILE_FRAME() ((void)0)
+#endif
+
+namespace utils {
+
+namespace detail {
+inline std::atomic<bool> profiling_enabled{false};
+struct profile_thread;
+} // namespace detail
+
+// collects the scopes timed on every thread. each thread writes its events
+// into its own ring, without locks; end_frame moves them into a ring of the
+// last N frames, which can be summarized or exported as a chrome trace
+// (chrome://tracing, ui.perfetto.dev)
+class profiler {
+public:
+    struct event {
+        const char* name = nullptr;
+        uint64_t start_ns = 0, end_ns = 0; // since the profiler started
+        uint32_t thread = 0;               // profiler thread index, 0 is the first thread seen
+        uint32_t depth = 0;                // scopes open around it on its thread
+    };
+
+    // one name's time in a frame; self excludes the scopes nested inside
+    struct scope_stats {
+        const char* name = nullptr;
+        uint32_t calls = 0;
+        uint64_t total_ns = 0, self_ns = 0, max_ns = 0;
+    };
+
+    struct frame {
+        uint64_t number = 0;
+        uint64_t start_ns = 0, end_ns = 0;
+        std::vector<event> events; // by start time
+    };
+
+    static profiler& shared();
+
+    void set_enabled(bool enabled);
+    bool enabled() const { return detail::profiling_enabled.load(std::memory_order_relaxed); }
+
+    // frames kept, oldest dropped first
+    void set_frame_window(size_t frames);
+    size_t frame_window() const;
+
+    // closes the current frame with every event finished so far, on any thread
+    void end_frame();
+
+    size_t frame_count() const;
+    // back = 0 is the last finished frame; empty frame when out of range
+    frame get_frame(size_t back = 0) const;
+    // per name, busiest first
+    std::vector<scope_stats> frame_scopes(size_t back = 0) const;
+    // events lost because a thread's ring was full between two end_frame calls
+    uint64_t dropped_events() const { return _dropped.load(std::memory_order_relaxed); }
+
+    // chrome trace_event json of the frames kept: one complete ("X") event per
+    // scope, frames on their own row, named threads
+    bool export_chrome_trace(const std::string& path) const;
+
+    // shown in the trace for the calling thread
+    void set_thread_name(const std::string& name);
+
+    void clear();
+
+    // profile_scope's halves
+    static uint64_t begin_scope();
+    static void end_scope(const char* name, uint64_t start_ns);
+
+    static uint64_t now_ns();
+
+private:
+    profiler() = default;
+    // the calling thread's ring, registered on first use
+    static detail::profile_thread& local_thread();
+
+    mutable std::mutex _mutex; // threads, names and frames; never taken while timing a scope
+    std::vector<std::shared_ptr<detail::profile_thread>> _threads;
+    std::vector<std::string> _thread_names; // by thread index
+    std::deque<frame> _frames;
+    size_t _window = 120;
+    uint64_t _frame_number = 0;
+    uint64_t _frame_start = 0;
+    std::atomic<uint64_t> _dropped{0};
+};
+
+class profile_scope {
+public:
+    explicit profile_scope(const char* name) {
+        if (detail::profiling_enabled.load(std::memory_order_relaxed)) {
+            _name = name;
+            _start = profiler::begin_scope();
+        }
+    }
+    ~profile_scope() {
+        if (_name) profiler::end_scope(_name, _start);
+    }
+    profile_scope(const profile_scope&) = delete;
+    profile_scope& operator=(const profile_scope&) = delete;
+
+private:
+    const char* _name = nullptr;
+    uint64_t _start = 0;
+};
+
+} // namespace utils
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+// dense storage addressed by generational handles: insert and erase are O(1),
+// erased slots are reused, and a handle to an erased value is detected as
+// stale instead of silently reaching whatever took its slot.
+// a handle is the slot index in the low 32 bits and the slot's generation in
+// the high 32. values stay in place until erased, but pointers to them are
+// invalidated by an insert that grows the storage
+template <typename T>
+class slot_map {
+public:
+    using handle = uint64_t;
+    static constexpr handle null = ~handle(0);
+
+    template <typename... Args>
+    handle emplace(Args&&... args) {
+        uint32_t index;
+        if (_free != NONE) {
+            index = _free;
+            _free = _slots[index].next_free;
+        } else {
+            index = static_cast<uint32_t>(_slots.size());
+            _slots.emplace_back();
+        }
+        slot& s = _slots[index];
+        s.value.emplace(std::forward<Args>(args)...);
+        ++_size;
+        return make_handle(index, s.generation);
+    }
+
+    handle insert(T value) { return emplace(std::move(value)); }
+
+    // false for a stale or null handle
+    bool erase(handle h) {
+        slot* s = find(h);
+        if (!s) return false;
+        s->value.reset();
+        // the old handle stops matching; 0 and ~0 are never handed out
+        if (++s->generation == NONE) s->generation = 1;
+        s->next_free = _free;
+        _free = index_of(h);
+        --_size;
+        return true;
+    }
+
+    T* get(handle h) {
+        slot* s = find(h);
+        return s ? &*s->value : nullptr;
+    }
+    const T* get(handle h) const { return const_cast<slot_map*>(this)->get(h); }
+    bool contains(handle h) const { return get(h) != nullptr; }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    void clear() {
+        for (uint32_t i = 0; i < _slots.size(); ++i) {
+            if (_slots[i].value) erase(make_handle(i, _slots[i].generation));
+        }
+    }
+
+    // f(handle, T&) for every live value, in slot order
+    template <typename F>
+    void for_each(F&& f) {
+        for (uint32_t i = 0; i < _slots.size(); ++i) {
+            if (_slots[i].value) f(make_handle(i, _slots[i].generation), *_slots[i].value);
+        }
+    }
+
+private:
+    static constexpr uint32_t NONE = ~uint32_t(0);
+
+    struct slot {
+        std::optional<T> value;
+        uint32_t generation = 1;
+        uint32_t next_free = NONE;
+    };
+
+    static handle make_handle(uint32_t index, uint32_t generation) { return (static_cast<handle>(generation) << 32) | index; }
+    static uint32_t index_of(handle h) { return static_cast<uint32_t>(h); }
+
+    slot* find(handle h) {
+        const uint32_t index = index_of(h);
+        if (index >= _slots.size()) return nullptr;
+        slot& s = _slots[index];
+        if (!s.value || s.generation != static_cast<uint32_t>(h >> 32)) return nullptr;
+        return &s;
+    }
+
+    std::vector<slot> _slots;
+    uint32_t _free = NONE;
+    size_t _size = 0;
+};
+
+} // namespace utils
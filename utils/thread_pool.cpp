@@ -0,0 +1,85 @@
+#include "thread_pool.h"
+#include "logger.h"
+#include <exception>
+
+namespace utils {
+
+namespace {
+thread_local const thread_pool* t_current_pool = nullptr;
+}
+
+thread_pool::thread_pool(size_t threads) {
+    if (threads == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        threads = hw > 1 ? hw - 1 : 1;
+    }
+    _workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        _workers.emplace_back([this]() { worker(); });
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (auto& t : _workers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void thread_pool::submit(std::function<void()> task) {
+    if (!task) return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _wake.notify_one();
+}
+
+void thread_pool::wait_idle() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this]() { return _tasks.empty() && _running == 0; });
+}
+
+bool thread_pool::in_worker() const {
+    return t_current_pool == this;
+}
+
+thread_pool& thread_pool::shared() {
+    static thread_pool pool;
+    return pool;
+}
+
+void thread_pool::worker() {
+    t_current_pool = this;
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+            if (_tasks.empty()) return; // stopping and drained
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+            ++_running;
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            log_error("thread_pool: task threw: %s", e.what());
+        } catch (...) {
+            log_error("thread_pool: task threw an unknown exception");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --_running;
+            if (_tasks.empty() && _running == 0) _idle.notify_all();
+        }
+    }
+}
+
+} // namespace utils
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+
+// fixed set of worker threads running queued tasks in fifo order.
+// the destructor finishes everything already queued before joining
+class thread_pool {
+public:
+    explicit thread_pool(size_t threads = 0); // 0: hardware threads - 1, at least 1
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // run f on a worker and get its result (or exception) through a future
+    template <typename F>
+    auto async(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using result = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<result()>>(std::forward<F>(f));
+        auto future = task->get_future();
+        submit([task]() { (*task)(); });
+        return future;
+    }
+
+    // block until the queue is empty and no task is running
+    void wait_idle();
+
+    size_t size() const { return _workers.size(); }
+
+    // true on one of this pool's workers; waiting on its own futures there can deadlock
+    bool in_worker() const;
+
+    // process-wide pool for background resource work (glyphs, font loading)
+    static thread_pool& shared();
+
+private:
+    void worker();
+
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    size_t _running = 0;
+    bool _stopping = false;
+};
+
+} // namespace utils
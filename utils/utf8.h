@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+// decode one utf-8 sequence at ptr. returns the bytes consumed (1-4), or 0
+// for an invalid/truncated sequence, in which case callers skip one byte
+inline int decode_utf8(const char* ptr, const char* end, uint32_t& codepoint) {
+    if (ptr >= end) return 0;
+    const unsigned char c = static_cast<unsigned char>(*ptr);
+    int length = 0;
+    if ((c & 0x80) == 0) {
+        codepoint = c;
+        return 1;
+    } else if ((c & 0xE0) == 0xC0) {
+        codepoint = c & 0x1F;
+        length = 2;
+    } else if ((c & 0xF0) == 0xE0) {
+        codepoint = c & 0x0F;
+        length = 3;
+    } else if ((c & 0xF8) == 0xF0) {
+        codepoint = c & 0x07;
+        length = 4;
+    } else {
+        return 0;
+    }
+    if (end - ptr < length) return 0;
+    for (int i = 1; i < length; ++i) {
+        const unsigned char cc = static_cast<unsigned char>(ptr[i]);
+        if ((cc & 0xC0) != 0x80) return 0;
+        codepoint = (codepoint << 6) | (cc & 0x3F);
+    }
+    return length;
+}
+
+// all codepoints of a utf-8 string, invalid bytes skipped
+inline std::vector<uint32_t> decode_utf8(std::string_view text) {
+    std::vector<uint32_t> out;
+    out.reserve(text.size());
+    const char* ptr = text.data();
+    const char* end = ptr + text.size();
+    while (ptr < end) {
+        uint32_t codepoint = 0;
+        int n = decode_utf8(ptr, end, codepoint);
+        if (n == 0) {
+            ++ptr;
+            continue;
+        }
+        out.push_back(codepoint);
+        ptr += n;
+    }
+    return out;
+}
+
+} // namespace utils